@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "arena.h"
+
+static size_t alignUp(size_t value) {
+    return (value + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+int arenaInit(Arena* arena, const char* name, size_t capacity) {
+    memset(arena, 0, sizeof(Arena));
+    arena->name = name;
+    capacity = alignUp(capacity);
+    arena->base = (uint8_t*)aligned_alloc(ARENA_ALIGNMENT, capacity);
+    if (!arena->base) {
+        printf("Failed to allocate memory for %s arena\n", name);
+        return -1;
+    }
+    arena->capacity = capacity;
+    return 0;
+}
+
+void arenaFree(Arena* arena) {
+    free(arena->base);
+    memset(arena, 0, sizeof(Arena));
+}
+
+void* arenaAlloc(Arena* arena, size_t size) {
+    size_t start = alignUp(arena->used);
+    size_t end = start + alignUp(size);
+    if (end > arena->capacity) {
+        // Remember how much the frame really needed so the next reset can make room for it
+        if (end > arena->wanted) arena->wanted = end;
+        arena->failures++;
+        return NULL;
+    }
+    arena->used = end;
+    if (end > arena->peak) arena->peak = end;
+    return arena->base + start;
+}
+
+void* arenaGrow(Arena* arena, void* pointer, size_t oldSize, size_t newSize) {
+    if (!pointer) return arenaAlloc(arena, newSize);
+
+    // Last thing allocated, just move the end
+    size_t start = (uint8_t*)pointer - arena->base;
+    if (start + alignUp(oldSize) == arena->used) {
+        size_t end = start + alignUp(newSize);
+        if (end > arena->capacity) {
+            if (end > arena->wanted) arena->wanted = end;
+            arena->failures++;
+            return NULL;
+        }
+        arena->used = end;
+        if (end > arena->peak) arena->peak = end;
+        return pointer;
+    }
+
+    void* moved = arenaAlloc(arena, newSize);
+    if (moved) memcpy(moved, pointer, oldSize < newSize ? oldSize : newSize);
+    return moved;
+}
+
+char* arenaPrintf(Arena* arena, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (length < 0) return NULL;
+
+    char* text = (char*)arenaAlloc(arena, length + 1);
+    if (!text) return NULL;
+    va_start(args, format);
+    vsnprintf(text, length + 1, format, args);
+    va_end(args);
+    return text;
+}
+
+void arenaReset(Arena* arena) {
+    if (arena->peak > arena->highWater) arena->highWater = arena->peak;
+
+    // Ran out this frame, nothing is allocated right now so it's safe to swap the block out
+    if (arena->wanted > arena->capacity) {
+        size_t capacity = alignUp(arena->wanted + arena->wanted / 2);
+        uint8_t* base = (uint8_t*)aligned_alloc(ARENA_ALIGNMENT, capacity);
+        if (base) {
+            printf("%s arena grew from %zu KB to %zu KB\n", arena->name, arena->capacity / 1024, capacity / 1024);
+            free(arena->base);
+            arena->base = base;
+            arena->capacity = capacity;
+        } else {
+            printf("Failed to grow %s arena\n", arena->name);
+        }
+    }
+    arena->used = 0;
+    arena->peak = 0;
+    arena->wanted = 0;
+}
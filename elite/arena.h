@@ -0,0 +1,49 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump allocator for memory that only lives for a frame (or a tick), allocating is just moving a pointer
+// and everything gets thrown away at once with arenaReset, so there's no malloc/free traffic per frame
+// If a frame asks for more than fits the allocation fails (returns NULL) and the arena grows at the next reset
+
+#define ARENA_ALIGNMENT 16
+
+typedef struct {
+    const char* name; // For the stats
+    uint8_t* base;
+    size_t capacity;
+    size_t used;
+    size_t peak; // Most used since the last reset
+    size_t highWater; // Most used in any one frame
+    size_t wanted; // What the frame would have used if everything fit, the arena grows to this
+    uint32_t failures; // Allocations that didn't fit, ever
+} Arena;
+
+// Returns 0 on success, -1 if the memory couldn't be allocated
+int arenaInit(Arena* arena, const char* name, size_t capacity);
+void arenaFree(Arena* arena);
+
+// 16-byte aligned, uninitialised, NULL if it doesn't fit
+void* arenaAlloc(Arena* arena, size_t size);
+
+// Grows the most recent allocation in place if it can, otherwise copies it somewhere new, NULL if it doesn't fit
+void* arenaGrow(Arena* arena, void* pointer, size_t oldSize, size_t newSize);
+
+// printf into the arena, NULL if it doesn't fit
+char* arenaPrintf(Arena* arena, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+// Everything allocated after a mark can be given back early with arenaRelease, for scratch inside a loop
+static inline size_t arenaMark(const Arena* arena) {
+    return arena->used;
+}
+
+static inline void arenaRelease(Arena* arena, size_t mark) {
+    if (mark < arena->used) arena->used = mark;
+}
+
+// Frees everything, call once the frame is done with it, grows the arena if the frame ran out
+void arenaReset(Arena* arena);
+
+#endif // ARENA_H
@@ -0,0 +1,333 @@
+// Headless benchmarks for the simulation parts that don't need a window
+// Built by compile.sh, or on its own with: gcc bench.c flock.c collision.c mesh.c arena.c particles.c net.c simd.c -o bench.x86_64 -O3 -ffast-math -lm -pthread
+// ./bench.x86_64 [ticks] runs every benchmark, ticks defaults to 30 (one second of simulation)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "flock.h"
+#include "collision.h"
+#include "mesh.h"
+#include "particles.h"
+#include "net.h"
+#include "simd.h"
+#include "rng.h"
+
+#define BENCH_SEED 31415926
+#define TICK_BUDGET_MS 33.3f
+#define BENCH_WIDTH 1280 // Framebuffer the particles get splatted into
+#define BENCH_HEIGHT 720
+#define BENCH_PORT 27599 // Out of the way of a real server
+#define BENCH_INTEREST 20000.0f
+
+static double nowMs(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+// Same numbers the vipers use in the engine
+static void defaultFlockParams(FlockParams* params) {
+    memset(params, 0, sizeof(FlockParams));
+    params->neighbourRadius = 40.0f;
+    params->separationRadius = 20.0f;
+    params->separationWeight = 1.5f;
+    params->alignmentWeight = 1.0f;
+    params->cohesionWeight = 0.8f;
+    params->pursuitWeight = 1.0f;
+    params->maxSpeed = 5.0f;
+}
+
+// Agents start spread over a cube that grows with the count, so the density (and the neighbour count) stays the same
+static void benchFlock(int agents, int ticks) {
+    Flock flock = {0};
+    if (flockReserve(&flock, agents) != 0) return;
+
+    FlockParams params;
+    defaultFlockParams(&params);
+
+    Rng rng;
+    rngSeed(&rng, BENCH_SEED);
+    float side = cbrtf((float)agents) * 20.0f;
+    for (int i = 0; i < agents; i++) {
+        float position[3] = {rngRange(&rng, 0, side), rngRange(&rng, 0, side), rngRange(&rng, 0, side)};
+        float velocity[3] = {rngRange(&rng, -1, 1), rngRange(&rng, -1, 1), rngRange(&rng, -1, 1)};
+        flockAdd(&flock, position, velocity);
+    }
+    params.target[0] = params.target[1] = params.target[2] = side * 2.0f;
+
+    float (*steer)[3] = malloc((size_t)agents * sizeof(*steer));
+    if (!steer) {
+        printf("Failed to allocate memory for steering\n");
+        flockFree(&flock);
+        return;
+    }
+
+    double buildTime = 0.0, steerTime = 0.0;
+    for (int t = 0; t < ticks; t++) {
+        double start = nowMs();
+        flockBuildGrid(&flock, params.neighbourRadius);
+        double built = nowMs();
+        flockSteerRange(&flock, &params, 0, agents, NULL, steer);
+        double steered = nowMs();
+        buildTime += built - start;
+        steerTime += steered - built;
+
+        // Cheap stand-in for the engine's movement, enough to keep the flock changing between ticks
+        for (int i = 0; i < agents; i++) {
+            flock.velX[i] = (flock.velX[i] + steer[i][0] * 0.04f) * 0.95f;
+            flock.velY[i] = (flock.velY[i] + steer[i][1] * 0.04f) * 0.95f;
+            flock.velZ[i] = (flock.velZ[i] + steer[i][2] * 0.04f) * 0.95f;
+            flock.posX[i] += flock.velX[i];
+            flock.posY[i] += flock.velY[i];
+            flock.posZ[i] += flock.velZ[i];
+        }
+    }
+
+    double perTick = (buildTime + steerTime) / ticks;
+    printf("flock %7d agents: grid %8.3f ms  steer %8.3f ms  total %8.3f ms/tick  %6.1f ns/agent  %s\n",
+           agents, buildTime / ticks, steerTime / ticks, perTick, perTick * 1000000.0 / agents,
+           perTick <= TICK_BUDGET_MS ? "fits 30 Hz" : "over 30 Hz budget");
+
+    free(steer);
+    flockFree(&flock);
+}
+
+// Vipers scattered around a cube with a planet in the middle, dense enough that a few percent are touching
+static void benchCollision(int ships, int ticks) {
+    const Mesh* viper = getMesh("viper.bin");
+    const Mesh* sphere = getMesh("sphere.bin");
+    if (!viper || !sphere) return;
+
+    CollisionWorld world = {.margin = 5.0f};
+    CollisionBody* bodies = collisionBodies(&world, ships + 1);
+    Arena scratch;
+    if (!bodies || arenaInit(&scratch, "collision", 1 << 20) != 0) return;
+
+    Rng rng;
+    rngSeed(&rng, BENCH_SEED);
+    float side = cbrtf((float)ships) * 40.0f;
+    for (int i = 0; i <= ships; i++) {
+        CollisionBody* body = &bodies[i];
+        memset(body, 0, sizeof(CollisionBody));
+        body->mesh = i == 0 ? sphere : viper;
+        body->scale = i == 0 ? side * 0.5f : 2.0f;
+        body->forward[0] = -1.0f;
+        body->up[1] = 1.0f;
+        body->right[2] = 1.0f;
+        for (int k = 0; k < 3; k++) body->position[k] = i == 0 ? side * 0.5f : rngRange(&rng, 0, side);
+        // Identity orientation, so the sphere centre is just offset from the mesh centre
+        body->center[0] = body->position[0] - (body->mesh->sphereCenter[0] - body->mesh->center[0]) * body->scale;
+        body->center[1] = body->position[1] + (body->mesh->sphereCenter[1] - body->mesh->center[1]) * body->scale;
+        body->center[2] = body->position[2] + (body->mesh->sphereCenter[2] - body->mesh->center[2]) * body->scale;
+        body->radius = body->mesh->sphereRadius * body->scale;
+    }
+
+    double total = 0.0;
+    for (int t = 0; t < ticks; t++) {
+        arenaReset(&scratch);
+        double start = nowMs();
+        if (collide(&world, &scratch) != 0) break;
+        total += nowMs() - start;
+    }
+
+    printf("collide %6d ships: %8.3f ms/tick  %6u pairs  %7u triangle tests  %6u contacts  %s\n",
+           ships, total / ticks, world.broadPairs, world.narrowTests, world.numContacts,
+           total / ticks <= 1.0 ? "under 1 ms" : "over 1 ms");
+    freeCollisionWorld(&world);
+    arenaFree(&scratch);
+}
+
+// A pool filled with long lived particles in front of a camera, so nothing dies off and the count stays put
+// Every frame is an update and a splat at 60 fps, most land on screen
+static void benchParticles(int count, int frames) {
+    ParticlePool pool;
+    uint32_t* frame = calloc((size_t)BENCH_WIDTH * BENCH_HEIGHT, sizeof(uint32_t));
+    if (!frame || particlesInit(&pool, count) != 0) {
+        free(frame);
+        return;
+    }
+    
+    Rng rng;
+    rngSeed(&rng, BENCH_SEED);
+    const float origin[3] = {0.0f, 0.0f, 500.0f}, drift[3] = {0.0f, 0.0f, 0.0f};
+    particlesEmit(&pool, origin, drift, 200.0f, 1000.0f, 0x202020, count, &rng);
+    ParticleCamera camera = {
+        .right = {1.0f, 0.0f, 0.0f}, .up = {0.0f, 1.0f, 0.0f}, .forward = {0.0f, 0.0f, 1.0f},
+        .focal = BENCH_WIDTH / 2.0f, .width = BENCH_WIDTH, .height = BENCH_HEIGHT
+    };
+    
+    double updateTime = 0.0, splatTime = 0.0;
+    size_t drawn = 0;
+    for (int t = 0; t < frames; t++) {
+        double start = nowMs();
+        particlesUpdate(&pool, 1.0f / 60.0f, 0.3f);
+        double updated = nowMs();
+        drawn = particlesSplat(&pool, &camera, frame);
+        double splatted = nowMs();
+        updateTime += updated - start;
+        splatTime += splatted - updated;
+    }
+    
+    printf("particles %7d: update %8.3f ms  splat %8.3f ms  %8.0f particles/ms update  %8.0f particles/ms splat  %zu on screen\n",
+           count, updateTime / frames, splatTime / frames, pool.count * frames / updateTime,
+           pool.count * frames / splatTime, drawn);
+    particlesFree(&pool);
+    free(frame);
+}
+
+// Every mesh vertex of every object through each kernel path the CPU has, the way the renderer calls it, one mesh
+// at a time from a camera looking down the middle of them
+static void benchProjection(const char* filename, int objects, int frames) {
+    const Mesh* mesh = getMesh(filename);
+    if (!mesh) return;
+    size_t count = mesh->vertexCount;
+    float* screenX = malloc(count * sizeof(float));
+    float* screenY = malloc(count * sizeof(float));
+    float* depth = malloc(count * sizeof(float));
+    if (!screenX || !screenY || !depth) {
+        free(screenX);
+        free(screenY);
+        free(depth);
+        return;
+    }
+    
+    printf("project %-10s x %6d:", filename, objects);
+    for (int p = 0; p < simdPathCount; p++) {
+        const SimdPath* path = &simdPaths[p];
+        if (!path->supported()) continue;
+        float checksum = 0.0f; // So the stores can't be thrown away
+        double start = nowMs();
+        for (int t = 0; t < frames; t++) {
+            for (int i = 0; i < objects; i++) {
+                SimdProjection projection = {
+                    .rows = {{1.0f, 0.0f, 0.0f, (float)(i % 100) - 50.0f},
+                             {0.0f, 1.0f, 0.0f, (float)(i / 100 % 100) - 50.0f},
+                             {0.0f, 0.0f, 1.0f, 100.0f + i * 0.01f}},
+                    .focal = BENCH_WIDTH / 2.0f, .halfWidth = BENCH_WIDTH / 2.0f, .halfHeight = BENCH_HEIGHT / 2.0f
+                };
+                path->project(&projection, mesh->vertices, count, screenX, screenY, depth);
+                checksum += screenX[i % count];
+            }
+        }
+        double time = (nowMs() - start) / frames;
+        printf("  %s %7.3f ms (%6.0f vertices/ms)", path->name, time, count * objects / time + checksum * 0.0f);
+    }
+    printf("\n");
+    free(screenX);
+    free(screenY);
+    free(depth);
+}
+
+// A server and some clients in the same process talking over localhost, entities spread over a cube twice the
+// interest radius across, most moving every tick and some turning, the way ships and planets do
+static void benchNetwork(int clients, int count, int ticks) {
+    NetServer server;
+    NetClient* peers = calloc(clients, sizeof(NetClient));
+    NetEntity* entities = malloc((size_t)count * sizeof(NetEntity));
+    float (*velocities)[3] = malloc((size_t)count * sizeof(*velocities));
+    if (!peers || !entities || !velocities || netServerStart(&server, BENCH_PORT, BENCH_INTEREST, 30) != 0) {
+        free(peers);
+        free(entities);
+        free(velocities);
+        return;
+    }
+
+    Rng rng;
+    rngSeed(&rng, BENCH_SEED);
+    float side = BENCH_INTEREST * 2.0f;
+    const float forward[3] = {-1.0f, 0.0f, 0.0f}, up[3] = {0.0f, 1.0f, 0.0f}, right[3] = {0.0f, 0.0f, 1.0f};
+    uint16_t mesh = netServerMesh(&server, "viper.bin");
+    for (int i = 0; i < count; i++) {
+        NetEntity* entity = &entities[i];
+        entity->id = i;
+        for (int k = 0; k < 3; k++) {
+            entity->position[k] = rngRange(&rng, 0, side);
+            velocities[i][k] = i % 10 == 0 ? 0.0f : rngRange(&rng, -4, 4); // A tenth sit still
+        }
+        netOrientationFromBasis(forward, up, right, entity->orientation);
+        entity->scale = 2.0f;
+        entity->color = 0xFFFFFF;
+        entity->mesh = mesh;
+        entity->kind = 10;
+    }
+    for (int c = 0; c < clients; c++) {
+        if (netClientConnect(&peers[c], "127.0.0.1", BENCH_PORT) != 0) {
+            clients = c;
+            break;
+        }
+        for (int k = 0; k < 3; k++) peers[c].view[k] = rngRange(&rng, 0, side);
+    }
+
+    double encodeTime = 0.0, decodeTime = 0.0;
+    uint64_t bytes = 0;
+    uint32_t records = 0;
+    netServerPoll(&server);
+    for (int t = 1; t <= ticks; t++) {
+        for (int i = 0; i < count; i++) {
+            for (int k = 0; k < 3; k++) entities[i].position[k] += velocities[i][k];
+            if (i % 4 == 0) {
+                float angle = t * 0.02f + i;
+                float turn[4] = {0.0f, sinf(angle * 0.5f), 0.0f, cosf(angle * 0.5f)};
+                memcpy(entities[i].orientation, turn, sizeof(turn));
+            }
+        }
+        netServerPoll(&server);
+        if (netServerBroadcast(&server, t, entities, count) != 0) break;
+        encodeTime += server.encodeTime;
+        bytes += server.bytesSent;
+        records += server.recordsSent;
+        double start = nowMs();
+        for (int c = 0; c < clients; c++) netClientPoll(&peers[c]);
+        decodeTime += nowMs() - start;
+    }
+
+    uint32_t received = 0;
+    for (int c = 0; c < clients; c++) received += netClientEntities(&peers[c], NULL, 0);
+    double perClient = clients ? (double)bytes / ticks / clients : 0.0;
+    printf("net %2d clients %6d entities: encode %7.3f ms/tick  decode %7.3f ms/tick  %7.0f bytes/client/tick  %7.1f KB/s/client at 30 Hz  %5u in view  %5u changed/client/tick\n",
+           clients, count, encodeTime / ticks, decodeTime / ticks, perClient, perClient * 30.0 / 1024.0,
+           clients ? received / clients : 0, clients ? records / ticks / clients : 0);
+
+    for (int c = 0; c < clients; c++) netClientClose(&peers[c]);
+    netServerStop(&server);
+    free(peers);
+    free(entities);
+    free(velocities);
+}
+
+int main(int argc, char* argv[]) {
+    int ticks = argc > 1 ? atoi(argv[1]) : 30;
+    if (ticks < 1) ticks = 1;
+
+    const int flockSizes[] = {1000, 10000, 25000, 50000, 100000};
+    for (size_t i = 0; i < sizeof(flockSizes) / sizeof(flockSizes[0]); i++) {
+        benchFlock(flockSizes[i], ticks);
+    }
+
+    const int collisionSizes[] = {1000, 5000, 10000, 25000};
+    for (size_t i = 0; i < sizeof(collisionSizes) / sizeof(collisionSizes[0]); i++) {
+        benchCollision(collisionSizes[i], ticks);
+    }
+    
+    const int particleSizes[] = {10000, 65536, 250000, 1000000};
+    for (size_t i = 0; i < sizeof(particleSizes) / sizeof(particleSizes[0]); i++) {
+        benchParticles(particleSizes[i], ticks);
+    }
+    
+    const int projectionSizes[] = {1000, 10000, 50000};
+    for (size_t i = 0; i < sizeof(projectionSizes) / sizeof(projectionSizes[0]); i++) {
+        benchProjection("viper.bin", projectionSizes[i], ticks);
+        benchProjection("sphere.bin", projectionSizes[i] / 10, ticks);
+    }
+    
+    const int netClients[] = {1, 8, 32, 8};
+    const int netEntities[] = {1000, 10000, 10000, 100000};
+    for (size_t i = 0; i < sizeof(netClients) / sizeof(netClients[0]); i++) {
+        benchNetwork(netClients[i], netEntities[i], ticks);
+    }
+    freeMeshes();
+    return 0;
+}
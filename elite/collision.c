@@ -0,0 +1,378 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "collision.h"
+
+// Anything with a radius this many times the average goes on the large list instead of the grid,
+// otherwise one planet would blow the cell size up and put every ship in the same cell
+#define LARGE_BODY_FACTOR 4.0f
+#define BVH_STACK_SIZE 64 // Walks of meshes deeper than this get their stack from the scratch arena
+
+static inline float dot3(const float a[3], const float b[3]) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static inline uint32_t hashCell(int x, int y, int z, uint32_t mask) {
+    return ((uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u) & mask;
+}
+
+static inline int cellCoordinate(float v, float cellSize) {
+    return (int)floorf(v / cellSize);
+}
+
+// Cell of a point, and which way along each axis the other half of its 2x2x2 block is
+static inline void cellBlock(const float center[3], float cellSize, int cell[3], int side[3]) {
+    for (int k = 0; k < 3; k++) {
+        float v = center[k] / cellSize;
+        float c = floorf(v);
+        cell[k] = (int)c;
+        side[k] = (v - c) < 0.5f ? -1 : 1;
+    }
+}
+
+CollisionBody* collisionBodies(CollisionWorld* world, uint32_t count) {
+    if (count > world->bodyCapacity) {
+        CollisionBody* bodies = (CollisionBody*)realloc(world->bodies, count * sizeof(CollisionBody));
+        uint32_t* sorted = (uint32_t*)realloc(world->sorted, count * sizeof(uint32_t));
+        if (sorted) world->sorted = sorted;
+        uint32_t* bucketOf = (uint32_t*)realloc(world->bucketOf, count * sizeof(uint32_t));
+        if (bucketOf) world->bucketOf = bucketOf;
+        uint32_t* large = (uint32_t*)realloc(world->large, count * sizeof(uint32_t));
+        if (large) world->large = large;
+        float (*sortedSpheres)[4] = realloc(world->sortedSpheres, count * sizeof(float[4]));
+        if (sortedSpheres) world->sortedSpheres = sortedSpheres;
+        if (bodies) world->bodies = bodies;
+        if (!bodies || !sorted || !bucketOf || !large || !sortedSpheres) {
+            printf("Failed to allocate memory for collision bodies\n");
+            return NULL;
+        }
+        world->bodyCapacity = count;
+    }
+    world->numBodies = count;
+    return world->bodies;
+}
+
+static int addContact(CollisionWorld* world, const Contact* contact) {
+    if (world->numContacts == world->contactCapacity) {
+        uint32_t capacity = world->contactCapacity ? world->contactCapacity * 2 : 256;
+        Contact* contacts = (Contact*)arenaGrow(world->scratch, world->contacts,
+                                                world->contactCapacity * sizeof(Contact), capacity * sizeof(Contact));
+        if (!contacts) {
+            printf("Failed to allocate memory for contacts\n");
+            return -1;
+        }
+        world->contacts = contacts;
+        world->contactCapacity = capacity;
+    }
+    world->contacts[world->numContacts++] = *contact;
+    return 0;
+}
+
+// Closest point on triangle abc to p, from Real-Time Collision Detection
+static void closestPointOnTriangle(const float p[3], const float a[3], const float b[3], const float c[3], float out[3]) {
+    float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    float ap[3] = {p[0] - a[0], p[1] - a[1], p[2] - a[2]};
+    float d1 = dot3(ab, ap), d2 = dot3(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        memcpy(out, a, sizeof(float[3]));
+        return;
+    }
+
+    float bp[3] = {p[0] - b[0], p[1] - b[1], p[2] - b[2]};
+    float d3 = dot3(ab, bp), d4 = dot3(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) {
+        memcpy(out, b, sizeof(float[3]));
+        return;
+    }
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        float v = d1 / (d1 - d3);
+        for (int k = 0; k < 3; k++) out[k] = a[k] + v * ab[k];
+        return;
+    }
+
+    float cp[3] = {p[0] - c[0], p[1] - c[1], p[2] - c[2]};
+    float d5 = dot3(ab, cp), d6 = dot3(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) {
+        memcpy(out, c, sizeof(float[3]));
+        return;
+    }
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        float w = d2 / (d2 - d6);
+        for (int k = 0; k < 3; k++) out[k] = a[k] + w * ac[k];
+        return;
+    }
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        for (int k = 0; k < 3; k++) out[k] = b[k] + w * (c[k] - b[k]);
+        return;
+    }
+
+    float denominator = 1.0f / (va + vb + vc);
+    float v = vb * denominator, w = vc * denominator;
+    for (int k = 0; k < 3; k++) out[k] = a[k] + ab[k] * v + ac[k] * w;
+}
+
+// Closest point on a mesh to a sphere in its model space, only looks within radius, returns 0 if nothing is that close
+static int closestPointOnMesh(CollisionWorld* world, const Mesh* mesh, const float center[3], float radius, float out[3]) {
+    uint32_t localStack[BVH_STACK_SIZE];
+    uint32_t* stack = localStack;
+    size_t mark = arenaMark(world->scratch);
+    if (mesh->bvhDepth + 1 > BVH_STACK_SIZE) {
+        stack = (uint32_t*)arenaAlloc(world->scratch, (mesh->bvhDepth + 1) * sizeof(uint32_t));
+        if (!stack) {
+            printf("Failed to allocate a %u deep BVH stack for %s, missing its contacts\n", mesh->bvhDepth + 1, mesh->filename);
+            return 0;
+        }
+    }
+    int top = 0;
+    float best = radius * radius;
+    int found = 0;
+
+    stack[top++] = 0;
+    while (top > 0) {
+        const MeshBvhNode* node = &mesh->bvh[stack[--top]];
+
+        // Squared distance from the sphere to the box, skip it if it's further than the best so far
+        float distanceSqr = 0.0f;
+        for (int k = 0; k < 3; k++) {
+            float v = center[k];
+            if (v < node->boundsMin[k]) distanceSqr += (node->boundsMin[k] - v) * (node->boundsMin[k] - v);
+            else if (v > node->boundsMax[k]) distanceSqr += (v - node->boundsMax[k]) * (v - node->boundsMax[k]);
+        }
+        if (distanceSqr > best) continue;
+
+        if (node->count == 0) {
+            stack[top++] = node->first;
+            stack[top++] = (uint32_t)(node - mesh->bvh) + 1;
+            continue;
+        }
+
+        for (uint32_t i = node->first; i < node->first + node->count; i++) {
+            const uint32_t* triangle = mesh->indices[mesh->bvhTriangles[i]];
+            float point[3];
+            closestPointOnTriangle(center, mesh->vertices[triangle[0]], mesh->vertices[triangle[1]], mesh->vertices[triangle[2]], point);
+            float d[3] = {center[0] - point[0], center[1] - point[1], center[2] - point[2]};
+            float candidate = dot3(d, d);
+            world->narrowTests++;
+            if (candidate < best) {
+                best = candidate;
+                memcpy(out, point, sizeof(float[3]));
+                found = 1;
+            }
+        }
+    }
+    arenaRelease(world->scratch, mark);
+    return found;
+}
+
+// Bounding spheres overlap, check properly with the smaller sphere against the bigger one's triangles
+static int narrowPhase(CollisionWorld* world, uint32_t a, uint32_t b) {
+    if (a > b) {
+        uint32_t swap = a;
+        a = b;
+        b = swap;
+    }
+    const CollisionBody* bodyA = &world->bodies[a];
+    const CollisionBody* bodyB = &world->bodies[b];
+    int sphereIsA = bodyA->radius <= bodyB->radius;
+    const CollisionBody* sphere = sphereIsA ? bodyA : bodyB;
+    const CollisionBody* solid = sphereIsA ? bodyB : bodyA;
+
+    Contact contact = {.a = a, .b = b};
+    float point[3]; // On the solid body
+    float distance;
+
+    if (!solid->mesh || !solid->mesh->bvh || solid->scale <= 0.0f) {
+        // Nothing better to go on than the spheres
+        float d[3] = {sphere->center[0] - solid->center[0], sphere->center[1] - solid->center[1], sphere->center[2] - solid->center[2]};
+        float length = sqrtf(dot3(d, d));
+        if (length < 1e-6f) return 0;
+        for (int k = 0; k < 3; k++) point[k] = solid->center[k] + d[k] / length * solid->radius;
+        distance = length - solid->radius;
+    } else {
+        // Sphere into the solid's model space, the basis is orthonormal so the inverse is just the dot products
+        const Mesh* mesh = solid->mesh;
+        float d[3] = {sphere->center[0] - solid->position[0], sphere->center[1] - solid->position[1], sphere->center[2] - solid->position[2]};
+        float inverseScale = 1.0f / solid->scale;
+        float model[3] = {
+            -dot3(d, solid->forward) * inverseScale + mesh->center[0],
+            dot3(d, solid->up) * inverseScale + mesh->center[1],
+            dot3(d, solid->right) * inverseScale + mesh->center[2]
+        };
+
+        float closest[3] = {0.0f, 0.0f, 0.0f};
+        if (!closestPointOnMesh(world, mesh, model, (sphere->radius + world->margin) * inverseScale, closest)) return 0;
+
+        float x = closest[0] - mesh->center[0], y = closest[1] - mesh->center[1], z = closest[2] - mesh->center[2];
+        for (int k = 0; k < 3; k++) {
+            point[k] = solid->position[k] + solid->scale * (-x * solid->forward[k] + y * solid->up[k] + z * solid->right[k]);
+        }
+        float offset[3] = {model[0] - closest[0], model[1] - closest[1], model[2] - closest[2]};
+        distance = sqrtf(dot3(offset, offset)) * solid->scale;
+    }
+
+    // Normal from the solid towards the sphere, falls back to centre to centre if the sphere centre is on the surface
+    float normal[3] = {sphere->center[0] - point[0], sphere->center[1] - point[1], sphere->center[2] - point[2]};
+    float length = sqrtf(dot3(normal, normal));
+    if (length < 1e-6f) {
+        for (int k = 0; k < 3; k++) normal[k] = sphere->center[k] - solid->center[k];
+        length = sqrtf(dot3(normal, normal));
+        if (length < 1e-6f) return 0;
+    }
+    float direction = sphereIsA ? 1.0f : -1.0f; // Contacts always point from b to a
+    for (int k = 0; k < 3; k++) {
+        contact.normal[k] = normal[k] / length * direction;
+        contact.point[k] = point[k];
+    }
+    contact.depth = sphere->radius - distance;
+    return addContact(world, &contact);
+}
+
+static int spheresTouch(const CollisionWorld* world, uint32_t a, uint32_t b) {
+    const CollisionBody* bodyA = &world->bodies[a];
+    const CollisionBody* bodyB = &world->bodies[b];
+    float d[3] = {bodyA->center[0] - bodyB->center[0], bodyA->center[1] - bodyB->center[1], bodyA->center[2] - bodyB->center[2]};
+    float reach = bodyA->radius + bodyB->radius + world->margin;
+    return dot3(d, d) < reach * reach;
+}
+
+int collide(CollisionWorld* world, Arena* scratch) {
+    uint32_t count = world->numBodies;
+    world->scratch = scratch;
+    world->contacts = NULL;
+    world->contactCapacity = 0;
+    world->numContacts = 0;
+    world->broadPairs = 0;
+    world->narrowTests = 0;
+    world->numLarge = 0;
+    if (count < 2) return 0;
+
+    // Sort the bodies into small and large, the cell has to fit the biggest small one
+    float averageRadius = 0.0f;
+    for (uint32_t i = 0; i < count; i++) averageRadius += world->bodies[i].radius;
+    averageRadius /= count;
+    float largeRadius = averageRadius * LARGE_BODY_FACTOR;
+    float biggestSmall = 0.0f;
+    for (uint32_t i = 0; i < count; i++) {
+        float radius = world->bodies[i].radius;
+        if (radius > largeRadius) world->large[world->numLarge++] = i;
+        else if (radius > biggestSmall) biggestSmall = radius;
+    }
+    world->cellSize = 2.0f * (2.0f * biggestSmall + world->margin);
+    if (world->cellSize <= 0.0f) world->cellSize = 1.0f;
+
+    uint32_t numBuckets = 64;
+    while (numBuckets < count * 2) numBuckets <<= 1;
+    if (numBuckets + 1 > world->bucketCapacity) {
+        uint32_t* bucketStart = (uint32_t*)realloc(world->bucketStart, (numBuckets + 1) * sizeof(uint32_t));
+        if (!bucketStart) {
+            printf("Failed to allocate memory for collision grid\n");
+            return -1;
+        }
+        world->bucketStart = bucketStart;
+        world->bucketCapacity = numBuckets + 1;
+    }
+    world->numBuckets = numBuckets;
+    uint32_t mask = numBuckets - 1;
+
+    // Counting sort of the small bodies by bucket, same as the flock grid
+    uint32_t* start = world->bucketStart;
+    memset(start, 0, (numBuckets + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++) {
+        const CollisionBody* body = &world->bodies[i];
+        if (body->radius > largeRadius) {
+            world->bucketOf[i] = UINT32_MAX;
+            continue;
+        }
+        uint32_t bucket = hashCell(cellCoordinate(body->center[0], world->cellSize),
+                                   cellCoordinate(body->center[1], world->cellSize),
+                                   cellCoordinate(body->center[2], world->cellSize), mask);
+        world->bucketOf[i] = bucket;
+        start[bucket]++;
+    }
+    uint32_t sum = 0;
+    for (uint32_t b = 0; b < numBuckets; b++) {
+        sum += start[b];
+        start[b] = sum;
+    }
+    start[numBuckets] = sum;
+    for (uint32_t i = count; i-- > 0;) {
+        if (world->bucketOf[i] == UINT32_MAX) continue;
+        uint32_t slot = --start[world->bucketOf[i]];
+        world->sorted[slot] = i;
+        memcpy(world->sortedSpheres[slot], world->bodies[i].center, sizeof(float[3]));
+        world->sortedSpheres[slot][3] = world->bodies[i].radius + world->margin;
+    }
+
+    // Small against small, the cells are twice the reach of any pair, so everything a body can touch is in the
+    // 2x2x2 block of cells on the side of its own cell it's closest to, pairs get found from both ends
+    for (uint32_t i = 0; i < count; i++) {
+        if (world->bucketOf[i] == UINT32_MAX) continue;
+        const CollisionBody* body = &world->bodies[i];
+        int cell[3], side[3];
+        cellBlock(body->center, world->cellSize, cell, side);
+
+        uint32_t visited[8];
+        int numVisited = 0;
+        for (int ox = 0; ox <= 1; ox++) {
+            for (int oy = 0; oy <= 1; oy++) {
+                for (int oz = 0; oz <= 1; oz++) {
+                    uint32_t bucket = hashCell(cell[0] + ox * side[0], cell[1] + oy * side[1], cell[2] + oz * side[2], mask);
+                    if (start[bucket] == start[bucket + 1]) continue;
+                    int seen = 0;
+                    for (int v = 0; v < numVisited; v++) {
+                        if (visited[v] == bucket) {
+                            seen = 1;
+                            break;
+                        }
+                    }
+                    if (seen) continue;
+                    visited[numVisited++] = bucket;
+
+                    for (uint32_t k = start[bucket]; k < start[bucket + 1]; k++) {
+                        // Cheap sphere check on the sorted copy first, it's right next to the rest of the bucket
+                        const float* other = world->sortedSpheres[k];
+                        float d[3] = {body->center[0] - other[0], body->center[1] - other[1], body->center[2] - other[2]};
+                        float reach = body->radius + other[3];
+                        if (dot3(d, d) >= reach * reach) continue;
+                        uint32_t j = world->sorted[k];
+                        if (j <= i) continue;
+                        world->broadPairs++;
+                        if (narrowPhase(world, i, j) != 0) return -1;
+                    }
+                }
+            }
+        }
+    }
+
+    // Large against everything, there's only ever a handful of them
+    for (uint32_t l = 0; l < world->numLarge; l++) {
+        uint32_t i = world->large[l];
+        for (uint32_t j = 0; j < count; j++) {
+            if (j == i) continue;
+            if (world->bucketOf[j] == UINT32_MAX && j < i) continue; // Large pair, already done from the other side
+            if (!spheresTouch(world, i, j)) continue;
+            world->broadPairs++;
+            if (narrowPhase(world, i, j) != 0) return -1;
+        }
+    }
+    return 0;
+}
+
+void freeCollisionWorld(CollisionWorld* world) {
+    free(world->bodies);
+    free(world->bucketStart);
+    free(world->sorted);
+    free(world->bucketOf);
+    free(world->large);
+    free(world->sortedSpheres);
+    memset(world, 0, sizeof(CollisionWorld));
+}
@@ -3,9 +3,13 @@
 # There are some screenshots as well, there is a built-in screenshot functionality.
 # Also a lot of redundant functions for mathematical functions.
 # Included in this directory is tobin.c, it can convert .stl files to .bin files the engine can read 
+# Build it with: gcc tobin.c mesh.c -o tobin -lm
+# Add --v2 to write the v2 mesh format (header, bounds, indices, edges, normals), the engine reads both
+# tobin --upgrade old.bin new.bin converts an old headerless .bin to v2
 # Not very good, after all, it's a learning project for me, a LOT of vector math and quaternion rotation that I have not done before.
 # Really just 2000 lines of going insane
 # Some compile flags might be useless, I don't care enough to change them
+# Everything's built for plain x86-64 so it runs anywhere, simd.c has AVX2/AVX-512 versions of the hot kernels and picks one at startup
 
 # wasd for the player
 # qe for roll, rf for pitch
@@ -17,15 +21,88 @@
 # z first person
 # x free look
 # p pause
+# b toggle flocking, the vipers fly as one fleet
+#   fits a 30 Hz tick up to about 50k vipers per steering thread (NUM_THREADS in elite.c), 100k takes about 60 ms a tick on one
+# m toggle the radar
+# h toggle the performance overlay, frame time graph, stage times and what got drawn
+# F5 quicksave to quicksave.snap, ./elite.x86_64 --load quicksave.snap carries on from it
+# ./elite.x86_64 file.scene loads a different scene, default.scene otherwise
+# ./elite.x86_64 universe.scene generates star systems around the player instead of a fixed scene
+# --target-ms 8 sets the render time the resolution scaling aims for, 10 ms by default
+# --present drawpixels uses the old glDrawPixels path instead of streaming through a texture
+# --present-check draws a test pattern, reads it back and exits, LIBGL_ALWAYS_SOFTWARE=1 runs it on Mesa's software GL
+# --server runs headless and sends the world to clients over UDP, --port 27500 by default
+# --connect 127.0.0.1 draws what a server sends instead of simulating, the camera is yours, the ships aren't
+# --simd sse2 forces a kernel path (avx512, avx2 or sse2) instead of the fastest one the CPU has, the pick is printed at startup
+# --tick-rate 60 sets the simulation ticks per second, 30 by default, things move per tick so it speeds the game up too
 # 0 take screenshot
+# Add -DLOG_LEVEL=LOG_LEVEL_DEBUG to the elite.c line for more log output, LOG_LEVEL_NONE compiles it all out
 
 mkdir build
 
+# Compile font.c
+gcc -c font.c -o build/font.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
 # Compile pause_menu.c
-gcc -c pause_menu.c -o build/pmenu.o -Wall -Wextra -msse4.1 -O3 -ffast-math -funroll-loops -fomit-frame-pointer -mavx `sdl2-config --cflags` -fopenmp
+gcc -c pause_menu.c -o build/pmenu.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer `sdl2-config --cflags` -fopenmp
+
+# Compile scene.c
+gcc -c scene.c -o build/scene.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile mesh.c
+gcc -c mesh.c -o build/mesh.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile flock.c
+gcc -c flock.c -o build/flock.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile collision.c
+gcc -c collision.c -o build/collision.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile arena.c
+gcc -c arena.c -o build/arena.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile hiz.c
+gcc -c hiz.c -o build/hiz.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile present.c
+gcc -c present.c -o build/present.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile sector.c
+gcc -c sector.c -o build/sector.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile loader.c
+gcc -c loader.c -o build/loader.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile log.c
+gcc -c log.c -o build/log.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile radar.c
+gcc -c radar.c -o build/radar.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile particles.c
+gcc -c particles.c -o build/particles.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile save.c
+gcc -c save.c -o build/save.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile net.c
+gcc -c net.c -o build/net.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile simd.c, no -m flags, the AVX versions say what they need themselves
+gcc -c simd.c -o build/simd.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+
+# Compile hud.c
+gcc -c hud.c -o build/hud.o -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer
 
 # Compile elite.c
-gcc -g -c elite.c -o build/elite.o `sdl2-config --cflags` -msse4.1 -fopenmp -O3 -ffast-math -funroll-loops -fomit-frame-pointer
+gcc -g -c elite.c -o build/elite.o `sdl2-config --cflags` -fopenmp -O3 -ffast-math -funroll-loops -fomit-frame-pointer
 
 # Create the executable
-gcc -g build/pmenu.o build/elite.o -o elite.x86_64 -lSDL2 -lm -lGLEW -lGL `sdl2-config --libs` -fopenmp -flto -lGLU
+gcc -g build/font.o build/pmenu.o build/scene.o build/mesh.o build/flock.o build/collision.o build/arena.o build/hiz.o build/present.o build/sector.o build/loader.o build/log.o build/radar.o build/particles.o build/save.o build/net.o build/simd.o build/hud.o build/elite.o -o elite.x86_64 -lSDL2 -lm -lGLEW -lGL `sdl2-config --libs` -fopenmp -flto -lGLU
+
+# Micro-benchmarks for the primitives in elite.c, built with the game's flags since it includes elite.c itself
+# ./microbench.x86_64 --json before.json then the same after a change, --filter drawEdge runs just the ones matching
+gcc microbench.c build/font.o build/pmenu.o build/scene.o build/mesh.o build/flock.o build/collision.o build/arena.o build/hiz.o build/present.o build/sector.o build/loader.o build/log.o build/radar.o build/particles.o build/save.o build/net.o build/simd.o build/hud.o -o microbench.x86_64 `sdl2-config --cflags` -fopenmp -O3 -ffast-math -funroll-loops -fomit-frame-pointer -lSDL2 -lm -lGLEW -lGL `sdl2-config --libs` -lGLU
+
+# Headless benchmarks, no SDL needed
+gcc bench.c flock.c collision.c mesh.c arena.c particles.c net.c simd.c -o bench.x86_64 -Wall -Wextra -O3 -ffast-math -funroll-loops -fomit-frame-pointer -lm -pthread
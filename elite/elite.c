@@ -5,12 +5,30 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
-#include <emmintrin.h>
-#include <immintrin.h>
 #include <pthread.h>
+#include <signal.h>
 #include "pause_menu.h"
+#include "scene.h"
+#include "mesh.h"
+#include "rng.h"
+#include "flock.h"
+#include "collision.h"
+#include "arena.h"
+#include "hiz.h"
+#include "present.h"
+#include "sector.h"
+#include "loader.h"
+#include "log.h"
+#include "radar.h"
+#include "particles.h"
+#include "save.h"
+#include "net.h"
+#include "simd.h"
+#include "hud.h"
 
 #define COLLISION_DISTANCE 5.0f // Max distance to test collison
+#define COLLISION_RESTITUTION 0.3f // How much of the closing speed bounces back
+#define COLLISION_CORRECTION 0.5f // How much of the overlap gets pushed out per tick, all of it at once makes piles jitter
 #define TURN_SPEED 0.01f
 #define LINE_THRESHOLD 2.0f  // Pixel distance to mark an edge
 #define STAR_SEED 31415926
@@ -24,6 +42,52 @@
 #define CLAMP(t, min, max) fmaxf(min, fminf(max, t))
 
 #define NUM_THREADS 1
+#define AI_BUDGET_PER_TICK 4000 // Most steering updates per tick, the rest wait for the next one
+#define AI_NEAR_DISTANCE 1000.0f // Closer than this to the player steers every tick
+#define AI_MAX_INTERVAL 32 // Furthest ships steer once every this many ticks
+#define FLOCK_LOOKAHEAD 30.0f // How far along the flocking steering a viper aims
+#define AVOID_LARGE_FACTOR 4.0f // Avoidance radii this many times the average skip the grid, planets and stars
+#define RANDOMS_PER_OBJECT 4 // Per tick, 3 for the avoidance perturbation and 1 for picking the first destination
+
+// Object.pooled flags, set when the memory is part of a bulk allocation and must not be freed on its own
+#define POOLED_PATH 0x01
+#define FRAME_ARENA_SIZE (8 << 20) // Starting sizes, they grow if a frame needs more
+#define WORKER_ARENA_SIZE (1 << 20)
+#define RENDER_TARGET_MS 10.0f // Default render time to aim for, --target-ms changes it
+#define RENDER_SCALE_MIN 0.5f // Lowest the internal resolution goes, per axis
+#define RENDER_SCALE_STEP 0.05f // Biggest change in one adjustment
+#define RENDER_SCALE_FRAMES 15 // Frames of render time averaged before each adjustment
+#define TICK_RATE 30 // Default simulation ticks per second, --tick-rate changes it, rendering isn't capped
+#define MAX_CATCH_UP_TICKS 5 // Most ticks run back to back to catch up, any more time owed than that gets dropped
+#define SNAPSHOT_COUNT 4 // Newest, the two being rendered and one to fill
+#define SIM_ARENA_SIZE (1 << 20)
+#define RADAR_WIDTH 480 // Scanner size at full resolution, it scales with the render resolution
+#define RADAR_HEIGHT 160
+#define RADAR_MARGIN 20 // Gap under it
+#define RADAR_RANGE 8000.0f
+#define HUD_SCALE 3 // Font pixels at full resolution, it shrinks with the render resolution
+#define PAUSE_WAIT_MS 100 // Longest the paused main loop sleeps waiting for input, the P key is polled in between
+#define IMPOSTOR_SEGMENTS 16 // Sides of the circle drawn for something whose mesh is still loading
+#define MAX_PARTICLES (1 << 16) // Fixed, emitting when it's full just drops the extra
+#define PARTICLE_DRAG 0.3f // Velocity left after a second
+#define ENGINE_PARTICLE_RATE 40.0f // Per ship per second
+#define ENGINE_EXHAUST_SPEED 60.0f // Per second, backwards out of the engine on top of the ship's own speed
+#define ENGINE_PARTICLE_LIFE 0.6f
+#define ENGINE_PARTICLE_SPREAD 4.0f
+#define ENGINE_PARTICLE_COLOR 0x4070FF
+#define EXPLOSION_SPEED 2.0f // Closing speed per tick a collision needs to go off
+#define EXPLOSION_PARTICLES 200
+#define EXPLOSION_SPREAD 80.0f
+#define EXPLOSION_LIFE 1.2f
+#define EXPLOSION_COLOR 0xFF9030
+#define MAX_BURSTS 64 // Explosions waiting for the main thread, more than that in one frame get dropped
+#define SAVE_FORMAT 1 // Goes up whenever what saveWorld writes changes, Object's layout is checked on its own
+#define SAVE_MAX_MESHES 256 // Different mesh files a save can refer to
+#define QUICKSAVE_FILE "quicksave.snap"
+#define NET_INTEREST_RADIUS 20000.0f // Clients get sent everything this close to their camera, more than the radar shows
+#define SECTOR_CLEAR_RADIUS 30000.0f // Nothing gets generated this close to the origin, the player starts there
+// What an object costs against the sector budget, itself, a transform in every snapshot and a path destination
+#define SECTOR_OBJECT_BYTES (sizeof(Object) + SNAPSHOT_COUNT * sizeof(RenderTransform) + sizeof(PathDestination))
 
 typedef struct {
     float position[3];
@@ -66,11 +130,12 @@ typedef struct {
     int index;
 } DrawableDistance;
 
+// An object the frame's views draw, from gatherView, the camera space center is alongside in viewBlips
 typedef struct {
-    float v1[3];
-    float v2[3];
-    float v3[3];
-} Triangle;
+    int index; // Into frameTransforms
+    float distance; // From the camera
+    uint8_t culled; // Behind an occluder in the main view
+} ViewEntity;
 
 // Pathfining parameters or whatever
 typedef struct {
@@ -98,12 +163,22 @@ typedef struct {
 	uint8_t personality; // 8-bit 'number' use the bits for individual aspects?
 } MobParameters;
 
+// When the AI gets to steer, set up by scheduleAI every tick
+typedef struct {
+	uint32_t nextTick; // Due for a steering update from this tick on
+	uint32_t lastTick; // Last tick it steered
+	uint8_t interval; // Ticks between updates, from distance and visibility
+	uint8_t priority; // 0 if not due, lower goes first otherwise
+	uint8_t update; // Steer this tick
+	float thrust; // Last steering decision, applied every tick
+} AiSchedule;
+
 typedef struct {
 	uint8_t id; // todo: assign ids ids are the type of ship
-	Triangle* triangles;
+	const Mesh* mesh; // Shared model space mesh, placed in the world by position, forward/up/right and scale
 	Vec3 triangle_normals;
 	float position[3]; // Centre of object based on where the verticies are
-	size_t triangle_count;
+	float scale;
 	unsigned int color;
 	float velX, velY, velZ;
     float forward[3];
@@ -112,18 +187,102 @@ typedef struct {
     PathParameters pathing;
     ShipParameters parameters;
     MobParameters mob;
+    AiSchedule ai;
     int invincible, invisible;
     float avoidanceRadius;
     float mass;
     uint32_t planetIndex, starIndex;
+    uint32_t flockIndex; // Agent index in the flock, only valid while flocking
+    uint8_t pooled; // POOLED_* flags
+    uint8_t loadingMesh; // Loader handle + 1 while the mesh is loading in the background, 0 otherwise
 } Object;
 
+// Each worker thread has its own generator and scratch memory, so the AI never touches shared state
+typedef struct {
+    Rng4 rng;
+    Arena arena; // Reset at the start of every tick
+} WorkerState;
+
 typedef struct {
     Object* objects;
     int start;
     int end;
+    WorkerState* worker;
 } ThreadData;
 
+// What the renderer needs of an object, copied out of the simulation at the end of every tick
+typedef struct {
+    const Mesh* mesh;
+    float position[3];
+    float forward[3], up[3], right[3];
+    float scale;
+    unsigned int color;
+    uint8_t id;
+    uint8_t hidden; // Removed or invisible, indexes stay the same as objects so it's still there
+    float impostorRadius; // Drawn as a sphere this big while the mesh is still loading, 0 otherwise
+    float velocity[3]; // Per tick, for the engine trails
+    float thrust; // How hard the engines are going, 0 when they're off, the trails only come out while it isn't
+} RenderTransform;
+
+// A collision hard enough to throw sparks, the simulation finds them and the main thread emits the particles
+typedef struct {
+    float position[3];
+    uint32_t color;
+} ParticleBurst;
+
+// Every object's transform at the end of one tick, never changed once it's published
+typedef struct {
+    RenderTransform* transforms;
+    int count, capacity;
+    uint32_t tick;
+    uint64_t time; // Performance counter when it was published
+    float tickTime; // How long the tick took to simulate, ms
+    uint32_t overruns; // Ticks so far that took longer than a tick period
+    uint32_t dropped; // Ticks so far skipped because the simulation fell too far behind
+} Snapshot;
+
+// Sections of a save file, the objects go in as they are and pointers get put back together on load
+enum {
+    SAVE_WORLD, // One SavedWorld
+    SAVE_OBJECTS,
+    SAVE_MESH_NAMES, // Every mesh file used
+    SAVE_OBJECT_MESHES, // Index into the mesh names for every object, -1 for none
+    SAVE_DESTINATIONS, // Every object's path destinations one after the other
+    SAVE_FREE_SLOTS, // availableObjectIndexes, in order so the same slots get reused
+    SAVE_PLANETS,
+    SAVE_STARS,
+    SAVE_WORKER_RNG,
+    SAVE_SECTORS,
+    SAVE_SECTOR_OBJECTS // Every sector's object indexes one after the other
+};
+
+typedef struct {
+    uint64_t worldSeed;
+    uint32_t simTick;
+    int32_t aiCursor;
+    float camera[3];
+    int32_t sectorsEnabled, sectorRadius;
+    uint64_t sectorBudget;
+    SectorCoord prefetchedSector;
+} SavedWorld;
+
+typedef struct {
+    SectorCoord coord;
+    uint32_t numObjects;
+    uint32_t lastWanted;
+} SavedSector;
+
+typedef struct {
+    char file[256];
+} SavedMeshName;
+
+// Input for the simulation thread, sampled by the main thread every frame
+typedef struct {
+    Uint8 keys[SDL_NUM_SCANCODES]; // Held at any point since the last tick, so short taps aren't lost
+    int paused, firstPerson;
+    float cameraPosition[3], cameraForward[3], cameraRight[3], cameraUp[3]; // For the AI's visibility check
+} SimInput;
+
 // Function prototypes, put here when needed lol
 float getDistance3D(Vec3 a, Vec3 b);
 void calculateObjectCenter(const Object* object, float center[3]);
@@ -141,7 +300,7 @@ Quaternion rotationBetweenVectors(float v1[3], float v2[3]);
 void rotatePointByQuaternion(float point[3], Quaternion q);
 void rotateObjectByQuaternion(Object* object, Quaternion q);
 Quaternion slerp(Quaternion q1, Quaternion q2, float t);
-void turnTowardsPoint(Object* object, float target[3]);
+void turnTowardsPoint(Object* object, float target[3], int ticks);
 Quaternion multiplyQuat(Quaternion q1, Quaternion q2);
 Quaternion axisAngleToQuat(Vec3 axis, float angle);
 void rotateCamera(Vec3 axis, float angle);
@@ -150,12 +309,18 @@ Vec3 crossProduct(Vec3 a, Vec3 b);
 Vec3 normalize(Vec3 v);
 Quaternion normalizeQuaternion(Quaternion q);
 void moveObject(Object* object, float moveX, float moveY, float moveZ);
+int saveWorld(const char* filename, const float camera[3]);
 
 SkyboxStar SkyboxStars[SKYBOXSTAR_COUNT];
 
 Object* objects = NULL;
 int numObjects = 0;
+int objectCapacity = 0; // Allocated length of objects
 int* availableObjectIndexes = NULL; // Only has a value once an object has been cleared out, not when the object list can be expanded
+int numAvailableObjectIndexes = 0, availableObjectCapacity = 0;
+
+void** objectPools = NULL; // Bulk allocations made by spawnScene
+int numObjectPools = 0;
 
 Planet* planets = NULL;
 int numPlanets = 0;
@@ -165,6 +330,112 @@ int numStars = 0;
 
 const double G = 6.67430e-11; // Gravitational constant
 
+uint64_t worldSeed = STAR_SEED; // Everything random in the simulation comes from this
+uint32_t simTick = 0; // Logic ticks so far
+int aiUpdates = 0, aiDeferred = 0; // Steering updates done and put off during the last tick
+int aiCursor = 0; // Where scheduleAI continues handing out the leftover budget
+WorkerState workers[NUM_THREADS];
+Arena frameArena; // Scratch memory for the main thread, reset at the end of every frame
+Arena simArena; // Same for the simulation thread, reset every tick
+
+// The simulation runs on its own thread and hands the renderer a snapshot of every transform after each tick
+// simLock covers the input and which snapshot is where, never the snapshot contents, nobody writes to one
+// that's published or being rendered
+pthread_t simThread;
+pthread_mutex_t simLock = PTHREAD_MUTEX_INITIALIZER;
+Snapshot snapshots[SNAPSHOT_COUNT];
+int latestSnapshot = -1; // Newest published
+int renderSnapshots[2] = {-1, -1}; // The renderer's previous and current, it draws in between them
+SimInput simInput;
+int tickRate = TICK_RATE;
+uint32_t tickOverruns = 0, ticksDropped = 0; // Simulation thread only, reported through the snapshots
+Uint8 heldKeys[SDL_NUM_SCANCODES]; // Keyboard state at the last sample
+RenderTransform* frameTransforms = NULL; // This frame's interpolated transforms, from the frame arena
+int frameTransformCount = 0;
+RenderTransform* heapTransforms = NULL; // Where they go instead when the frame arena is full
+int heapTransformCapacity = 0;
+
+// Occlusion culling, planets and stars get drawn into the depth pyramid and everything else is tested against it
+DepthPyramid depthPyramid;
+int occluderCount, occlusionTested, occlusionCulled; // Last frame
+float occlusionTime; // ms spent building the pyramid last frame
+
+// What gatherView worked out this frame, in draw order, every view draws from it
+// Kept as big as the draw order, so a frame never comes up short on room for them
+ViewEntity* viewEntities = NULL;
+RadarBlip* viewBlips = NULL; // Camera space centers and colors, same order
+int viewCount = 0;
+Radar radar;
+int radarEnabled = 1;
+int drawnObjects, drawnTriangles, drawnEdges; // By the main view, last frame
+
+// Performance overlay, drawn from the last frame's numbers since this one's aren't in yet
+Hud hud;
+HudStats hudStats;
+int hudEnabled = 0;
+float radarTime, mainViewTime; // ms, last frame, the radar's on its own thread at the same time as the main view
+
+// Engine trails and explosions, only the main thread touches the pool
+ParticlePool particles;
+Rng effectsRng;
+float engineEmitCarry = 0.0f; // Fraction of a particle per ship owed from the last frame
+size_t particlesDrawn = 0; // Last frame
+ParticleBurst tickBursts[MAX_BURSTS]; // Simulation thread, found since the last snapshot
+int numTickBursts = 0;
+ParticleBurst pendingBursts[MAX_BURSTS]; // Published but not emitted yet, under simLock
+int numPendingBursts = 0;
+
+// Flocking mode, vipers fly as a fleet instead of each chasing the player on its own
+int flocking = 0;
+Flock flock;
+FlockParams flockParams = {
+    .neighbourRadius = 40.0f, // Twice the viper avoidance radius
+    .separationRadius = 20.0f,
+    .separationWeight = 1.5f,
+    .alignmentWeight = 1.0f,
+    .cohesionWeight = 0.8f,
+    .pursuitWeight = 1.0f,
+    .maxSpeed = 4.0f // Top speed a viper reaches against the drag
+};
+float (*flockSteering)[3] = NULL; // Per flock agent, filled every tick
+uint8_t* flockActive = NULL; // Per flock agent, only steer the ones the AI scheduler picked
+size_t flockCapacity = 0;
+
+// Everything with an avoidance radius, hashed by cell once a tick before the AI, so a ship only looks at the 27 cells
+// around it, the cells are as big as the biggest small radius so nothing that small can reach further
+struct {
+    uint32_t* bucketStart;
+    uint32_t* bucketOf;
+    uint32_t* sorted; // Object indexes sorted by bucket
+    float (*sortedSpheres)[4]; // Position and avoidance radius in the same order
+    uint32_t* large; // Radius too big for the grid, everyone checks these
+    uint32_t numLarge, numBuckets, capacity, bucketCapacity;
+    float cellSize;
+    int built; // 0 if it couldn't be this tick, avoidance goes through every object then
+} avoidanceGrid;
+
+CollisionWorld collisionWorld = {.margin = COLLISION_DISTANCE};
+float collisionTime = 0.0f; // ms, last tick
+
+// Procedural universe, only when the scene asks for it, sectors near the player get generated and far ones
+// get thrown away once they're over the budget, the simulation thread is the only one that touches it
+int sectorsEnabled = 0;
+SectorMap sectorMap;
+SectorCoord prefetchedSector = {INT32_MIN, INT32_MIN, INT32_MIN}; // Last one updateSectors loaded meshes ahead for
+static const char* sectorMeshFiles[] = {[SECTOR_STAR] = "sphere.bin", [SECTOR_PLANET] = "sphere.bin", [SECTOR_STATION] = "cobra.bin", [SECTOR_SHIP] = "viper.bin"};
+static const uint8_t sectorIds[] = {[SECTOR_STAR] = 2, [SECTOR_PLANET] = 1, [SECTOR_STATION] = 3, [SECTOR_SHIP] = 10};
+
+AssetLoader assetLoader; // Meshes that weren't loaded at startup get loaded on here
+
+// --server runs the simulation with no window and sends every tick out, --connect draws what a server sends
+// instead of simulating, the snapshots it gets become the renderer's snapshots so it interpolates the same way
+NetServer netServer;
+const Mesh* netServerMeshes[NET_MAX_MESHES]; // Same indexes as the server's mesh names
+NetClient netClient;
+const Mesh* netClientMeshes[NET_MAX_MESHES]; // Looked up once the name's arrived
+NetEntity* netEntities = NULL; // Network thread's, for the client, and the server's main thread's
+uint32_t netEntityCapacity = 0;
+
 // Camera parameters.
 float cameraSpeed = 10.0f;
 Vec3 cameraPos = {20000.0f, 0.0f, -500.0f};
@@ -174,13 +445,32 @@ Vec3 camUp;
 Quaternion cameraOrientation = {0, 0, 1, 0}; // Identity quaternion
 int freeLook; // Is able to look around while camera locked?
 
-Uint32 firstPersonTime, freeLookTime, pauseTime;
+Uint32 firstPersonTime, freeLookTime, pauseTime, flockTime, radarKeyTime, hudKeyTime;
+
+// Internal resolution, SCREEN_WIDTH x SCREEN_HEIGHT is the most it can be, scaled down when frames get slow
+// The pixel buffers are allocated at the full size once, a smaller frame just uses the start of them
+int renderWidth = SCREEN_WIDTH;
+int renderHeight = SCREEN_HEIGHT;
+float renderScale = 1.0f;
+float renderTargetMs = RENDER_TARGET_MS;
+Presenter presenter;
 
 // Focal length in pixels (for a 90° FOV).
 float f = SCREEN_WIDTH / 2.0f;
 
+// Every thread reads running, so it only goes through isRunning/stopRunning
+// The signal handler can't safely touch that, it sets stopRequested and the server loop passes it on
 int running = 1;
+volatile sig_atomic_t stopRequested = 0;
 int paused = 0;
+
+static inline int isRunning(void) {
+    return __atomic_load_n(&running, __ATOMIC_ACQUIRE);
+}
+
+static inline void stopRunning(void) {
+    __atomic_store_n(&running, 0, __ATOMIC_RELEASE);
+}
 int firstPerson = 0;
 
 const float LINE_THRESHOLD_SQR = LINE_THRESHOLD * LINE_THRESHOLD;
@@ -191,171 +481,324 @@ const float CLAMPED_THRESHOLD_SQR = CLAMPED_THRESHOLD * CLAMPED_THRESHOLD;
 SDL_Event event; 
 
 void loadObject(const char* filename, Object* object, float scale) {
-    object->triangle_count = 0;
-    
-    FILE* file = fopen(filename, "rb");
-    if (!file) {
-        printf("Failed to open file: %s\n", filename);
-        return;
-    }
-    
-    fseek(file, 0, SEEK_END);
-    size_t file_size = ftell(file);
-    rewind(file);
-    
-    object->triangle_count = file_size / sizeof(Triangle);
-    object->triangles = (Triangle*)malloc(object->triangle_count * sizeof(Triangle));
-    if (!object->triangles) {
-        printf("Failed to allocate memory for triangles\n");
-        fclose(file);
-        return;
-    }
-    
-    fread(object->triangles, sizeof(Triangle), object->triangle_count, file);
-    fclose(file);
+    // Meshes are mapped once and shared, the scale becomes part of the object's transform
+    // If it isn't loaded yet the loader does it in the background and meshLoaded fills it in later
+    int handle;
+    object->mesh = loaderRequestMesh(&assetLoader, filename, &handle);
+    object->loadingMesh = handle >= 0 ? handle + 1 : 0;
+    object->scale = scale;
+}
 
-    // Scale the object
-    for (size_t i = 0; i < object->triangle_count; i++) {
-        for (int j = 0; j < 3; j++) { // Each vertex has 3 coordinates (x, y, z)
-            object->triangles[i].v1[j] *= scale;
-            object->triangles[i].v2[j] *= scale;
-            object->triangles[i].v3[j] *= scale;
-        }
+// Loader callback, runs on the simulation thread, everything that was waiting on the file gets its mesh
+void meshLoaded(int handle, const Mesh* mesh, void* user) {
+    (void)user;
+    for (int j = 0; j < numObjects; j++) {
+        Object* object = &objects[j];
+        if (object->loadingMesh != handle + 1) continue;
+        object->loadingMesh = 0;
+        if (!mesh) continue; // Couldn't be loaded, it just doesn't get drawn, same as before there was a loader
+        object->mesh = mesh;
+        // The offset addObject gives anything whose mesh was already there
+        object->position[0] += mesh->center[0] * object->scale;
+        object->position[1] += mesh->center[1] * object->scale;
+        object->position[2] += mesh->center[2] * object->scale;
     }
 }
 
-uint64_t addObject(const char* filename, float scale, float posX, float posY, float posZ, unsigned int color, uint8_t id) {
-    
-    // Expand objects list to fit one more object
-    numObjects++;
-    objects = (Object*)realloc(objects, numObjects * sizeof(Object));
-    if (!objects) {
-        printf("Failed to allocate memory for objects list\n");
-        return -1;
-    }
-    
-    uint64_t index = numObjects - 1;
+// Model space direction (like a normal) to world space, no translation or scale
+static inline void objectDirectionToWorld(const Object* object, const float model[3], float world[3]) {
+    world[0] = -model[0] * object->forward[0] + model[1] * object->up[0] + model[2] * object->right[0];
+    world[1] = -model[0] * object->forward[1] + model[1] * object->up[1] + model[2] * object->right[1];
+    world[2] = -model[0] * object->forward[2] + model[1] * object->up[2] + model[2] * object->right[2];
+}
 
-    // Load the object's mesh data
-    loadObject(filename, &objects[numObjects - 1], scale * 2);
-    
-    // Apply the X offset to all triangle vertices
-    for (size_t i = 0; i < objects[numObjects - 1].triangle_count; i++) {
-		objects[numObjects - 1].triangles[i].v1[0] += posX;
-		objects[numObjects - 1].triangles[i].v2[0] += posX;
-		objects[numObjects - 1].triangles[i].v3[0] += posX;
-    }
-    // Apply the Y offset to all triangle vertices
-    for (size_t i = 0; i < objects[numObjects - 1].triangle_count; i++) {
-		objects[numObjects - 1].triangles[i].v1[1] += posY;
-		objects[numObjects - 1].triangles[i].v2[1] += posY;
-		objects[numObjects - 1].triangles[i].v3[1] += posY;
-    }
-    // Apply the Z offset to all triangle vertices
-    for (size_t i = 0; i < objects[numObjects - 1].triangle_count; i++) {
-		objects[numObjects - 1].triangles[i].v1[2] += posZ;
-		objects[numObjects - 1].triangles[i].v2[2] += posZ;
-		objects[numObjects - 1].triangles[i].v3[2] += posZ;
-    }    
-    
-    // Initialize all values
-    objects[index].id = id;
-    objects[index].color = color;
+// Model space vertex to world space, rotated around the mesh center by the object's orientation
+// Meshes face -X with +Y up and +Z right, which is what forward/up/right start out as
+static inline void objectToWorld(const Object* object, const float model[3], float world[3]) {
+    float x = (model[0] - object->mesh->center[0]) * object->scale;
+    float y = (model[1] - object->mesh->center[1]) * object->scale;
+    float z = (model[2] - object->mesh->center[2]) * object->scale;
+
+    world[0] = object->position[0] - x * object->forward[0] + y * object->up[0] + z * object->right[0];
+    world[1] = object->position[1] - x * object->forward[1] + y * object->up[1] + z * object->right[1];
+    world[2] = object->position[2] - x * object->forward[2] + y * object->up[2] + z * object->right[2];
+}
+
+// Same two for the renderer's copy of an object
+static inline void transformDirectionToWorld(const RenderTransform* transform, const float model[3], float world[3]) {
+    world[0] = -model[0] * transform->forward[0] + model[1] * transform->up[0] + model[2] * transform->right[0];
+    world[1] = -model[0] * transform->forward[1] + model[1] * transform->up[1] + model[2] * transform->right[1];
+    world[2] = -model[0] * transform->forward[2] + model[1] * transform->up[2] + model[2] * transform->right[2];
+}
+
+static inline void transformToWorld(const RenderTransform* transform, const float model[3], float world[3]) {
+    float x = (model[0] - transform->mesh->center[0]) * transform->scale;
+    float y = (model[1] - transform->mesh->center[1]) * transform->scale;
+    float z = (model[2] - transform->mesh->center[2]) * transform->scale;
+
+    world[0] = transform->position[0] - x * transform->forward[0] + y * transform->up[0] + z * transform->right[0];
+    world[1] = transform->position[1] - x * transform->forward[1] + y * transform->up[1] + z * transform->right[1];
+    world[2] = transform->position[2] - x * transform->forward[2] + y * transform->up[2] + z * transform->right[2];
+}
+
+// Sets up everything about an object except its mesh and path memory, based on its id
+int setupObject(Object* object, float scale, unsigned int color, uint8_t id) {
+    object->id = id;
+    object->color = color;
 			
-    objects[index].velX = 0;
-    objects[index].velY = 0;
-    objects[index].velZ = 0;
+    object->velX = 0;
+    object->velY = 0;
+    object->velZ = 0;
 			
-    objects[index].forward[0] = -1.0f;  // X-direction
-	objects[index].forward[1] = 0.0f;  // Y-direction
-	objects[index].forward[2] = 0.0f;  // Z-direction
+    object->forward[0] = -1.0f;  // X-direction
+	object->forward[1] = 0.0f;  // Y-direction
+	object->forward[2] = 0.0f;  // Z-direction
 			
-	objects[index].up[0] = 0.0f;  // X-direction
-	objects[index].up[1] = 1.0f;  // Y-direction
-	objects[index].up[2] = 0.0f;  // Z-direction
+	object->up[0] = 0.0f;  // X-direction
+	object->up[1] = 1.0f;  // Y-direction
+	object->up[2] = 0.0f;  // Z-direction
 			
-	objects[index].right[0] = 0.0f;  // X-direction
-	objects[index].right[1] = 0.0f;  // Y-direction
-	objects[index].right[2] = 1.0f;  // Z-direction
-	
-	calculateObjectCenter(&objects[index], objects[index].position);
+	object->right[0] = 0.0f;  // X-direction
+	object->right[1] = 0.0f;  // Y-direction
+	object->right[2] = 1.0f;  // Z-direction
 		
-	objects[index].pathing.numDestinations = 0;
+	object->pathing.numDestinations = 0;
 	if (id == 10) { // viper
-		objects[index].pathing.destinations = (PathDestination*)malloc(sizeof(PathDestination));
-		objects[index].parameters.minChaseDistance = 50.0f;
-		objects[index].parameters.maxChaseDistance = 100000.0f;
-		objects[index].parameters.forwardSpeed = 5.0f;
-		objects[index].parameters.backwardSpeed = 3.0f;
-		objects[index].parameters.rollSpeed = 0.1f;
-		objects[index].parameters.pitchSpeed = 0.05f;
-		objects[index].parameters.yawSpeed = 0.02f;
-		objects[index].parameters.drag = 0.95f;
-		objects[index].mob.personality = 0b10000000;
-		objects[index].invincible = 0;
-		objects[index].invisible = 0;
-		objects[index].avoidanceRadius = 20;
-		objects[index].mass = 1E2; 
-		objects[index].parameters.drag = 0.95f;
+		object->parameters.minChaseDistance = 50.0f;
+		object->parameters.maxChaseDistance = 100000.0f;
+		object->parameters.forwardSpeed = 5.0f;
+		object->parameters.backwardSpeed = 3.0f;
+		object->parameters.rollSpeed = 0.1f;
+		object->parameters.pitchSpeed = 0.05f;
+		object->parameters.yawSpeed = 0.02f;
+		object->parameters.drag = 0.95f;
+		object->mob.personality = 0b10000000;
+		object->invincible = 0;
+		object->invisible = 0;
+		object->avoidanceRadius = 20;
+		object->mass = 1E2; 
+		object->parameters.drag = 0.95f;
 	} else if (id == 0) { // cobra (player)
-		objects[index].pathing.destinations = (PathDestination*)malloc(sizeof(PathDestination));
-		objects[index].parameters.minChaseDistance = 50.0f;
-		objects[index].parameters.maxChaseDistance = 1000.0f;
-		objects[index].parameters.forwardSpeed = 7.0f;
-		objects[index].parameters.backwardSpeed = 3.0f;
-		objects[index].parameters.rollSpeed = 0.1f;
-		objects[index].parameters.pitchSpeed = 0.03f;
-		objects[index].parameters.yawSpeed = 0.02f;
-		objects[index].parameters.drag = 0.95f;
-		objects[index].mob.personality = 0b00000000;
-		objects[index].invincible = 0;
-		objects[index].invisible = 0;
-		objects[index].avoidanceRadius = 30;
-		objects[index].mass = 1E2;
-		objects[index].parameters.drag = 0.95f;
+		object->parameters.minChaseDistance = 50.0f;
+		object->parameters.maxChaseDistance = 1000.0f;
+		object->parameters.forwardSpeed = 7.0f;
+		object->parameters.backwardSpeed = 3.0f;
+		object->parameters.rollSpeed = 0.1f;
+		object->parameters.pitchSpeed = 0.03f;
+		object->parameters.yawSpeed = 0.02f;
+		object->parameters.drag = 0.95f;
+		object->mob.personality = 0b00000000;
+		object->invincible = 0;
+		object->invisible = 0;
+		object->avoidanceRadius = 30;
+		object->mass = 1E2;
+		object->parameters.drag = 0.95f;
 	} else if (id == 1) { // planet
-		objects[index].invincible = 1;
-		objects[index].invisible = 0;
-		objects[index].avoidanceRadius = scale + 50;
-		objects[index].velZ = 0.0f;
-		objects[index].mass = 1E6;
-		objects[index].parameters.drag = 1;
-		objects[index].planetIndex = numPlanets;
+		object->invincible = 1;
+		object->invisible = 0;
+		object->avoidanceRadius = scale + 50;
+		object->velZ = 0.0f;
+		object->mass = 1E6;
+		object->parameters.drag = 1;
+		object->planetIndex = numPlanets;
 		numPlanets++;
 		planets = (Planet*)realloc(planets, (numPlanets + 1) * sizeof(Planet));
 	    if (!planets) {
-	        printf("Failed to allocate memory for planet list\n");
+	        LOG_ERROR("Failed to allocate memory for planet list\n");
 	        return -1;
 	    }
-		planets[objects[index].planetIndex].spin = 1.0f;
+		planets[object->planetIndex].spin = 1.0f;
 	} else if (id == 2) { // star
-		objects[index].invincible = 1;
-		objects[index].invisible = 0;
-		objects[index].avoidanceRadius = scale + 100;
-		objects[index].mass = 1E18;
-		objects[index].parameters.drag = 1;
-		objects[index].starIndex = numStars;
+		object->invincible = 1;
+		object->invisible = 0;
+		object->avoidanceRadius = scale + 100;
+		object->mass = 1E18;
+		object->parameters.drag = 1;
+		object->starIndex = numStars;
 		numStars++;
 		stars = (Star*)realloc(stars, (numStars + 1) * sizeof(Star));
 	    if (!stars) {
-	        printf("Failed to allocate memory for star list\n");
+	        LOG_ERROR("Failed to allocate memory for star list\n");
 	        return -1;
 	    }
-		stars[objects[index].starIndex].spin = 0.005 * M_PI / 180;
+		stars[object->starIndex].spin = 0.005 * M_PI / 180;
+	} else if (id == 3) { // station, no mesh of its own yet so it's a big cobra
+		object->invincible = 1;
+		object->invisible = 0;
+		object->avoidanceRadius = scale + 50;
+		object->mass = 1E5;
+		object->parameters.drag = 1;
+	}
+	return 0;
+}
+
+uint64_t addObject(const char* filename, float scale, float posX, float posY, float posZ, unsigned int color, uint8_t id) {
+    uint64_t index;
+    if (numAvailableObjectIndexes > 0) {
+        // Fill a hole left by removeObject first
+        index = availableObjectIndexes[--numAvailableObjectIndexes];
+    } else {
+        // Expand objects list, doubling so adding lots one at a time doesn't realloc every time
+        if (numObjects == objectCapacity) {
+            int capacity = objectCapacity ? objectCapacity * 2 : 64;
+            Object* newObjects = (Object*)realloc(objects, capacity * sizeof(Object));
+            if (!newObjects) {
+                LOG_ERROR("Failed to allocate memory for objects list\n");
+                return -1;
+            }
+            objects = newObjects;
+            objectCapacity = capacity;
+        }
+        index = numObjects++;
+    }
+    memset(&objects[index], 0, sizeof(Object));
+
+    // Load the object's mesh data
+    loadObject(filename, &objects[index], scale * 2);
+    
+    // The mesh center ends up at the offset, same place the old per-vertex offset put it
+    objects[index].position[0] = posX;
+    objects[index].position[1] = posY;
+    objects[index].position[2] = posZ;
+    if (objects[index].mesh) {
+        objects[index].position[0] += objects[index].mesh->center[0] * objects[index].scale;
+        objects[index].position[1] += objects[index].mesh->center[1] * objects[index].scale;
+        objects[index].position[2] += objects[index].mesh->center[2] * objects[index].scale;
+    }
+    
+    // Initialize all values
+    if (setupObject(&objects[index], scale, color, id) != 0) return -1;
+	if (id == 10 || id == 0) { // Ships get a path list
+		objects[index].pathing.destinations = (PathDestination*)malloc(sizeof(PathDestination));
 	}
 	return index; // Return the index, so the caller can know directly what index was created
 }
 
+// Spawns everything a scene file lists, with one allocation for the object list
+// and one for all the path destinations, meshes are shared so instances cost nothing extra
+int spawnScene(const Scene* scene) {
+	if (scene->numInstances == 0) return 0;
+
+	// Map every referenced mesh up front, instances just point at them
+	const Mesh** sceneMeshes = (const Mesh**)calloc(scene->numMeshes, sizeof(Mesh*));
+	if (!sceneMeshes) {
+		printf("Failed to allocate memory for scene meshes\n");
+		return -1;
+	}
+	for (uint32_t i = 0; i < scene->numMeshes; i++) {
+		sceneMeshes[i] = getMesh(scene->meshes[i].file);
+	}
+
+	// Count up how much path memory the instances need
+	size_t totalDestinations = 0;
+	for (uint32_t i = 0; i < scene->numInstances; i++) {
+		const SceneArchetype* archetype = &scene->archetypes[scene->instances[i].archetype];
+		if (archetype->id == 10 || archetype->id == 0) totalDestinations++;
+	}
+
+	Object* newObjects = (Object*)realloc(objects, (numObjects + scene->numInstances) * sizeof(Object));
+	PathDestination* pathPool = (PathDestination*)malloc((totalDestinations + 1) * sizeof(PathDestination));
+	if (!newObjects || !pathPool) {
+		printf("Failed to allocate memory for scene objects\n");
+		if (newObjects) objects = newObjects;
+		free(pathPool);
+		free(sceneMeshes);
+		return -1;
+	}
+	objects = newObjects;
+	objectCapacity = numObjects + scene->numInstances;
+	memset(&objects[numObjects], 0, scene->numInstances * sizeof(Object));
+
+	PathDestination* nextDestination = pathPool;
+
+	// Only objects that got all the way through setupObject get counted
+	uint32_t spawned = 0;
+	for (uint32_t i = 0; i < scene->numInstances; i++) {
+		const SceneInstance* instance = &scene->instances[i];
+		const SceneArchetype* archetype = &scene->archetypes[instance->archetype];
+		Object* object = &objects[numObjects + i];
+
+		// Same scale and placement addObject does
+		object->mesh = sceneMeshes[archetype->mesh];
+		object->scale = archetype->scale * 2;
+		for (int j = 0; j < 3; j++) {
+			object->position[j] = instance->position[j];
+			if (object->mesh) object->position[j] += object->mesh->center[j] * object->scale;
+		}
+
+		if (setupObject(object, archetype->scale, archetype->color, archetype->id) != 0) {
+			printf("Failed to set up scene instance %u, stopping at %u objects\n", i, spawned);
+			break;
+		}
+
+		// Ships start out chasing the origin, like main() used to set up for the vipers
+		if (archetype->id == 10 || archetype->id == 0) {
+			object->pathing.destinations = nextDestination++;
+			object->pooled |= POOLED_PATH;
+			if (archetype->id == 10) {
+				object->pathing.destinations[0] = (PathDestination){.position = {0, 0, 0}, .velX = 0, .velY = 0, .velZ = 0, .strength = 1.0f};
+				object->pathing.numDestinations = 1;
+			}
+		}
+		spawned++;
+	}
+	numObjects += spawned;
+	free(sceneMeshes);
+
+	// Keep the pool around so freeObjects can release it, even after a failure the objects that were set up use it
+	void** newPools = (void**)realloc(objectPools, (numObjectPools + 1) * sizeof(void*));
+	if (!newPools) {
+		printf("Failed to allocate memory for object pool list\n");
+		return -1;
+	}
+	objectPools = newPools;
+	objectPools[numObjectPools++] = pathPool;
+
+	return spawned == scene->numInstances ? 0 : -1;
+}
+
+// Planets and stars keep their entries packed, the last one moves into the hole and whoever owned it gets told
+static void removePlanet(uint32_t planetIndex) {
+	uint32_t last = --numPlanets;
+	if (planetIndex == last) return;
+	planets[planetIndex] = planets[last];
+	for (int i = 0; i < numObjects; i++) {
+		if (objects[i].id == 1 && objects[i].planetIndex == last) {
+			objects[i].planetIndex = planetIndex;
+			break;
+		}
+	}
+}
+
+static void removeStar(uint32_t starIndex) {
+	uint32_t last = --numStars;
+	if (starIndex == last) return;
+	stars[starIndex] = stars[last];
+	for (int i = 0; i < numObjects; i++) {
+		if (objects[i].id == 2 && objects[i].starIndex == last) {
+			objects[i].starIndex = starIndex;
+			break;
+		}
+	}
+}
+
 void removeObject(uint32_t index) {
-	// First, free  up all the allocated memory
-	free(objects[index].triangles);
-	free(objects[index].pathing.destinations);
-	
-	// Don't 'remove' the object index, just set literally everything to 0
-	objects[index].triangle_count = 0;
+	// First, free  up all the allocated memory, unless it's part of a bulk allocation
+	if (!(objects[index].pooled & POOLED_PATH)) free(objects[index].pathing.destinations);
+	if (objects[index].id == 1 && objects[index].planetIndex < (uint32_t)numPlanets) removePlanet(objects[index].planetIndex);
+	if (objects[index].id == 2 && objects[index].starIndex < (uint32_t)numStars) removeStar(objects[index].starIndex);
+	objects[index].mesh = NULL;
+	objects[index].pathing.destinations = NULL;
+	objects[index].pathing.numDestinations = 0;
+	objects[index].pooled = 0;
+	objects[index].loadingMesh = 0;
 	
-	objects[index].id = 0;
+	// Don't 'remove' the object index, just set literally everything to 0, 255 marks it as empty
+	objects[index].id = 255;
     objects[index].color = 0;
+    objects[index].invisible = 1;
+    objects[index].mass = 0;
+    objects[index].avoidanceRadius = 0;
 			
     objects[index].velX = 0;
     objects[index].velY = 0;
@@ -373,8 +816,18 @@ void removeObject(uint32_t index) {
 	objects[index].right[1] = 0.0f;  
 	objects[index].right[2] = 0.0f;  
 	
-	// List it as available
-	// todo ^
+	// List it as available, addObject takes it back before growing the list
+	if (numAvailableObjectIndexes == availableObjectCapacity) {
+		int capacity = availableObjectCapacity ? availableObjectCapacity * 2 : 64;
+		int* indexes = (int*)realloc(availableObjectIndexes, capacity * sizeof(int));
+		if (!indexes) {
+			LOG_ERROR("Failed to allocate memory for available object list\n");
+			return; // Just stays empty forever
+		}
+		availableObjectIndexes = indexes;
+		availableObjectCapacity = capacity;
+	}
+	availableObjectIndexes[numAvailableObjectIndexes++] = index;
 }
 
 // Function to rotate a 3D point around the X-axis (pitch)
@@ -402,75 +855,9 @@ void rotateZ(float point[3], float angle) {
 }
 
 void rotateObject(Object* object, float pitch, float yaw, float roll) {
-    if (!object || !object->triangles) return;
-
-    // Compute object's center by averaging all triangle vertices
-    float center[3] = {0.0f, 0.0f, 0.0f};
-
-    for (size_t i = 0; i < object->triangle_count; i++) {
-        Triangle* tri = &object->triangles[i];
-
-        center[0] += (tri->v1[0] + tri->v2[0] + tri->v3[0]) / 3.0f;
-        center[1] += (tri->v1[1] + tri->v2[1] + tri->v3[1]) / 3.0f;
-        center[2] += (tri->v1[2] + tri->v2[2] + tri->v3[2]) / 3.0f;
-    }
-
-    center[0] /= object->triangle_count;
-    center[1] /= object->triangle_count;
-    center[2] /= object->triangle_count;
-
-    // Translate object to origin
-    for (size_t i = 0; i < object->triangle_count; i++) {
-        Triangle* tri = &object->triangles[i];
-
-        tri->v1[0] -= center[0];
-        tri->v1[1] -= center[1];
-        tri->v1[2] -= center[2];
-
-        tri->v2[0] -= center[0];
-        tri->v2[1] -= center[1];
-        tri->v2[2] -= center[2];
-
-        tri->v3[0] -= center[0];
-        tri->v3[1] -= center[1];
-        tri->v3[2] -= center[2];
-    }
-
-    // Rotate around the local origin (center)
-    for (size_t i = 0; i < object->triangle_count; i++) {
-        Triangle* tri = &object->triangles[i];
-
-        rotateX(tri->v1, pitch);
-        rotateY(tri->v1, yaw);
-        rotateZ(tri->v1, roll);
-
-        rotateX(tri->v2, pitch);
-        rotateY(tri->v2, yaw);
-        rotateZ(tri->v2, roll);
-
-        rotateX(tri->v3, pitch);
-        rotateY(tri->v3, yaw);
-        rotateZ(tri->v3, roll);
-    }
-
-    // Translate object back to its original position
-    for (size_t i = 0; i < object->triangle_count; i++) {
-        Triangle* tri = &object->triangles[i];
-
-        tri->v1[0] += center[0];
-        tri->v1[1] += center[1];
-        tri->v1[2] += center[2];
-
-        tri->v2[0] += center[0];
-        tri->v2[1] += center[1];
-        tri->v2[2] += center[2];
-
-        tri->v3[0] += center[0];
-        tri->v3[1] += center[1];
-        tri->v3[2] += center[2];
-    }
+    if (!object || !object->mesh) return;
 
-    // Rotate the forward vector
+    // The mesh is drawn through the orientation vectors, so rotating those rotates the object around its center
     rotateX(object->forward, pitch);
     rotateY(object->forward, yaw);
     rotateZ(object->forward, roll);
@@ -485,7 +872,7 @@ void rotateObject(Object* object, float pitch, float yaw, float roll) {
 }
 
 void rotateObjectAroundAxis(Object* object, float axis[3], float angle) {
-    if (!object || !object->triangles) return;
+    if (!object || !object->mesh) return;
 
     float cosA = cos(angle);
     float sinA = sin(angle);
@@ -515,18 +902,6 @@ void rotateObjectAroundAxis(Object* object, float axis[3], float angle) {
         }
     };
 
-    // Compute object's center
-    float center[3] = {0.0f, 0.0f, 0.0f};
-    for (size_t i = 0; i < object->triangle_count; i++) {
-        Triangle* tri = &object->triangles[i];
-        center[0] += (tri->v1[0] + tri->v2[0] + tri->v3[0]) / 3.0f;
-        center[1] += (tri->v1[1] + tri->v2[1] + tri->v3[1]) / 3.0f;
-        center[2] += (tri->v1[2] + tri->v2[2] + tri->v3[2]) / 3.0f;
-    }
-    center[0] /= object->triangle_count;
-    center[1] /= object->triangle_count;
-    center[2] /= object->triangle_count;
-
     // Function to apply rotation matrix to a point
     void applyRotation(float point[3], float rotationMatrix[3][3], float center[3]) {
         float temp[3] = { point[0] - center[0], point[1] - center[1], point[2] - center[2] };
@@ -540,15 +915,7 @@ void rotateObjectAroundAxis(Object* object, float axis[3], float angle) {
         point[2] = rotated[2] + center[2];
     }
 
-    // Rotate all vertices and orientation vectors
-    for (size_t i = 0; i < object->triangle_count; i++) {
-        Triangle* tri = &object->triangles[i];
-
-        applyRotation(tri->v1, rotationMatrix, center);
-        applyRotation(tri->v2, rotationMatrix, center);
-        applyRotation(tri->v3, rotationMatrix, center);
-    }
-
+    // Only the orientation vectors, the vertices follow them when drawn
     applyRotation(object->forward, rotationMatrix, (float[3]){0, 0, 0});
     applyRotation(object->up, rotationMatrix, (float[3]){0, 0, 0});
     applyRotation(object->right, rotationMatrix, (float[3]){0, 0, 0});
@@ -675,47 +1042,12 @@ void rotatePointByQuaternion(float point[3], Quaternion q) {
 
 // Function to rotate the entire object with a quaternion
 void rotateObjectByQuaternion(Object* object, Quaternion q) {
-    if (!object || !object->triangles) return;
+    if (!object || !object->mesh) return;
 
-    // Rotate orientation vectors
+    // Rotate orientation vectors, the vertices follow them when drawn
     rotatePointByQuaternion(object->forward, q);
     rotatePointByQuaternion(object->up, q);
     rotatePointByQuaternion(object->right, q);
-
-    // Compute object center
-    float center[3] = {0.0f, 0.0f, 0.0f};
-    for (size_t i = 0; i < object->triangle_count; i++) {
-        Triangle* tri = &object->triangles[i];
-        center[0] += (tri->v1[0] + tri->v2[0] + tri->v3[0]) / 3.0f;
-        center[1] += (tri->v1[1] + tri->v2[1] + tri->v3[1]) / 3.0f;
-        center[2] += (tri->v1[2] + tri->v2[2] + tri->v3[2]) / 3.0f;
-    }
-    center[0] /= object->triangle_count;
-    center[1] /= object->triangle_count;
-    center[2] /= object->triangle_count;
-
-    // Rotate all vertices around the object center
-    for (size_t i = 0; i < object->triangle_count; i++) {
-        Triangle* tri = &object->triangles[i];
-
-        // Move vertices to origin, rotate, then move back
-        for (int v = 0; v < 3; v++) {
-            float* vertex = (v == 0) ? tri->v1 : (v == 1) ? tri->v2 : tri->v3;
-
-            // Translate to origin
-            vertex[0] -= center[0];
-            vertex[1] -= center[1];
-            vertex[2] -= center[2];
-
-            // Rotate
-            rotatePointByQuaternion(vertex, q);
-
-            // Translate back
-            vertex[0] += center[0];
-            vertex[1] += center[1];
-            vertex[2] += center[2];
-        }
-    }
 }
 
 // Spherical Linear Interpolation (SLERP) between two quaternions
@@ -773,7 +1105,8 @@ Quaternion slerp(Quaternion q1, Quaternion q2, float t) {
 }
 
 // Function to smoothly rotate an object toward a target point in space
-void turnTowardsPoint(Object* object, float target[3]) {
+// ticks is how many ticks worth of turning to do, for objects that don't steer every tick
+void turnTowardsPoint(Object* object, float target[3], int ticks) {
     if (!object) return;
 
     // Compute direction to target
@@ -796,7 +1129,7 @@ void turnTowardsPoint(Object* object, float target[3]) {
     float angle = acos(dotProduct);
 
     // Clamp the rotation angle to the max average turn rate
-    float maxRotation = (object->parameters.yawSpeed + object->parameters.pitchSpeed + object->parameters.rollSpeed) /3;
+    float maxRotation = (object->parameters.yawSpeed + object->parameters.pitchSpeed + object->parameters.rollSpeed) /3 * ticks;
     float t = fmin(1.0f, maxRotation / angle);
 
     // Interpolate using the clamped factor
@@ -856,32 +1189,18 @@ Quaternion normalizeQuaternion(Quaternion q) {
     return (Quaternion){q.w / mag, q.x / mag, q.y / mag, q.z / mag};
 }
 
-void addRandomPerturbation(float vector[3], float strength) {
-    vector[0] += ((float)rand() / RAND_MAX * 2.0f - 1.0f) * strength;
-    vector[1] += ((float)rand() / RAND_MAX * 2.0f - 1.0f) * strength;
-    vector[2] += ((float)rand() / RAND_MAX * 2.0f - 1.0f) * strength;
+// random is 3 uniform floats in [0, 1), from the worker's batch
+void addRandomPerturbation(float vector[3], float strength, const float random[3]) {
+    vector[0] += (random[0] * 2.0f - 1.0f) * strength;
+    vector[1] += (random[1] * 2.0f - 1.0f) * strength;
+    vector[2] += (random[2] * 2.0f - 1.0f) * strength;
 }
 
-// Move an object, yes it's practically hijacked from the loadObject function
+// Move an object, only the center moves, the vertices are placed relative to it
 void moveObject(Object* object, float moveX, float moveY, float moveZ) {
-    // Apply the X movement to all triangle vertices
-    for (size_t i = 0; i < object->triangle_count; i++) {
-		object->triangles[i].v1[0] += moveX;
-		object->triangles[i].v2[0] += moveX;
-		object->triangles[i].v3[0] += moveX;
-    }
-    // Apply the Y movement to all triangle vertices
-    for (size_t i = 0; i < object->triangle_count; i++) {
-		object->triangles[i].v1[1] += moveY;
-		object->triangles[i].v2[1] += moveY;
-		object->triangles[i].v3[1] += moveY;
-    }
-    // Apply the Z movement to all triangle vertices
-    for (size_t i = 0; i < object->triangle_count; i++) {
-		object->triangles[i].v1[2] += moveZ;
-		object->triangles[i].v2[2] += moveZ;
-		object->triangles[i].v3[2] += moveZ;
-    }
+    object->position[0] += moveX;
+    object->position[1] += moveY;
+    object->position[2] += moveZ;
 }
 
 void saveToBMP(unsigned char* pixels, const char* filename) {
@@ -909,19 +1228,19 @@ void saveToBMP(unsigned char* pixels, const char* filename) {
     };
 
     // Set the width and height in the info header (in little-endian format)
-    infoHeader[4] = SCREEN_WIDTH & 0xFF;
-    infoHeader[5] = (SCREEN_WIDTH >> 8) & 0xFF;
-    infoHeader[6] = (SCREEN_WIDTH >> 16) & 0xFF;
-    infoHeader[7] = (SCREEN_WIDTH >> 24) & 0xFF;
+    infoHeader[4] = renderWidth & 0xFF;
+    infoHeader[5] = (renderWidth >> 8) & 0xFF;
+    infoHeader[6] = (renderWidth >> 16) & 0xFF;
+    infoHeader[7] = (renderWidth >> 24) & 0xFF;
 
-    infoHeader[8] = SCREEN_HEIGHT & 0xFF;
-    infoHeader[9] = (SCREEN_HEIGHT >> 8) & 0xFF;
-    infoHeader[10] = (SCREEN_HEIGHT >> 16) & 0xFF;
-    infoHeader[11] = (SCREEN_HEIGHT >> 24) & 0xFF;
+    infoHeader[8] = renderHeight & 0xFF;
+    infoHeader[9] = (renderHeight >> 8) & 0xFF;
+    infoHeader[10] = (renderHeight >> 16) & 0xFF;
+    infoHeader[11] = (renderHeight >> 24) & 0xFF;
 
     // Calculate the row size (padded to a multiple of 4 bytes)
-    int rowSize = (SCREEN_WIDTH * 3 + 3) & ~3;  // Round up to multiple of 4
-    int imageSize = rowSize * SCREEN_HEIGHT;
+    int rowSize = (renderWidth * 3 + 3) & ~3;  // 24 bit in the file, round up to multiple of 4
+    int imageSize = rowSize * renderHeight;
 
     // Update file size and image size in headers
     fileHeader[2] = (imageSize + 54) & 0xFF;
@@ -941,19 +1260,17 @@ void saveToBMP(unsigned char* pixels, const char* filename) {
     fwrite(infoHeader, sizeof(uint8_t), 40, file);
 
     // Write pixel data
-    for (int y = 0; y < SCREEN_HEIGHT; ++y) {
-        for (int x = 0; x < SCREEN_WIDTH; ++x) {
+    for (int y = 0; y < renderHeight; ++y) {
+        for (int x = 0; x < renderWidth; ++x) {
             // Get pixel color
-            unsigned char* pixel = &pixels[(y * SCREEN_WIDTH + x) * 3];
+            unsigned char* pixel = &pixels[(y * renderWidth + x) * BYTES_PER_PIXEL];
             
-            // Write RGB (pixel[2] is Red, pixel[1] is Green, pixel[0] is Blue)
-            fwrite(&pixel[2], sizeof(uint8_t), 1, file);  // Red
-            fwrite(&pixel[1], sizeof(uint8_t), 1, file);  // Green
-            fwrite(&pixel[0], sizeof(uint8_t), 1, file);  // Blue
+            // BMP wants blue, green, red, same order as the framebuffer, just without the 4th byte
+            fwrite(pixel, sizeof(uint8_t), 3, file);
         }
 
         // Write padding for the row if necessary (to ensure it is a multiple of 4 bytes)
-        int padding = rowSize - SCREEN_WIDTH * 3;
+        int padding = rowSize - renderWidth * 3;
         for (int i = 0; i < padding; ++i) {
             fputc(0, file);  // Write padding byte (0)
         }
@@ -964,22 +1281,12 @@ void saveToBMP(unsigned char* pixels, const char* filename) {
     printf("Image saved to %s\n", filename);
 }
 
-void handleInput(unsigned char* pixels) {
-    // Handle exit events, proably better to include this than to not
-    while (SDL_PollEvent(&event) != 0) {
-        if (event.type == SDL_QUIT) {
-            running = 0;
-        }
-    }
-    
-    const Uint8* state = SDL_GetKeyboardState(NULL);
-    
-    // Direction vectors
-    Vec3 forward = rotateVecByQuat((Vec3){0, 0, -1}, cameraOrientation);
-    Vec3 right = rotateVecByQuat((Vec3){1, 0, 0}, cameraOrientation);
-    Vec3 up = rotateVecByQuat((Vec3){0, 1, 0}, cameraOrientation);
+// The player's ship, runs on the simulation thread once per tick
+void handleSimInput(const SimInput* input) {
+    const Uint8* state = input->keys;
     
     // todo: review controls, make sure they make sense/are feasable
+    objects[0].ai.thrust = state[SDL_SCANCODE_W] ? MOVEMENT_DAMPENING : 0.0f; // Only for the engine trail, the AI doesn't steer it
     if (state[SDL_SCANCODE_W]) {
         objects[0].velX += objects[0].forward[0] * MOVEMENT_DAMPENING * objects[0].parameters.forwardSpeed;
         objects[0].velY += objects[0].forward[1] * MOVEMENT_DAMPENING * objects[0].parameters.forwardSpeed;
@@ -1012,43 +1319,80 @@ void handleInput(unsigned char* pixels) {
 	    rotateObjectAroundAxis(&objects[0], objects[0].right, objects[0].parameters.pitchSpeed);
 	}
 	
+	// Don't draw the player's own ship from the inside
+	objects[0].invisible = input->firstPerson;
+	
+	// Saved in between ticks, so nothing's halfway through changing, only once per press
+	static int saveHeld = 0;
+	if (state[SDL_SCANCODE_F5] && !saveHeld) {
+	    uint64_t start = SDL_GetPerformanceCounter();
+	    if (saveWorld(QUICKSAVE_FILE, input->cameraPosition) == 0) {
+	        LOG_INFO("Saved %d objects to %s in %.2f ms\n", numObjects, QUICKSAVE_FILE,
+	                 (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+	    } else {
+	        LOG_ERROR("Failed to save to %s\n", QUICKSAVE_FILE);
+	    }
+	}
+	saveHeld = state[SDL_SCANCODE_F5];
+	
+	Uint32 currentTime = SDL_GetTicks(); // Get current time in milliseconds
+	
+	if (state[SDL_SCANCODE_B] && (currentTime - flockTime >= 1000)) {
+		flocking = flocking ? 0 : 1;
+		LOG_INFO("Flocking %s\n", flocking ? "on" : "off");
+		flockTime = currentTime; // Update the last execution time
+	}
+}
+
+// Camera, view toggles and pause, runs on the main thread every frame
+// ticks is the frame time in default length ticks (1 / TICK_RATE s), so the camera moves at the same speed whatever the fps
+void handleCameraInput(unsigned char* pixels, float ticks) {
+    const Uint8* state = SDL_GetKeyboardState(NULL);
+    
+    // Direction vectors
+    Vec3 forward = rotateVecByQuat((Vec3){0, 0, -1}, cameraOrientation);
+    Vec3 right = rotateVecByQuat((Vec3){1, 0, 0}, cameraOrientation);
+    Vec3 up = rotateVecByQuat((Vec3){0, 1, 0}, cameraOrientation);
+    float speed = cameraSpeed * ticks;
+    float turn = TURN_SPEED * ticks;
+    
 	// Camera controls
 	if (state[SDL_SCANCODE_I]) {
-        cameraPos.x += forward.x * cameraSpeed;
-        cameraPos.y += forward.y * cameraSpeed;
-        cameraPos.z += forward.z * cameraSpeed;
+        cameraPos.x += forward.x * speed;
+        cameraPos.y += forward.y * speed;
+        cameraPos.z += forward.z * speed;
     }
     if (state[SDL_SCANCODE_K]) {
-        cameraPos.x -= forward.x * cameraSpeed;
-        cameraPos.y -= forward.y * cameraSpeed;
-        cameraPos.z -= forward.z * cameraSpeed;
+        cameraPos.x -= forward.x * speed;
+        cameraPos.y -= forward.y * speed;
+        cameraPos.z -= forward.z * speed;
     }
     if (state[SDL_SCANCODE_J]) {
-        cameraPos.x -= right.x * cameraSpeed;
-        cameraPos.y -= right.y * cameraSpeed;
-        cameraPos.z -= right.z * cameraSpeed;
+        cameraPos.x -= right.x * speed;
+        cameraPos.y -= right.y * speed;
+        cameraPos.z -= right.z * speed;
     }
     if (state[SDL_SCANCODE_L]) {
-        cameraPos.x += right.x * cameraSpeed;
-        cameraPos.y += right.y * cameraSpeed;
-        cameraPos.z += right.z * cameraSpeed;
+        cameraPos.x += right.x * speed;
+        cameraPos.y += right.y * speed;
+        cameraPos.z += right.z * speed;
     }
-    if (state[SDL_SCANCODE_LEFT]) rotateCamera(up, TURN_SPEED);      // Yaw left
-    if (state[SDL_SCANCODE_RIGHT]) rotateCamera(up, -TURN_SPEED);    // Yaw right
-    if (state[SDL_SCANCODE_UP]) rotateCamera(right, TURN_SPEED);     // Pitch up
-    if (state[SDL_SCANCODE_DOWN]) rotateCamera(right, -TURN_SPEED);  // Pitch down
-    if (state[SDL_SCANCODE_U]) rotateCamera(forward, -TURN_SPEED);   // Roll left
-    if (state[SDL_SCANCODE_O]) rotateCamera(forward, TURN_SPEED);    // Roll right
+    if (state[SDL_SCANCODE_LEFT]) rotateCamera(up, turn);      // Yaw left
+    if (state[SDL_SCANCODE_RIGHT]) rotateCamera(up, -turn);    // Yaw right
+    if (state[SDL_SCANCODE_UP]) rotateCamera(right, turn);     // Pitch up
+    if (state[SDL_SCANCODE_DOWN]) rotateCamera(right, -turn);  // Pitch down
+    if (state[SDL_SCANCODE_U]) rotateCamera(forward, -turn);   // Roll left
+    if (state[SDL_SCANCODE_O]) rotateCamera(forward, turn);    // Roll right
     
     if (state[SDL_SCANCODE_LSHIFT] || state[SDL_SCANCODE_SPACE]) {
-        cameraPos.x += up.x * cameraSpeed;
-        cameraPos.y += up.y * cameraSpeed;
-        cameraPos.z += up.z * cameraSpeed;
+        cameraPos.x += up.x * speed;
+        cameraPos.y += up.y * speed;
+        cameraPos.z += up.z * speed;
     }
     if (state[SDL_SCANCODE_LCTRL]) {
-        cameraPos.x -= up.x * cameraSpeed;
-        cameraPos.y -= up.y * cameraSpeed;
-        cameraPos.z -= up.z * cameraSpeed;
+        cameraPos.x -= up.x * speed;
+        cameraPos.y -= up.y * speed;
+        cameraPos.z -= up.z * speed;
     }
     
     Uint32 currentTime = SDL_GetTicks(); // Get current time in milliseconds
@@ -1056,7 +1400,6 @@ void handleInput(unsigned char* pixels) {
     if (state[SDL_SCANCODE_Z] && (currentTime - firstPersonTime >= 1000)) {
 		firstPerson = firstPerson ? 0 : 1;
 		freeLook = (firstPerson - 1) % 1;
-		objects[0].invisible = firstPerson;
 		firstPersonTime = currentTime; // Update the last execution time
 	}
 	if (state[SDL_SCANCODE_X] && (currentTime - freeLookTime >= 1000)) {
@@ -1064,6 +1407,14 @@ void handleInput(unsigned char* pixels) {
 		freeLookTime = currentTime; // Update the last execution time
 	}
 	
+	if (state[SDL_SCANCODE_M] && (currentTime - radarKeyTime >= 1000)) {
+		radarEnabled = radarEnabled ? 0 : 1;
+		radarKeyTime = currentTime;
+	}
+	if (state[SDL_SCANCODE_H] && (currentTime - hudKeyTime >= 1000)) {
+		hudEnabled = hudEnabled ? 0 : 1;
+		hudKeyTime = currentTime;
+	}
 	if (state[SDL_SCANCODE_P] && (currentTime - pauseTime >= 1000)) {
 		paused = paused ? 0 : 1;
 		pauseTime = currentTime; // Update the last execution time
@@ -1074,39 +1425,56 @@ void handleInput(unsigned char* pixels) {
 	}
 }
 
+// Camera space position of a point, z is the distance in front of the camera
+static inline void worldToCamera(const float world[3], float camera[3]) {
+    float d[3] = {world[0] - cameraPos.x, world[1] - cameraPos.y, world[2] - cameraPos.z};
+    camera[0] = d[0] * camRight.x + d[1] * camRight.y + d[2] * camRight.z;
+    camera[1] = d[0] * camUp.x + d[1] * camUp.y + d[2] * camUp.z;
+    camera[2] = d[0] * camForward.x + d[1] * camForward.y + d[2] * camForward.z;
+}
+
 // Given a point, project it to 2D screen space.
 // Returns 1 if the vertex is visible, even if some vertices are behind the camera.
+// One point at a time, whole meshes go through simdProject
 int projectVertex(const float world[3], float* screenX, float* screenY) {
-    // Load world coordinates and camera position
-    __m128 worldPos = _mm_set_ps(0, world[2], world[1], world[0]);
-    __m128 camPos   = _mm_set_ps(0, cameraPos.z, cameraPos.y, cameraPos.x);
-
-    // Compute dx, dy, dz = world - cameraPos
-    __m128 diff = _mm_sub_ps(worldPos, camPos);
-
-    // Load camera basis vectors
-    __m128 camRightVec   = _mm_set_ps(0, camRight.z, camRight.y, camRight.x);
-    __m128 camUpVec      = _mm_set_ps(0, camUp.z, camUp.y, camUp.x);
-    __m128 camForwardVec = _mm_set_ps(0, camForward.z, camForward.y, camForward.x);
-
-    // Compute dot products for camera space transformation
-    float x_cam = _mm_cvtss_f32(_mm_dp_ps(diff, camRightVec, 0x71));  // Mask 0x71 ensures XYZ dot product
-    float y_cam = _mm_cvtss_f32(_mm_dp_ps(diff, camUpVec, 0x71));
-    float z_cam = _mm_cvtss_f32(_mm_dp_ps(diff, camForwardVec, 0x71));
+    float camera[3];
+    worldToCamera(world, camera);
 
     // If point is behind the camera, return 0
-    if (z_cam <= 0) {
+    if (camera[2] <= 0) {
         return 0;
     }
 
     // Compute projection
-    float inv_z = 1.0f / z_cam;
-    *screenX = (x_cam * inv_z) * f + SCREEN_WIDTH / 2.0f;
-    *screenY = (y_cam * inv_z) * f + SCREEN_HEIGHT / 2.0f;
+    float inv_z = 1.0f / camera[2];
+    *screenX = (camera[0] * inv_z) * f + renderWidth / 2.0f;
+    *screenY = (camera[1] * inv_z) * f + renderHeight / 2.0f;
 
     return 1;
 }
 
+// Model space straight to camera space for simdProject, the object's rotation, scale and position and then the
+// camera's folded into one matrix so each vertex only needs the one
+void buildProjection(const RenderTransform* transform, SimdProjection* projection) {
+    const float* center = transform->mesh->center;
+    float offset[3] = {transform->position[0] - cameraPos.x, transform->position[1] - cameraPos.y,
+                       transform->position[2] - cameraPos.z};
+    const Vec3 cameraAxes[3] = {camRight, camUp, camForward};
+    for (int r = 0; r < 3; r++) {
+        float axis[3] = {cameraAxes[r].x, cameraAxes[r].y, cameraAxes[r].z};
+        // Meshes face -X, so model x goes along -forward
+        float* row = projection->rows[r];
+        row[0] = -(axis[0] * transform->forward[0] + axis[1] * transform->forward[1] + axis[2] * transform->forward[2]) * transform->scale;
+        row[1] = (axis[0] * transform->up[0] + axis[1] * transform->up[1] + axis[2] * transform->up[2]) * transform->scale;
+        row[2] = (axis[0] * transform->right[0] + axis[1] * transform->right[1] + axis[2] * transform->right[2]) * transform->scale;
+        row[3] = axis[0] * offset[0] + axis[1] * offset[1] + axis[2] * offset[2]
+               - row[0] * center[0] - row[1] * center[1] - row[2] * center[2];
+    }
+    projection->focal = f;
+    projection->halfWidth = renderWidth / 2.0f;
+    projection->halfHeight = renderHeight / 2.0f;
+}
+
 void drawEdge(float x0, float y0, float x1, float y1, uint8_t* pixels, uint32_t color) {
     // Convert coordinates to integers
     int ix0 = (int)(x0 + 0.5f);
@@ -1114,11 +1482,6 @@ void drawEdge(float x0, float y0, float x1, float y1, uint8_t* pixels, uint32_t
     int ix1 = (int)(x1 + 0.5f);
     int iy1 = (int)(y1 + 0.5f);
 
-    // Extract color components
-    uint8_t r = (color >> 16) & 0xFF;
-    uint8_t g = (color >> 8) & 0xFF;
-    uint8_t b = color & 0xFF;
-
     // Compute line deltas
     int dx = abs(ix1 - ix0);
     int dy = abs(iy1 - iy0);
@@ -1130,16 +1493,13 @@ void drawEdge(float x0, float y0, float x1, float y1, uint8_t* pixels, uint32_t
 
     // Draw line
     while (1) {
-        int pixelIndex = (iy0 * SCREEN_WIDTH + ix0) * 3;
-        if (ix0 < 0 || ix0 >= SCREEN_WIDTH || iy0 < 0 || iy0 >= SCREEN_HEIGHT) {
+        if (ix0 < 0 || ix0 >= renderWidth || iy0 < 0 || iy0 >= renderHeight) {
 		    break;
 		}
 		
 
-        // Store the color in the pixel buffer
-        pixels[pixelIndex] = r;
-        pixels[pixelIndex + 1] = g;
-        pixels[pixelIndex + 2] = b;
+        // Store the color in the pixel buffer, BGRA so it's the color as is
+        ((uint32_t*)pixels)[iy0 * renderWidth + ix0] = color;
 
         if (ix0 == ix1 && iy0 == iy1) break;
         
@@ -1157,13 +1517,23 @@ void drawEdge(float x0, float y0, float x1, float y1, uint8_t* pixels, uint32_t
 }
 
 void freeObjects() {
-    // Free all dynamically allocated triangles
+    // Free all dynamically allocated paths, meshes are shared and freed by freeMeshes
     for (size_t i = 0; i < numObjects; i++) {
-        free(objects[i].triangles);
+        if (!(objects[i].pooled & POOLED_PATH)) free(objects[i].pathing.destinations);
     }
+    for (int i = 0; i < numObjectPools; i++) {
+        free(objectPools[i]);
+    }
+    free(objectPools);
+    objectPools = NULL;
+    numObjectPools = 0;
     free(objects);
     objects = NULL;
     numObjects = 0;
+    objectCapacity = 0;
+    free(availableObjectIndexes);
+    availableObjectIndexes = NULL;
+    numAvailableObjectIndexes = availableObjectCapacity = 0;
 }
 
 void generateSkyboxStars(float starOffset[3]) {
@@ -1248,7 +1618,7 @@ void drawSkyboxStar(float x, float y, unsigned char* pixels, unsigned int color,
     int radius = (int)size;
 
     // Check if the center of the SkyboxStar is within screen bounds
-    if (screenX - radius < 0 || screenX + radius >= SCREEN_WIDTH || screenY - radius < 0 || screenY + radius >= SCREEN_HEIGHT)
+    if (screenX - radius < 0 || screenX + radius >= renderWidth || screenY - radius < 0 || screenY + radius >= renderHeight)
         return;
 
     // Loop over the pixels in the square that bounds the circle
@@ -1260,17 +1630,9 @@ void drawSkyboxStar(float x, float y, unsigned char* pixels, unsigned int color,
                 int drawY = screenY + dy;
 
                 // Make sure the pixel is within the screen bounds
-                if (drawX >= 0 && drawX < SCREEN_WIDTH && drawY >= 0 && drawY < SCREEN_HEIGHT) {
-                    int index = (drawY * SCREEN_WIDTH + drawX) * 3;
-
-                    uint8_t r = (color >> 16) & 0xFF;
-                    uint8_t g = (color >> 8) & 0xFF;
-                    uint8_t b = color & 0xFF;
-
+                if (drawX >= 0 && drawX < renderWidth && drawY >= 0 && drawY < renderHeight) {
                     // Set the pixel color
-                    pixels[index] = r;
-                    pixels[index + 1] = g;
-                    pixels[index + 2] = b;
+                    ((uint32_t*)pixels)[drawY * renderWidth + drawX] = color;
                 }
             }
         }
@@ -1281,7 +1643,7 @@ void drawSkyboxStars(unsigned char* pixels) {
     for (int i = 0; i < SKYBOXSTAR_COUNT; i++) {
         float screenX, screenY;
         if (projectVertex(SkyboxStars[i].position, &screenX, &screenY)) {
-            drawSkyboxStar(screenX, screenY, pixels, SkyboxStars[i].color, SkyboxStars[i].size);
+            drawSkyboxStar(screenX, screenY, pixels, SkyboxStars[i].color, SkyboxStars[i].size * renderScale);
         }
     }
 }
@@ -1305,53 +1667,149 @@ void drawVector(float center[3], float vector[3], unsigned char* pixels, float l
 }
 
 void calculateObjectCenter(const Object* object, float center[3]) {
-    if (!object || !object->triangles || object->triangle_count == 0) return;
-
-    center[0] = 0.0f;
-    center[1] = 0.0f;
-    center[2] = 0.0f;
-
-    size_t totalVertices = object->triangle_count * 3;
-
-    for (size_t i = 0; i < object->triangle_count; i++) {
-        Triangle* tri = &object->triangles[i];
+    if (!object || !object->mesh) return;
 
-        center[0] += tri->v1[0] + tri->v2[0] + tri->v3[0];
-        center[1] += tri->v1[1] + tri->v2[1] + tri->v3[1];
-        center[2] += tri->v1[2] + tri->v2[2] + tri->v3[2];
-    }
-
-    // Divide by the total number of vertices to get the average
-    center[0] /= totalVertices;
-    center[1] /= totalVertices;
-    center[2] /= totalVertices;
+    // Rotation happens around the mesh center, so the average of the vertices is always the position
+    center[0] = object->position[0];
+    center[1] = object->position[1];
+    center[2] = object->position[2];
 }
 
 // Calculate distance between two points float version
+// Plain C, the compiler does as well as the intrinsics did for one point and it doesn't read past the third float
 static inline float fgetDistance3D(const float *a, const float *b) {
-    // Load 3D vectors into SIMD registers (X, Y, Z, ?)  
-    __m128 va = _mm_loadu_ps(a);  // Load (a[0], a[1], a[2], ?)  
-    __m128 vb = _mm_loadu_ps(b);  // Load (b[0], b[1], b[2], ?)  
+    float dx = b[0] - a[0];
+    float dy = b[1] - a[1];
+    float dz = b[2] - a[2];
+    return sqrtf(dx * dx + dy * dy + dz * dz);
+}
 
-    // Compute (b - a)
-    __m128 diff = _mm_sub_ps(vb, va);
+// Draw order is kept from frame to frame, furthest first, distances barely change between frames so
+// it's usually nearly sorted already and an insertion sort fixes it up in about one pass
+// If a lot moved (camera jumped, lots of new objects) a radix sort is cheaper than the insertion sort going quadratic
+DrawableDistance* drawOrder = NULL;
+uint8_t* drawListed = NULL; // Per object, is it in drawOrder
+int drawOrderCount = 0, drawOrderCapacity = 0;
+int drawOrderRadixSorts = 0, drawOrderInsertionSorts = 0; // Since the last stats print
+
+// Maps a float to a uint32_t that sorts the same way, flipped so bigger distances come first
+static inline uint32_t distanceSortKey(float distance) {
+    uint32_t bits;
+    memcpy(&bits, &distance, sizeof(bits));
+    bits ^= (bits >> 31) ? 0xFFFFFFFFu : 0x80000000u; // Negatives flip entirely, positives just the sign
+    return ~bits;
+}
 
-    // Square each component (diff * diff)
-    __m128 squared = _mm_mul_ps(diff, diff);
+// LSD radix sort, 8 bits a pass, stable, ends up back in items since there's an even number of passes
+void radixSortByDistance(DrawableDistance* items, DrawableDistance* scratch, int count) {
+    DrawableDistance* from = items;
+    DrawableDistance* to = scratch;
+    for (int shift = 0; shift < 32; shift += 8) {
+        int counts[256] = {0};
+        for (int i = 0; i < count; i++) {
+            counts[(distanceSortKey(from[i].distance) >> shift) & 0xFF]++;
+        }
+        int offset = 0;
+        for (int b = 0; b < 256; b++) {
+            int bucketCount = counts[b];
+            counts[b] = offset;
+            offset += bucketCount;
+        }
+        for (int i = 0; i < count; i++) {
+            to[counts[(distanceSortKey(from[i].distance) >> shift) & 0xFF]++] = from[i];
+        }
+        DrawableDistance* swap = from;
+        from = to;
+        to = swap;
+    }
+}
 
-    // Sum all components using horizontal add
-    __m128 sum1 = _mm_hadd_ps(squared, squared);
-    __m128 sum2 = _mm_hadd_ps(sum1, sum1);
+void insertionSortByDistance(DrawableDistance* items, int count) {
+    for (int i = 1; i < count; i++) {
+        if (items[i].distance <= items[i - 1].distance) continue; // Already in place, the common case
+        DrawableDistance item = items[i];
+        int j = i - 1;
+        while (j >= 0 && items[j].distance < item.distance) {
+            items[j + 1] = items[j];
+            j--;
+        }
+        items[j + 1] = item;
+    }
+}
 
-    // Compute the square root of the sum
-    return _mm_cvtss_f32(_mm_sqrt_ss(sum2));
+// Brings the draw order up to date with this frame's transforms, drops anything that's gone or invisible,
+// adds anything new and resorts
+int updateDrawOrder(const float cameraPosition[3]) {
+    if (frameTransformCount > drawOrderCapacity) {
+        int capacity = frameTransformCount * 2;
+        DrawableDistance* order = (DrawableDistance*)realloc(drawOrder, capacity * sizeof(DrawableDistance));
+        if (order) drawOrder = order;
+        uint8_t* listed = (uint8_t*)realloc(drawListed, capacity);
+        if (listed) drawListed = listed;
+        ViewEntity* entities = (ViewEntity*)realloc(viewEntities, capacity * sizeof(ViewEntity));
+        if (entities) viewEntities = entities;
+        RadarBlip* blips = (RadarBlip*)realloc(viewBlips, capacity * sizeof(RadarBlip));
+        if (blips) viewBlips = blips;
+        if (!order || !listed || !entities || !blips) {
+            printf("Failed to allocate memory for draw order\n");
+            return -1;
+        }
+        drawOrderCapacity = capacity;
+    }
+    memset(drawListed, 0, frameTransformCount);
+    
+    // Refresh the distances of what's already there, in its old order
+    int kept = 0;
+    for (int i = 0; i < drawOrderCount; i++) {
+        int j = drawOrder[i].index;
+        if (j >= frameTransformCount || frameTransforms[j].hidden) continue;
+        drawOrder[kept] = drawOrder[i];
+        drawOrder[kept].distance = fgetDistance3D(cameraPosition, frameTransforms[j].position);
+        drawListed[j] = 1;
+        kept++;
+    }
+    
+    // New ones go on the end, the sort puts them where they belong
+    int count = kept;
+    for (int j = 0; j < frameTransformCount; j++) {
+        if (drawListed[j] || frameTransforms[j].hidden) continue;
+        drawOrder[count].type = TYPE_OBJECT;
+        drawOrder[count].distance = fgetDistance3D(cameraPosition, frameTransforms[j].position);
+        drawOrder[count].index = j;
+        count++;
+    }
+    drawOrderCount = count;
+    
+    // Out of order neighbours are a good enough guess at how much work the insertion sort would be
+    int outOfOrder = count - kept;
+    for (int i = 1; i < kept; i++) {
+        if (drawOrder[i].distance > drawOrder[i - 1].distance) outOfOrder++;
+    }
+    if (outOfOrder == 0) return 0;
+    DrawableDistance* scratch = NULL;
+    if (outOfOrder > 32 && outOfOrder > count / 16) {
+        scratch = (DrawableDistance*)arenaAlloc(&frameArena, count * sizeof(DrawableDistance));
+    }
+    if (scratch) {
+        radixSortByDistance(drawOrder, scratch, count);
+        drawOrderRadixSorts++;
+    } else {
+        insertionSortByDistance(drawOrder, count);
+        drawOrderInsertionSorts++;
+    }
+    return 0;
 }
 
-// Comparison function for sorting
-int compareByDistance(const void* a, const void* b) {
-    float distA = ((DrawableDistance*)a)->distance;
-    float distB = ((DrawableDistance*)b)->distance;
-    return (distB > distA) - (distB < distA);  // Sort descending
+void freeDrawOrder() {
+    free(drawOrder);
+    free(drawListed);
+    free(viewEntities);
+    free(viewBlips);
+    drawOrder = NULL;
+    drawListed = NULL;
+    viewEntities = NULL;
+    viewBlips = NULL;
+    drawOrderCount = drawOrderCapacity = viewCount = 0;
 }
 
 bool isBackface(float v1[3], float v2[3], float v3[3], float cameraPos[3]) {
@@ -1376,119 +1834,318 @@ float dotProduct(float v1[3], float v2[3]) {
     return v1[0] * v2[0] + v1[1] * v2[1] + v1[2] * v2[2];
 }
 
+// Shade color based on light direction and a unit surface normal
+uint32_t shadeColorNormal(uint32_t color, const float normal[3], const float point[3], const float lightPos[3]) {
+    // Compute the vector from the surface to the light source and normalize it
+    float lightDir[3] = {lightPos[0] - point[0], lightPos[1] - point[1], lightPos[2] - point[2]};
+    fnormalize(lightDir);
+
+    // Dot product between the normal and light direction, clamped since the light behind is just shadow
+    float dot = normal[0] * lightDir[0] + normal[1] * lightDir[1] + normal[2] * lightDir[2];
+    dot = fmaxf(dot, 0.0f);
+
+    // Extract the color components, apply the light intensity and combine them back
+    uint8_t r = (uint8_t)(((color >> 16) & 0xFF) * dot);
+    uint8_t g = (uint8_t)(((color >> 8) & 0xFF) * dot);
+    uint8_t b = (uint8_t)((color & 0xFF) * dot);
+
+    return (r << 16) | (g << 8) | b;
+}
+
 // Shade color based on light direction and surface normal
 uint32_t shadeColor(uint32_t color, float v1[3], float v2[3], float v3[3], float lightPos[3]) {
-    // Step 1: Compute two edges of the triangle
+    // Compute two edges of the triangle
     float edge1[3] = {v2[0] - v1[0], v2[1] - v1[1], v2[2] - v1[2]};
     float edge2[3] = {v3[0] - v1[0], v3[1] - v1[1], v3[2] - v1[2]};
 
-    // Step 2: Calculate the surface normal using the cross product
+    // Calculate the surface normal using the cross product
     float normal[3] = {
         edge1[1] * edge2[2] - edge1[2] * edge2[1],  // normal.x
         edge1[2] * edge2[0] - edge1[0] * edge2[2],  // normal.y
         edge1[0] * edge2[1] - edge1[1] * edge2[0]   // normal.z
     };
-
-    // Step 3: Normalize the normal vector
     fnormalize(normal);
 
-    // Step 4: Compute the vector from the triangle to the light source
-    float lightDir[3] = {lightPos[0] - v1[0], lightPos[1] - v1[1], lightPos[2] - v1[2]};
-
-    // Step 5: Normalize the light direction
-    fnormalize(lightDir);
-
-    // Step 6: Calculate the dot product between the normal and light direction
-    float dot = dotProduct(normal, lightDir);
-
-    // Step 7: Ensure the dot product is between 0 and 1 (clamp it)
-    dot = fmaxf(dot, 0.0f);  // If the light is behind, we get no light (shadow).
-
-    // Step 8: Extract the color components from the 32-bit color
-    uint8_t r = (color >> 16) & 0xFF;
-    uint8_t g = (color >> 8) & 0xFF;
-    uint8_t b = color & 0xFF;
-
-    // Step 9: Apply shading based on the dot product (light intensity)
-    r = (uint8_t)(r * dot);
-    g = (uint8_t)(g * dot);
-    b = (uint8_t)(b * dot);
+    return shadeColorNormal(color, normal, v1, lightPos);
+}
 
-    // Step 10: Combine the shaded color back into a single 32-bit value
-    uint32_t shadedColor = (r << 16) | (g << 8) | b;
 
-    return shadedColor;
+static inline int isOccluder(const RenderTransform* transform) {
+    return transform->id == 1 || transform->id == 2; // Planets and stars
 }
 
-void renderScene(unsigned char* pixels) {
-    float cameraPosition[3] = {cameraPos.x, cameraPos.y, cameraPos.z};
-    int totalItems = 0; // Fix: Track valid entries
-    DrawableDistance drawQueue[numObjects];
+// Draws every planet and star into the depth pyramid as a disc
+// The disc is the mesh's inner sphere shrunk to radius / distance, every ray through it hits the sphere no further
+// away than its center, so the center distance is a safe depth for all of it
+void buildOcclusion() {
+    uint64_t start = SDL_GetPerformanceCounter();
+    hizClear(&depthPyramid, renderWidth, renderHeight);
+    float cameraPosition[4] = {cameraPos.x, cameraPos.y, cameraPos.z, 0.0f};
+    occluderCount = 0;
+    for (int j = 0; j < frameTransformCount; j++) {
+        const RenderTransform* transform = &frameTransforms[j];
+        if (transform->hidden || !transform->mesh || !isOccluder(transform)) continue;
+        float radius = transform->mesh->innerRadius * transform->scale;
+        float distance = fgetDistance3D(transform->position, cameraPosition);
+        if (distance <= radius) continue; // Inside it
+        float screenX, screenY;
+        if (!projectVertex(transform->position, &screenX, &screenY)) continue;
+        hizDrawDisc(&depthPyramid, screenX, screenY, f * radius / distance, distance);
+        occluderCount++;
+    }
+    hizBuild(&depthPyramid);
+    occlusionTime = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
 
-    // Populate drawQueue only with visible objects
-    for (int j = 0; j < numObjects; j++) {
-        if (objects[j].id == 255 || objects[j].invisible) continue; // Skip invisible objects
+// 1 if the object's bounding sphere is completely behind an occluder
+// camera is its center in camera space
+int isOccluded(const RenderTransform* transform, const float camera[3]) {
+    float radius = transform->mesh->radius * transform->scale;
+    float nearZ = camera[2] - radius, farZ = camera[2] + radius;
+    if (nearZ <= 1.0f) return 0;
+    
+    // Screen rectangle around the sphere, the biggest x / z it can have is over the nearest z if x is positive
+    // and over the furthest z if it isn't, same for the rest
+    float maxX = camera[0] + radius, minX = camera[0] - radius;
+    float maxY = camera[1] + radius, minY = camera[1] - radius;
+    float halfWidth = renderWidth / 2.0f, halfHeight = renderHeight / 2.0f;
+    float screenMaxX = maxX / (maxX > 0 ? nearZ : farZ) * f + halfWidth;
+    float screenMinX = minX / (minX < 0 ? nearZ : farZ) * f + halfWidth;
+    float screenMaxY = maxY / (maxY > 0 ? nearZ : farZ) * f + halfHeight;
+    float screenMinY = minY / (minY < 0 ? nearZ : farZ) * f + halfHeight;
+    return hizOccluded(&depthPyramid, screenMinX, screenMinY, screenMaxX, screenMaxY, nearZ);
+}
 
-        // Store in drawQueue only if it's visible
-        drawQueue[totalItems].distance = fgetDistance3D(cameraPosition, objects[j].position);
-        drawQueue[totalItems].index = j;
-        totalItems++; // Fix: Increment only for valid objects
+// Stand in for something whose mesh is still loading, a circle the size of its bounding sphere
+void drawImpostor(const RenderTransform* transform, const float camera[3], unsigned char* pixels) {
+    if (camera[2] <= transform->impostorRadius) return;
+    float centerX, centerY;
+    if (!projectVertex(transform->position, &centerX, &centerY)) return;
+    float radius = f * transform->impostorRadius / camera[2];
+    if (radius > renderWidth) return; // Filling the screen, an outline wouldn't show anything
+    
+    float previousX = centerX + radius, previousY = centerY;
+    for (int i = 1; i <= IMPOSTOR_SEGMENTS; i++) {
+        float angle = i * 2.0f * (float)M_PI / IMPOSTOR_SEGMENTS;
+        float x = centerX + cosf(angle) * radius, y = centerY + sinf(angle) * radius;
+        drawEdge(previousX, previousY, x, y, pixels, transform->color);
+        previousX = x;
+        previousY = y;
     }
+}
 
-    // Ensure sorting only happens for valid entries
-    if (totalItems > 1) {
-        qsort(drawQueue, totalItems, sizeof(DrawableDistance), compareByDistance);
+// Stage one of drawing a frame, everything the views share: puts what's visible in draw order, works out where
+// each one is in camera space and which ones the main view can skip for being behind a planet
+int gatherView() {
+    float cameraPosition[3] = {cameraPos.x, cameraPos.y, cameraPos.z};
+    viewCount = 0;
+    if (updateDrawOrder(cameraPosition) != 0) return -1;
+    
+    buildOcclusion();
+    occlusionTested = 0;
+    occlusionCulled = 0;
+    
+    for (int i = 0; i < drawOrderCount; i++) {
+        const RenderTransform* transform = &frameTransforms[drawOrder[i].index];
+        ViewEntity* entity = &viewEntities[i];
+        entity->index = drawOrder[i].index;
+        entity->distance = drawOrder[i].distance;
+        entity->culled = 0;
+        worldToCamera(transform->position, viewBlips[i].position);
+        viewBlips[i].color = transform->color;
+        
+        if (transform->mesh && !isOccluder(transform)) {
+            occlusionTested++;
+            if (isOccluded(transform, viewBlips[i].position)) {
+                entity->culled = 1;
+                occlusionCulled++;
+            }
+        }
     }
+    viewCount = drawOrderCount;
+    return 0;
+}
 
-	float* lightPos = objects[2].position;  // Light position (example)
-	uint32_t objectColor = 0xFF00FF;  // Magenta color (RGB: 255, 0, 255)
+// Main view, from gatherView's results
+void rasterizeView(unsigned char* pixels) {
+	drawnObjects = drawnTriangles = drawnEdges = 0;
+	// The third object's the light (example), until there is one the camera lights what it looks at
+	float cameraLight[3] = {cameraPos.x, cameraPos.y, cameraPos.z};
+	const float* lightPos = frameTransformCount > 2 ? frameTransforms[2].position : cameraLight;
 	
     // Render in sorted order
-    for (int i = 0; i < totalItems; i++) {
-        int objIndex = drawQueue[i].index;
-        float objectCenter[3] = {0.0f, 0.0f, 0.0f};
-        calculateObjectCenter(&objects[objIndex], objectCenter);
-
-        if (!firstPerson) {
-            //drawVector(objectCenter, objects[objIndex].forward, pixels, 10.0f, 0xFF0000);
-            //drawVector(objectCenter, objects[objIndex].right, pixels, 10.0f, 0x00FF00);
-            //drawVector(objectCenter, objects[objIndex].up, pixels, 10.0f, 0x0000FF);
+    for (int i = 0; i < viewCount; i++) {
+        const ViewEntity* entity = &viewEntities[i];
+        if (entity->culled) continue;
+        
+        const RenderTransform* object = &frameTransforms[entity->index];
+        const Mesh* mesh = object->mesh;
+        if (!mesh) {
+            if (object->impostorRadius > 0.0f) drawImpostor(object, viewBlips[i].position, pixels);
+            continue;
         }
         
-        unsigned int shadedColor = objects[objIndex].color;  // Default color
-		
-		//#pragma omp parallel for num_threads(4) schedule(dynamic)
-        for (int k = 0; k < objects[objIndex].triangle_count; k++) {
-			if (!isBackface(objects[objIndex].triangles[k].v1, objects[objIndex].triangles[k].v2, objects[objIndex].triangles[k].v3, cameraPosition)) {
-			    //continue;
-			}
-			uint32_t shadedColor = objects[objIndex].color;
-			if ((objects[objIndex].id == 1)) {
-				shadedColor = shadeColor(objects[objIndex].color, objects[objIndex].triangles[k].v1, objects[objIndex].triangles[k].v2, objects[objIndex].triangles[k].v3, lightPos);
-			}
-						
-            float p1x, p1y, p1z, p2x, p2y, p2z, p3x, p3y, p3z;
-            if (!projectVertex(objects[objIndex].triangles[k].v1, &p1x, &p1y) || 
-				!projectVertex(objects[objIndex].triangles[k].v2, &p2x, &p2y) ||
-				!projectVertex(objects[objIndex].triangles[k].v3, &p3x, &p3y)) continue;
-			
-            drawEdge(p1x, p1y, p2x, p2y, pixels, shadedColor);
-            drawEdge(p2x, p2y, p3x, p3y, pixels, shadedColor);
-            drawEdge(p3x, p3y, p1x, p1y, pixels, shadedColor);
+        // Pick the LOD, they're sorted by distance so the last one that applies wins
+        size_t firstTriangle = 0, triangleCount = mesh->triangle_count;
+        size_t firstEdge = 0, edgeCount = mesh->edgeCount;
+        for (uint32_t l = 0; l < mesh->lodCount; l++) {
+            if (entity->distance < mesh->lods[l].switchDistance * object->scale) break;
+            firstTriangle = mesh->lods[l].firstTriangle;
+            triangleCount = mesh->lods[l].triangleCount;
+            firstEdge = mesh->lods[l].firstEdge;
+            edgeCount = mesh->lods[l].edgeCount;
         }
-    }
-}
-
-// Function to set the camera behind an object
-void setCameraToObject(Object *obj, float fOffset, float uOffset, float rOffset) {
-    // Update camera position
-    cameraPos.x = obj->position[0] - (obj->forward[0] * fOffset) - (obj->up[0] * uOffset);
+        
+        // Transform and project every unique vertex once, instead of once per triangle corner
+        // x, y and the depth, in front of the camera if it's positive, only needed until the next object
+        size_t mark = arenaMark(&frameArena);
+        float* screenX = (float*)arenaAlloc(&frameArena, mesh->vertexCount * sizeof(float));
+        float* screenY = (float*)arenaAlloc(&frameArena, mesh->vertexCount * sizeof(float));
+        float* depth = (float*)arenaAlloc(&frameArena, mesh->vertexCount * sizeof(float));
+        if (!screenX || !screenY || !depth) {
+            arenaRelease(&frameArena, mark);
+            continue;
+        }
+        SimdProjection projection;
+        buildProjection(object, &projection);
+        simdProject(&projection, mesh->vertices, mesh->vertexCount, screenX, screenY, depth);
+        drawnObjects++;
+        
+        if (object->id == 1) {
+            // Shaded per face, so go by triangle
+            for (size_t k = firstTriangle; k < firstTriangle + triangleCount; k++) {
+                const uint32_t* tri = mesh->indices[k];
+                if (depth[tri[0]] <= 0 || depth[tri[1]] <= 0 || depth[tri[2]] <= 0) continue;
+                
+                float normal[3], point[3];
+                transformDirectionToWorld(object, mesh->normals[k], normal);
+                transformToWorld(object, mesh->vertices[tri[0]], point);
+                uint32_t shadedColor = shadeColorNormal(object->color, normal, point, lightPos);
+                drawnTriangles++;
+                
+                drawEdge(screenX[tri[0]], screenY[tri[0]], screenX[tri[1]], screenY[tri[1]], pixels, shadedColor);
+                drawEdge(screenX[tri[1]], screenY[tri[1]], screenX[tri[2]], screenY[tri[2]], pixels, shadedColor);
+                drawEdge(screenX[tri[2]], screenY[tri[2]], screenX[tri[0]], screenY[tri[0]], pixels, shadedColor);
+            }
+        } else {
+            // Flat color, each shared edge only needs drawing once
+            for (size_t k = firstEdge; k < firstEdge + edgeCount; k++) {
+                uint32_t a = mesh->edges[k][0], b = mesh->edges[k][1];
+                if (depth[a] <= 0 || depth[b] <= 0) continue;
+                drawEdge(screenX[a], screenY[a], screenX[b], screenY[b], pixels, object->color);
+                drawnEdges++;
+            }
+        }
+        arenaRelease(&frameArena, mark);
+    }
+}
+
+// Radar stage, runs on its own thread while the main view draws, only reads what gatherView left
+void rasterizeRadar() {
+    uint64_t start = SDL_GetPerformanceCounter();
+    radarDraw(&radar, (int)(RADAR_WIDTH * renderScale), (int)(RADAR_HEIGHT * renderScale), viewBlips, viewCount);
+    radarTime = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// The radar's thread, started with the first frame that wants it and woken every frame after that
+struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake, done;
+    int started, stopping;
+    int pending; // A frame's been asked for and isn't drawn yet
+} radarWorker = {.lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER, .done = PTHREAD_COND_INITIALIZER};
+
+void* radarWorkerThread(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&radarWorker.lock);
+    while (1) {
+        while (!radarWorker.stopping && !radarWorker.pending) {
+            pthread_cond_wait(&radarWorker.wake, &radarWorker.lock);
+        }
+        if (radarWorker.stopping) break;
+        pthread_mutex_unlock(&radarWorker.lock);
+        rasterizeRadar();
+        pthread_mutex_lock(&radarWorker.lock);
+        radarWorker.pending = 0;
+        pthread_cond_signal(&radarWorker.done);
+    }
+    pthread_mutex_unlock(&radarWorker.lock);
+    return NULL;
+}
+
+// Returns 0 if the radar's being drawn on the worker, -1 if it couldn't be started and the caller has to draw it
+int startRadarFrame() {
+    if (!radarWorker.started) {
+        if (pthread_create(&radarWorker.thread, NULL, radarWorkerThread, NULL) != 0) return -1;
+        radarWorker.started = 1;
+    }
+    pthread_mutex_lock(&radarWorker.lock);
+    radarWorker.pending = 1;
+    pthread_cond_signal(&radarWorker.wake);
+    pthread_mutex_unlock(&radarWorker.lock);
+    return 0;
+}
+
+void finishRadarFrame() {
+    pthread_mutex_lock(&radarWorker.lock);
+    while (radarWorker.pending) {
+        pthread_cond_wait(&radarWorker.done, &radarWorker.lock);
+    }
+    pthread_mutex_unlock(&radarWorker.lock);
+}
+
+void stopRadarWorker() {
+    if (!radarWorker.started) return;
+    pthread_mutex_lock(&radarWorker.lock);
+    radarWorker.stopping = 1;
+    pthread_cond_signal(&radarWorker.wake);
+    pthread_mutex_unlock(&radarWorker.lock);
+    pthread_join(radarWorker.thread, NULL);
+    radarWorker.started = radarWorker.stopping = radarWorker.pending = 0;
+}
+
+// Gathers once and draws every view from it, the radar on another thread at the same time as the main view
+void renderScene(unsigned char* pixels) {
+    if (gatherView() != 0) return;
+    
+    int radarThreaded = radarEnabled && startRadarFrame() == 0;
+    uint64_t start = SDL_GetPerformanceCounter();
+    rasterizeView(pixels);
+    // Particles go over the wireframes, additive so they glow where they bunch up
+    ParticleCamera camera = {
+        .position = {cameraPos.x, cameraPos.y, cameraPos.z},
+        .right = {camRight.x, camRight.y, camRight.z},
+        .up = {camUp.x, camUp.y, camUp.z},
+        .forward = {camForward.x, camForward.y, camForward.z},
+        .focal = f,
+        .width = renderWidth,
+        .height = renderHeight
+    };
+    particlesDrawn = particlesSplat(&particles, &camera, (uint32_t*)pixels);
+    mainViewTime = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    
+    if (radarEnabled) {
+        if (radarThreaded) finishRadarFrame();
+        else rasterizeRadar(); // No worker, it'll just have to go after the main view
+        radarComposite(&radar, (uint32_t*)pixels, renderWidth, renderHeight, (renderWidth - radar.width) / 2,
+                       (int)(RADAR_MARGIN * renderScale));
+    }
+}
+
+// Function to set the camera behind an object
+void setCameraToObject(const RenderTransform* obj, float fOffset, float uOffset, float rOffset) {
+    // Update camera position
+    cameraPos.x = obj->position[0] - (obj->forward[0] * fOffset) - (obj->up[0] * uOffset);
     cameraPos.y = obj->position[1] - (obj->forward[1] * fOffset) - (obj->up[1] * uOffset);
     cameraPos.z = obj->position[2] - (obj->forward[2] * fOffset) - (obj->up[2] * uOffset);
 
 	if (!freeLook) {
 	    // Update camera orientation
-	    cameraOrientation = rotationMatrixToQuaternion(obj->forward, obj->up, obj->right);	
+	    float forward[3] = {obj->forward[0], obj->forward[1], obj->forward[2]};
+	    float up[3] = {obj->up[0], obj->up[1], obj->up[2]};
+	    float right[3] = {obj->right[0], obj->right[1], obj->right[2]};
+	    cameraOrientation = rotationMatrixToQuaternion(forward, up, right);	
 	    
 	    Vec3 vecUp = {.x = obj->up[0],
 					  .y = obj->up[1],
@@ -1499,7 +2156,7 @@ void setCameraToObject(Object *obj, float fOffset, float uOffset, float rOffset)
 
 void addPath(Object* object, PathDestination destination) {
     if (object == NULL) {
-        printf("Error: object is NULL\n");
+        LOG_ERROR("Object is NULL\n");
         return;
     }
 
@@ -1507,7 +2164,7 @@ void addPath(Object* object, PathDestination destination) {
     if (object->pathing.destinations == NULL) {
         object->pathing.destinations = (PathDestination*)malloc(sizeof(PathDestination));
         if (object->pathing.destinations == NULL) {
-            printf("Error: Initial malloc failed\n");
+            LOG_ERROR("Failed to allocate memory for path destinations\n");
             return;
         }
         object->pathing.numDestinations = 1;
@@ -1515,6 +2172,18 @@ void addPath(Object* object, PathDestination destination) {
         return;
     }
 
+    // Pooled destinations came from a bulk allocation, move them out before growing the list
+    if (object->pooled & POOLED_PATH) {
+        PathDestination* ownDestinations = (PathDestination*)malloc((object->pathing.numDestinations + 1) * sizeof(PathDestination));
+        if (ownDestinations == NULL) {
+            LOG_ERROR("Failed to allocate memory for path destinations\n");
+            return;
+        }
+        memcpy(ownDestinations, object->pathing.destinations, object->pathing.numDestinations * sizeof(PathDestination));
+        object->pathing.destinations = ownDestinations;
+        object->pooled &= ~POOLED_PATH;
+    }
+
     // Increase destination count
     object->pathing.numDestinations++;
 
@@ -1525,7 +2194,7 @@ void addPath(Object* object, PathDestination destination) {
     );
 
     if (newDestinations == NULL) {
-        printf("Error: Failed to allocate memory for path destinations\n");
+        LOG_ERROR("Failed to allocate memory for path destinations\n");
         return;
     }
 
@@ -1536,10 +2205,11 @@ void addPath(Object* object, PathDestination destination) {
     object->pathing.destinations[object->pathing.numDestinations - 1] = destination;
 }
 
-void getPathVector(Object* object, float finalVector[3]) {
+// random is a uniform float in [0, 1), used to pick the destination
+void getPathVector(Object* object, float finalVector[3], float random) {
     // Safety check: Is object NULL?
     if (!object) {
-        printf("Error: object is NULL\n");
+        LOG_ERROR("Object is NULL\n");
         finalVector[0] = finalVector[1] = finalVector[2] = 0.0f;
         return;
     }
@@ -1548,7 +2218,7 @@ void getPathVector(Object* object, float finalVector[3]) {
 
     // Safety check: Does object have destinations?
     if (pathing->numDestinations == 0 || pathing->destinations == NULL) {
-        printf("No valid destinations.\n");
+        LOG_WARN("No valid destinations.\n");
         finalVector[0] = finalVector[1] = finalVector[2] = 0.0f;
         return;
     }
@@ -1562,13 +2232,13 @@ void getPathVector(Object* object, float finalVector[3]) {
     }
 
     if (totalStrength <= 0.0f) {
-        printf("All destination strengths are zero or invalid.\n");
+        LOG_WARN("All destination strengths are zero or invalid.\n");
         finalVector[0] = finalVector[1] = finalVector[2] = 0.0f;
         return;
     }
 
     // Pick a destination based on weighted randomness
-    float randomPick = ((float)rand() / RAND_MAX) * totalStrength;
+    float randomPick = random * totalStrength;
     float cumulativeStrength = 0.0f;
     PathDestination* chosenDestination = NULL;
 
@@ -1582,7 +2252,7 @@ void getPathVector(Object* object, float finalVector[3]) {
 
     // Fallback in case of failure (shouldn't happen, but extra safety)
     if (!chosenDestination) {
-        printf("Warning: No destination chosen, defaulting to first one.\n");
+        LOG_WARN("No destination chosen, defaulting to first one.\n");
         chosenDestination = &pathing->destinations[0];
     }
 
@@ -1610,9 +2280,10 @@ void getPathVector(Object* object, float finalVector[3]) {
     }
 }
 
-void pathFindingVector(Object* object, float finalVector[3]) {
+// random is a uniform float in [0, 1), used to pick the destination
+void pathFindingVector(Object* object, float finalVector[3], float random) {
     if (!object) {
-        printf("Error: object is NULL\n");
+        LOG_ERROR("Object is NULL\n");
         finalVector[0] = finalVector[1] = finalVector[2] = 0.0f;
         return;
     }
@@ -1621,7 +2292,7 @@ void pathFindingVector(Object* object, float finalVector[3]) {
 
     // Safety check: Does object have destinations?
     if (pathing->numDestinations == 0 || pathing->destinations == NULL) {
-        printf("No valid destinations.\n");
+        LOG_WARN("No valid destinations.\n");
         finalVector[0] = finalVector[1] = finalVector[2] = 0.0f;
         return;
     }
@@ -1635,13 +2306,13 @@ void pathFindingVector(Object* object, float finalVector[3]) {
     }
 
     if (totalStrength <= 0.0f) {
-        printf("All destination strengths are zero or invalid.\n");
+        LOG_WARN("All destination strengths are zero or invalid.\n");
         finalVector[0] = finalVector[1] = finalVector[2] = 0.0f;
         return;
     }
 
     // Pick a destination based on weighted randomness
-    float randomPick = ((float)rand() / RAND_MAX) * totalStrength;
+    float randomPick = random * totalStrength;
     float cumulativeStrength = 0.0f;
     PathDestination* chosenDestination = NULL;
 
@@ -1655,7 +2326,7 @@ void pathFindingVector(Object* object, float finalVector[3]) {
 
     // Fallback in case of failure (shouldn't happen, but extra safety)
     if (!chosenDestination) {
-        printf("Warning: No destination chosen, defaulting to first one.\n");
+        LOG_WARN("No destination chosen, defaulting to first one.\n");
         chosenDestination = &pathing->destinations[0];
     }
 
@@ -1666,28 +2337,65 @@ void pathFindingVector(Object* object, float finalVector[3]) {
 }
 
 // Check for nearby objects and set the destination in the opposite direction
-void avoidNearbyObjects(Object* objects, Object* currentObject, float* avoidanceStrength) {
+// Adds other to the avoidance if current is inside its radius
+static inline void avoidSphere(const float position[3], const float other[4], float* avoidanceStrength,
+                               float avoidanceVector[3], int* nearbyObjectCount) {
+    float d[3] = {position[0] - other[0], position[1] - other[1], position[2] - other[2]};
+    float minDistance = other[3];
+    if (d[0] * d[0] + d[1] * d[1] + d[2] * d[2] >= minDistance * minDistance) return;
+    if (*avoidanceStrength < minDistance) {
+        *avoidanceStrength = minDistance;
+    }
+    // Accumulate the avoidance vector (opposite of the direction to the other object)
+    avoidanceVector[0] += d[0];
+    avoidanceVector[1] += d[1];
+    avoidanceVector[2] += d[2];
+    (*nearbyObjectCount)++;
+}
+
+void avoidNearbyObjects(Object* objects, Object* currentObject, float* avoidanceStrength, const float random[3]) {
     if (!objects || !currentObject) return;
 
     float avoidanceVector[3] = {0.0f, 0.0f, 0.0f};
     int nearbyObjectCount = 0;
-
-    for (int i = 0; i < numObjects; i++) {
-        if (&objects[i] == currentObject) continue; // Skip self
-        
-        float minDistance = objects[i].avoidanceRadius;
-
-        // Check distance to other object
-        float distance = fgetDistance3D(currentObject->position, objects[i].position);
-        if (distance < minDistance) {
-			if (*avoidanceStrength < minDistance) {
-				*avoidanceStrength = minDistance;
-			}
-            // Accumulate the avoidance vector (opposite of the direction to the other object)
-            avoidanceVector[0] += currentObject->position[0] - objects[i].position[0];
-            avoidanceVector[1] += currentObject->position[1] - objects[i].position[1];
-            avoidanceVector[2] += currentObject->position[2] - objects[i].position[2];
-            nearbyObjectCount++;
+    uint32_t self = (uint32_t)(currentObject - objects);
+    const float* position = currentObject->position;
+
+    if (avoidanceGrid.built) {
+        // Only the 27 cells around it, and whatever's too big for them
+        uint32_t mask = avoidanceGrid.numBuckets - 1;
+        float cellSize = avoidanceGrid.cellSize;
+        int cx = (int)floorf(position[0] / cellSize), cy = (int)floorf(position[1] / cellSize), cz = (int)floorf(position[2] / cellSize);
+        uint32_t visited[27];
+        int numVisited = 0;
+        for (int ox = -1; ox <= 1; ox++) {
+            for (int oy = -1; oy <= 1; oy++) {
+                for (int oz = -1; oz <= 1; oz++) {
+                    uint32_t bucket = ((uint32_t)(cx + ox) * 73856093u ^ (uint32_t)(cy + oy) * 19349663u ^
+                                       (uint32_t)(cz + oz) * 83492791u) & mask;
+                    // Two cells can hash to the same bucket, it only gets gone through once
+                    int seen = 0;
+                    for (int v = 0; v < numVisited && !seen; v++) seen = visited[v] == bucket;
+                    if (seen) continue;
+                    visited[numVisited++] = bucket;
+                    for (uint32_t s = avoidanceGrid.bucketStart[bucket]; s < avoidanceGrid.bucketStart[bucket + 1]; s++) {
+                        if (avoidanceGrid.sorted[s] == self) continue; // Skip self
+                        avoidSphere(position, avoidanceGrid.sortedSpheres[s], avoidanceStrength, avoidanceVector, &nearbyObjectCount);
+                    }
+                }
+            }
+        }
+        for (uint32_t l = 0; l < avoidanceGrid.numLarge; l++) {
+            const Object* other = &objects[avoidanceGrid.large[l]];
+            if (other == currentObject) continue;
+            float sphere[4] = {other->position[0], other->position[1], other->position[2], other->avoidanceRadius};
+            avoidSphere(position, sphere, avoidanceStrength, avoidanceVector, &nearbyObjectCount);
+        }
+    } else {
+        for (int i = 0; i < numObjects; i++) {
+            if (&objects[i] == currentObject) continue; // Skip self
+            float sphere[4] = {objects[i].position[0], objects[i].position[1], objects[i].position[2], objects[i].avoidanceRadius};
+            avoidSphere(position, sphere, avoidanceStrength, avoidanceVector, &nearbyObjectCount);
         }
     }
 
@@ -1698,7 +2406,7 @@ void avoidNearbyObjects(Object* objects, Object* currentObject, float* avoidance
         avoidanceVector[2] /= nearbyObjectCount;
 
         // Add random perturbation to avoid linear motion
-        addRandomPerturbation(avoidanceVector, 0.3f);
+        addRandomPerturbation(avoidanceVector, 0.3f, random);
 
         // Normalize to maintain direction
         fnormalize(avoidanceVector);
@@ -1712,12 +2420,12 @@ void avoidNearbyObjects(Object* objects, Object* currentObject, float* avoidance
     }
 }
 
-void updateDestinationWithAvoidance(Object* objects, int j) {
+void updateDestinationWithAvoidance(Object* objects, int j, const float random[RANDOMS_PER_OBJECT]) {
     objects[j].pathing.chasing = 1;
 
 	float avoidanceDistance;
     // Step 1: Avoid nearby objects (this updates the object's current destination)
-    avoidNearbyObjects(objects, &objects[j], &avoidanceDistance);
+    avoidNearbyObjects(objects, &objects[j], &avoidanceDistance, random);
 
     // Step 2: Get the avoidance position (after avoidNearbyObjects runs)
     float avoidancePos[3] = {
@@ -1778,43 +2486,96 @@ Vec3 doGravity(Object* obj1, Object* obj2) {
 void* processObjects(void* arg) {
     ThreadData* data = (ThreadData*)arg;
     Object* objects = data->objects;
+    WorkerState* worker = data->worker;
+    
+    arenaReset(&worker->arena);
+    
+    // Generate this tick's random numbers for every object in one go
+    size_t randomCount = (size_t)(data->end - data->start) * RANDOMS_PER_OBJECT;
+    float* randoms = (float*)arenaAlloc(&worker->arena, randomCount * sizeof(float));
+    float* heapRandoms = NULL;
+    if (!randoms) {
+        // The arena only grows at the next reset, the heap covers this tick so nobody misses a tick of AI and physics
+        randoms = heapRandoms = (float*)malloc(randomCount * sizeof(float));
+        if (!randoms) {
+            LOG_ERROR("Failed to allocate memory for %zu AI random numbers\n", randomCount);
+            return NULL;
+        }
+    }
+    rng4Fill(&worker->rng, randoms, randomCount);
     
     for (int j = data->start; j < data->end; j++) {
+        if (objects[j].id == 255) continue; // Removed
         if (objects[j].id == 10) {
-            updateDestinationWithAvoidance(objects, j);
-            for (int i = 0; i < objects[j].pathing.numDestinations; i++) {                        
-                float finalVector[3] = {0, 0, 0};
-                getPathVector(&objects[j], finalVector);
-                float objectCenter[3] = {0.0f, 0.0f, 0.0f};
-                calculateObjectCenter(&objects[j], objectCenter);
-
-                float distanceToTarget = fgetDistance3D(objects[j].position, objects[j].pathing.destinations[i].position);
-                fnormalize(finalVector);
-                finalVector[0] = fmod(finalVector[0], 2);
-                finalVector[1] = fmod(finalVector[1], 2);
-                finalVector[2] = fmod(finalVector[2], 2);
-                turnTowardsPoint(&objects[j], objects[j].pathing.destinations[i].position);
-
-                float damp = (distanceToTarget < (objects[j].parameters.minChaseDistance + objects[j].parameters.maxChaseDistance) / 10) 
-                             ? 0.5f : 1.0f;
-                damp *= MOVEMENT_DAMPENING;
-
-                if (distanceToTarget >= objects[j].parameters.minChaseDistance &&
-                    distanceToTarget <= objects[j].parameters.maxChaseDistance &&
-                    objects[j].pathing.chasing) {
+            if (objects[j].ai.update) {
+                // Catch up on the turning missed since the last update
+                int ticks = simTick - objects[j].ai.lastTick;
+                if (ticks < 1) ticks = 1;
+                if (ticks > AI_MAX_INTERVAL) ticks = AI_MAX_INTERVAL;
+                objects[j].ai.lastTick = simTick;
+                objects[j].ai.thrust = 0.0f;
+                
+                const float* random = &randoms[(size_t)(j - data->start) * RANDOMS_PER_OBJECT];
+                if (flocking) {
+                    // Aim a bit down the steering, full thrust when already facing that way, less when turning
+                    const float* steer = flockSteering[objects[j].flockIndex];
+                    float aim[3] = {
+                        objects[j].position[0] + steer[0] * FLOCK_LOOKAHEAD,
+                        objects[j].position[1] + steer[1] * FLOCK_LOOKAHEAD,
+                        objects[j].position[2] + steer[2] * FLOCK_LOOKAHEAD
+                    };
+                    turnTowardsPoint(&objects[j], aim, ticks);
                     
-                    objects[j].velX += objects[j].forward[0] * objects[j].parameters.forwardSpeed * damp;
-                    objects[j].velY += objects[j].forward[1] * objects[j].parameters.forwardSpeed * damp;
-                    objects[j].velZ += objects[j].forward[2] * objects[j].parameters.forwardSpeed * damp;
-                } else if (!objects[j].pathing.chasing) {
-                    objects[j].velX += objects[j].forward[0] * objects[j].parameters.forwardSpeed * damp;
-                    objects[j].velY += objects[j].forward[1] * objects[j].parameters.forwardSpeed * damp;
-                    objects[j].velZ += objects[j].forward[2] * objects[j].parameters.forwardSpeed * damp;
+                    float direction[3] = {steer[0], steer[1], steer[2]};
+                    fnormalize(direction);
+                    float facing = objects[j].forward[0] * direction[0] + objects[j].forward[1] * direction[1] + objects[j].forward[2] * direction[2];
+                    objects[j].ai.thrust = MOVEMENT_DAMPENING * CLAMP(facing, 0.25f, 1.0f);
+                } else {
+                    updateDestinationWithAvoidance(objects, j, random);
+                    float extraRandoms[4];
+                    int extraLeft = 0;
+                    for (int i = 0; i < objects[j].pathing.numDestinations; i++) {                        
+                        // Every destination gets its own pick, the ones past the first come off the worker's generator
+                        float pick = random[3];
+                        if (i > 0) {
+                            if (extraLeft == 0) {
+                                _mm_storeu_ps(extraRandoms, rng4Floats(&worker->rng));
+                                extraLeft = 4;
+                            }
+                            pick = extraRandoms[--extraLeft];
+                        }
+                        float finalVector[3] = {0, 0, 0};
+                        getPathVector(&objects[j], finalVector, pick);
+
+                        float distanceToTarget = fgetDistance3D(objects[j].position, objects[j].pathing.destinations[i].position);
+                        fnormalize(finalVector);
+                        finalVector[0] = fmod(finalVector[0], 2);
+                        finalVector[1] = fmod(finalVector[1], 2);
+                        finalVector[2] = fmod(finalVector[2], 2);
+                        turnTowardsPoint(&objects[j], objects[j].pathing.destinations[i].position, ticks);
+
+                        float damp = (distanceToTarget < (objects[j].parameters.minChaseDistance + objects[j].parameters.maxChaseDistance) / 10) 
+                                     ? 0.5f : 1.0f;
+                        damp *= MOVEMENT_DAMPENING;
+
+                        if (distanceToTarget >= objects[j].parameters.minChaseDistance &&
+                            distanceToTarget <= objects[j].parameters.maxChaseDistance &&
+                            objects[j].pathing.chasing) {
+                            objects[j].ai.thrust += damp;
+                        } else if (!objects[j].pathing.chasing) {
+                            objects[j].ai.thrust += damp;
+                        }
+                    }
                 }
             }
+            
+            // Thrust every tick with the last decision, the physics doesn't wait for the AI
+            objects[j].velX += objects[j].forward[0] * objects[j].parameters.forwardSpeed * objects[j].ai.thrust;
+            objects[j].velY += objects[j].forward[1] * objects[j].parameters.forwardSpeed * objects[j].ai.thrust;
+            objects[j].velZ += objects[j].forward[2] * objects[j].parameters.forwardSpeed * objects[j].ai.thrust;
         } else {
 			for (int i = 0; i < numObjects; i++) {
-				if (&objects[j] == &objects[i] || objects[i].id == 10 || objects[i].id == 0 || objects[j].id == 10 || objects[j].id == 0) continue;
+				if (&objects[j] == &objects[i] || objects[i].id == 10 || objects[i].id == 0 || objects[i].id == 255 || objects[j].id == 10 || objects[j].id == 0) continue;
 				Vec3 gravVelocity = doGravity(&objects[j], &objects[i]);
 				objects[j].velX += gravVelocity.x;
 				objects[j].velY += gravVelocity.y;
@@ -1833,8 +2594,6 @@ void* processObjects(void* arg) {
 		} else if (objects[j].id == 1) {
 			//rotateObjectAroundAxis(&objects[j], objects[j].up, planets[objects[j].planetIndex].spin);
 		}
-		
-        calculateObjectCenter(&objects[j], objects[j].position);
 
         //float time = SDL_GetTicks() * 0.0005f;
         //float r = (sin(time) + 1.0f) / 2.0f;
@@ -1842,18 +2601,683 @@ void* processObjects(void* arg) {
         //float b = (sin(time + (4.0f * M_PI / 3.0f)) + 1.0f) / 2.0f;
         //objects[j].color = ((int)(r * 255) << 16) | ((int)(g * 255) << 8) | (int)(b * 255);
     }
+    free(heapRandoms);
     return NULL;
 }
 
+// Decides which AI ships get to steer this tick
+// Ships near the player steer every tick, further ones less often, and ones the camera can't see even less
+// If more are due than AI_BUDGET_PER_TICK the most urgent go first and the rest wait, so big fleets just
+// get a bit sluggish instead of blowing the tick time
+void scheduleAI(Object* objects, const SimInput* input) {
+    int dueCount[AI_MAX_INTERVAL + 1] = {0};
+    
+    for (int j = 0; j < numObjects; j++) {
+        AiSchedule* ai = &objects[j].ai;
+        ai->update = 0;
+        ai->priority = 0;
+        if (objects[j].id != 10) continue;
+        
+        float distance = fgetDistance3D(objects[j].position, objects[0].position);
+        int interval = 1 + (int)(distance / AI_NEAR_DISTANCE);
+        
+        // Same test as projecting it and checking it lands on screen, without touching the renderer's camera
+        float toObject[3] = {objects[j].position[0] - input->cameraPosition[0], objects[j].position[1] - input->cameraPosition[1],
+                             objects[j].position[2] - input->cameraPosition[2]};
+        float z = dotProduct(toObject, (float*)input->cameraForward);
+        float x = dotProduct(toObject, (float*)input->cameraRight);
+        float y = dotProduct(toObject, (float*)input->cameraUp);
+        if (z <= 0 || fabsf(x) > z || fabsf(y) > z * SCREEN_HEIGHT / SCREEN_WIDTH) {
+            interval *= 2;
+        }
+        if (interval > AI_MAX_INTERVAL) interval = AI_MAX_INTERVAL;
+        ai->interval = interval;
+        
+        if (simTick < ai->nextTick) continue;
+        
+        // The longer it's been waiting the more urgent it gets
+        int overdue = simTick - ai->nextTick;
+        int priority = interval - overdue;
+        if (priority < 1) priority = 1;
+        ai->priority = priority;
+        dueCount[priority]++;
+    }
+    
+    // Everything under the threshold priority fits in the budget, the threshold one gets what's left
+    int threshold = AI_MAX_INTERVAL + 1;
+    int remaining = 0;
+    int total = 0;
+    for (int p = 1; p <= AI_MAX_INTERVAL; p++) {
+        if (total + dueCount[p] > AI_BUDGET_PER_TICK) {
+            threshold = p;
+            remaining = AI_BUDGET_PER_TICK - total;
+            break;
+        }
+        total += dueCount[p];
+    }
+    
+    // Round robin from where the last tick stopped, so the threshold group takes turns
+    aiUpdates = 0;
+    aiDeferred = 0;
+    int lastPicked = aiCursor;
+    for (int k = 0; k < numObjects; k++) {
+        int j = (aiCursor + k) % numObjects;
+        AiSchedule* ai = &objects[j].ai;
+        if (!ai->priority) continue;
+        
+        if (ai->priority < threshold || (ai->priority == threshold && remaining > 0)) {
+            if (ai->priority == threshold) {
+                remaining--;
+                lastPicked = j;
+            }
+            ai->update = 1;
+            ai->nextTick = simTick + ai->interval;
+            aiUpdates++;
+        } else {
+            aiDeferred++;
+        }
+    }
+    if (numObjects > 0) aiCursor = (lastPicked + 1) % numObjects;
+}
+
+// Seeds every worker's generator from the world seed, so runs with the same seed and thread count match
+// The arenas start big enough for the randoms of every object already spawned, any worker could get all of them
+int initWorkers(uint64_t seed) {
+    size_t arenaSize = (size_t)numObjects * RANDOMS_PER_OBJECT * sizeof(float) + ARENA_ALIGNMENT;
+    if (arenaSize < WORKER_ARENA_SIZE) arenaSize = WORKER_ARENA_SIZE;
+    for (int i = 0; i < NUM_THREADS; i++) {
+        uint64_t state = seed + i;
+        rng4Seed(&workers[i].rng, splitmix64(&state));
+        if (arenaInit(&workers[i].arena, "worker", arenaSize) != 0) return -1;
+    }
+    return 0;
+}
+
+void freeWorkers() {
+    for (int i = 0; i < NUM_THREADS; i++) {
+        arenaFree(&workers[i].arena);
+    }
+}
+
+// Finds everything touching and bounces it apart, invincible things (planets, stars) don't get moved
+void resolveCollisions(Object* objects) {
+    uint64_t start = SDL_GetPerformanceCounter();
+    
+    CollisionBody* bodies = collisionBodies(&collisionWorld, numObjects);
+    if (!bodies) return;
+    for (int j = 0; j < numObjects; j++) {
+        CollisionBody* body = &bodies[j];
+        body->mesh = objects[j].mesh;
+        body->scale = objects[j].scale;
+        memcpy(body->position, objects[j].position, sizeof(body->position));
+        memcpy(body->forward, objects[j].forward, sizeof(body->forward));
+        memcpy(body->up, objects[j].up, sizeof(body->up));
+        memcpy(body->right, objects[j].right, sizeof(body->right));
+        if (objects[j].mesh) {
+            objectToWorld(&objects[j], objects[j].mesh->sphereCenter, body->center);
+            body->radius = objects[j].mesh->sphereRadius * objects[j].scale;
+        } else {
+            memcpy(body->center, objects[j].position, sizeof(body->center));
+            body->radius = objects[j].loadingMesh ? objects[j].avoidanceRadius : 0.0f; // Impostor, same size it's drawn
+        }
+    }
+    if (collide(&collisionWorld, &simArena) != 0) return;
+    
+    for (uint32_t i = 0; i < collisionWorld.numContacts; i++) {
+        const Contact* contact = &collisionWorld.contacts[i];
+        Object* a = &objects[contact->a];
+        Object* b = &objects[contact->b];
+        if (a->id == 255 || b->id == 255) continue; // Removed, still has a body at wherever it was
+        float inverseMassA = (a->invincible || a->mass <= 0) ? 0.0f : 1.0f / a->mass;
+        float inverseMassB = (b->invincible || b->mass <= 0) ? 0.0f : 1.0f / b->mass;
+        float totalInverseMass = inverseMassA + inverseMassB;
+        if (totalInverseMass <= 0.0f) continue;
+        const float* n = contact->normal;
+        
+        // Push them out of each other, the lighter one moves more
+        if (contact->depth > 0.0f) {
+            float push = contact->depth * COLLISION_CORRECTION / totalInverseMass;
+            moveObject(a, n[0] * push * inverseMassA, n[1] * push * inverseMassA, n[2] * push * inverseMassA);
+            moveObject(b, -n[0] * push * inverseMassB, -n[1] * push * inverseMassB, -n[2] * push * inverseMassB);
+        }
+        
+        // Only bounce if they're still moving into each other
+        float closing = (a->velX - b->velX) * n[0] + (a->velY - b->velY) * n[1] + (a->velZ - b->velZ) * n[2];
+        if (closing < 0.0f) {
+            if (closing < -EXPLOSION_SPEED && numTickBursts < MAX_BURSTS) {
+                ParticleBurst* burst = &tickBursts[numTickBursts++];
+                memcpy(burst->position, contact->point, sizeof(burst->position));
+                burst->color = EXPLOSION_COLOR;
+            }
+            float impulse = -(1.0f + COLLISION_RESTITUTION) * closing / totalInverseMass;
+            a->velX += n[0] * impulse * inverseMassA;
+            a->velY += n[1] * impulse * inverseMassA;
+            a->velZ += n[2] * impulse * inverseMassA;
+            b->velX -= n[0] * impulse * inverseMassB;
+            b->velY -= n[1] * impulse * inverseMassB;
+            b->velZ -= n[2] * impulse * inverseMassB;
+        }
+    }
+    
+    collisionTime = (SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency() * 1000.0;
+}
+
+// Puts every viper into the flock and buckets them, single threaded, before the workers steer them
+int buildFlock(Object* objects) {
+    if (flockReserve(&flock, numObjects) != 0) return -1;
+    if ((size_t)numObjects > flockCapacity) {
+        float (*steering)[3] = realloc(flockSteering, numObjects * sizeof(*flockSteering));
+        if (!steering) {
+            LOG_ERROR("Failed to allocate memory for flock steering\n");
+            return -1;
+        }
+        flockSteering = steering;
+        uint8_t* active = (uint8_t*)realloc(flockActive, numObjects);
+        if (!active) {
+            LOG_ERROR("Failed to allocate memory for flock steering\n");
+            return -1;
+        }
+        flockActive = active;
+        flockCapacity = numObjects;
+    }
+    
+    flock.count = 0;
+    for (int j = 0; j < numObjects; j++) {
+        if (objects[j].id != 10) continue;
+        float velocity[3] = {objects[j].velX, objects[j].velY, objects[j].velZ};
+        objects[j].flockIndex = flockAdd(&flock, objects[j].position, velocity);
+        flockActive[objects[j].flockIndex] = objects[j].ai.update;
+    }
+    flockBuildGrid(&flock, flockParams.neighbourRadius);
+    
+    // Everyone chases the player
+    flockParams.target[0] = objects[0].position[0];
+    flockParams.target[1] = objects[0].position[1];
+    flockParams.target[2] = objects[0].position[2];
+    flockParams.targetVelocity[0] = objects[0].velX;
+    flockParams.targetVelocity[1] = objects[0].velY;
+    flockParams.targetVelocity[2] = objects[0].velZ;
+    return 0;
+}
+
+// Buckets everything with an avoidance radius, single threaded, before the workers steer, the same counting sort
+// as the collision grid
+int buildAvoidanceGrid(Object* objects) {
+    avoidanceGrid.built = 0;
+    if ((uint32_t)numObjects > avoidanceGrid.capacity) {
+        uint32_t* bucketOf = (uint32_t*)realloc(avoidanceGrid.bucketOf, numObjects * sizeof(uint32_t));
+        if (bucketOf) avoidanceGrid.bucketOf = bucketOf;
+        uint32_t* sorted = (uint32_t*)realloc(avoidanceGrid.sorted, numObjects * sizeof(uint32_t));
+        if (sorted) avoidanceGrid.sorted = sorted;
+        float (*spheres)[4] = (float(*)[4])realloc(avoidanceGrid.sortedSpheres, numObjects * sizeof(float[4]));
+        if (spheres) avoidanceGrid.sortedSpheres = spheres;
+        uint32_t* large = (uint32_t*)realloc(avoidanceGrid.large, numObjects * sizeof(uint32_t));
+        if (large) avoidanceGrid.large = large;
+        if (!bucketOf || !sorted || !spheres || !large) {
+            LOG_ERROR("Failed to allocate memory for the avoidance grid\n");
+            return -1;
+        }
+        avoidanceGrid.capacity = numObjects;
+    }
+    
+    // Same split as the collision grid, one planet would make the cells big enough to hold every ship otherwise
+    float averageRadius = 0.0f;
+    int numAvoided = 0;
+    for (int j = 0; j < numObjects; j++) {
+        if (objects[j].avoidanceRadius <= 0.0f) continue;
+        averageRadius += objects[j].avoidanceRadius;
+        numAvoided++;
+    }
+    if (numAvoided) averageRadius /= numAvoided;
+    float largeRadius = averageRadius * AVOID_LARGE_FACTOR;
+    float biggestSmall = 0.0f;
+    avoidanceGrid.numLarge = 0;
+    for (int j = 0; j < numObjects; j++) {
+        float radius = objects[j].avoidanceRadius;
+        if (radius > largeRadius) avoidanceGrid.large[avoidanceGrid.numLarge++] = j;
+        else if (radius > biggestSmall) biggestSmall = radius;
+    }
+    avoidanceGrid.cellSize = biggestSmall > 0.0f ? biggestSmall : 1.0f;
+    
+    uint32_t numBuckets = 64;
+    while (numBuckets < (uint32_t)numObjects * 2) numBuckets <<= 1;
+    if (numBuckets + 1 > avoidanceGrid.bucketCapacity) {
+        uint32_t* bucketStart = (uint32_t*)realloc(avoidanceGrid.bucketStart, (numBuckets + 1) * sizeof(uint32_t));
+        if (!bucketStart) {
+            LOG_ERROR("Failed to allocate memory for the avoidance grid\n");
+            return -1;
+        }
+        avoidanceGrid.bucketStart = bucketStart;
+        avoidanceGrid.bucketCapacity = numBuckets + 1;
+    }
+    avoidanceGrid.numBuckets = numBuckets;
+    uint32_t mask = numBuckets - 1;
+    
+    // Nothing with a radius of 0 can be avoided, removed objects included, so they stay out
+    uint32_t* start = avoidanceGrid.bucketStart;
+    memset(start, 0, (numBuckets + 1) * sizeof(uint32_t));
+    for (int j = 0; j < numObjects; j++) {
+        float radius = objects[j].avoidanceRadius;
+        if (radius <= 0.0f || radius > largeRadius) {
+            avoidanceGrid.bucketOf[j] = UINT32_MAX;
+            continue;
+        }
+        const float* position = objects[j].position;
+        int cx = (int)floorf(position[0] / avoidanceGrid.cellSize), cy = (int)floorf(position[1] / avoidanceGrid.cellSize),
+            cz = (int)floorf(position[2] / avoidanceGrid.cellSize);
+        uint32_t bucket = ((uint32_t)cx * 73856093u ^ (uint32_t)cy * 19349663u ^ (uint32_t)cz * 83492791u) & mask;
+        avoidanceGrid.bucketOf[j] = bucket;
+        start[bucket]++;
+    }
+    uint32_t sum = 0;
+    for (uint32_t b = 0; b < numBuckets; b++) {
+        sum += start[b];
+        start[b] = sum;
+    }
+    start[numBuckets] = sum;
+    for (int j = numObjects; j-- > 0;) {
+        if (avoidanceGrid.bucketOf[j] == UINT32_MAX) continue;
+        uint32_t slot = --start[avoidanceGrid.bucketOf[j]];
+        avoidanceGrid.sorted[slot] = j;
+        memcpy(avoidanceGrid.sortedSpheres[slot], objects[j].position, sizeof(float[3]));
+        avoidanceGrid.sortedSpheres[slot][3] = objects[j].avoidanceRadius;
+    }
+    avoidanceGrid.built = 1;
+    return 0;
+}
+
+void freeAvoidanceGrid() {
+    free(avoidanceGrid.bucketStart);
+    free(avoidanceGrid.bucketOf);
+    free(avoidanceGrid.sorted);
+    free(avoidanceGrid.sortedSpheres);
+    free(avoidanceGrid.large);
+    memset(&avoidanceGrid, 0, sizeof(avoidanceGrid));
+}
+
+// Steers a slice of the flock, start and end are sorted flock slots here, not object indexes
+void* steerFlock(void* arg) {
+    ThreadData* data = (ThreadData*)arg;
+    flockSteerRange(&flock, &flockParams, data->start, data->end, flockActive, flockSteering);
+    return NULL;
+}
+
+// Spawns everything generateSector says is in a sector and records it, returns -1 if it ran out of memory
+int loadSector(SectorCoord coord) {
+    SectorSpawn spawns[SECTOR_MAX_SPAWNS];
+    int count = generateSector(worldSeed, coord, G, spawns);
+    LoadedSector* sector = addSector(&sectorMap, coord);
+    if (!sector) return -1;
+    sector->lastWanted = simTick;
+    if (count == 0) return 0;
+    sector->objects = (uint32_t*)malloc(count * sizeof(uint32_t));
+    if (!sector->objects) {
+        LOG_ERROR("Failed to allocate memory for sector objects\n");
+        return -1;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        const SectorSpawn* spawn = &spawns[i];
+        float fromOrigin = sqrtf(spawn->position[0] * spawn->position[0] + spawn->position[1] * spawn->position[1] +
+                                 spawn->position[2] * spawn->position[2]);
+        if (fromOrigin < SECTOR_CLEAR_RADIUS) continue;
+        
+        uint64_t index = addObject(sectorMeshFiles[spawn->kind], spawn->scale, spawn->position[0], spawn->position[1], spawn->position[2],
+                                   spawn->color, sectorIds[spawn->kind]);
+        if (index == (uint64_t)-1) return -1;
+        Object* object = &objects[index];
+        object->velX = spawn->velocity[0];
+        object->velY = spawn->velocity[1];
+        object->velZ = spawn->velocity[2];
+        if (spawn->kind == SECTOR_SHIP && object->pathing.destinations) {
+            // Same as the scene vipers, they go after the player once the AI gets to them
+            object->pathing.destinations[0] = (PathDestination){.position = {spawn->position[0], spawn->position[1], spawn->position[2]}, .strength = 1.0f};
+            object->pathing.numDestinations = 1;
+        }
+        sector->objects[sector->numObjects++] = (uint32_t)index;
+    }
+    sector->bytes = sizeof(LoadedSector) + sector->numObjects * (sizeof(uint32_t) + SECTOR_OBJECT_BYTES);
+    sectorMap.bytes += sector->bytes;
+    return 0;
+}
+
+// Gets the meshes for the sector just past the radius, the way the player is going, loading before they're needed
+// Generating a sector's spawn list is cheap, it's only done again once the player heads for a different one
+void prefetchAhead(int radius) {
+    float velocity[3] = {objects[0].velX, objects[0].velY, objects[0].velZ};
+    float speed = sqrtf(velocity[0] * velocity[0] + velocity[1] * velocity[1] + velocity[2] * velocity[2]);
+    if (speed < 1e-3f) return;
+    float reach = (radius + 1) * SECTOR_SIZE / speed;
+    float ahead[3] = {objects[0].position[0] + velocity[0] * reach, objects[0].position[1] + velocity[1] * reach,
+                      objects[0].position[2] + velocity[2] * reach};
+    SectorCoord coord = sectorOf(ahead);
+    if (coord.x == prefetchedSector.x && coord.y == prefetchedSector.y && coord.z == prefetchedSector.z) return;
+    prefetchedSector = coord;
+    
+    SectorSpawn spawns[SECTOR_MAX_SPAWNS];
+    int count = generateSector(worldSeed, coord, G, spawns);
+    for (int i = 0; i < count; i++) {
+        loaderPrefetchMesh(&assetLoader, sectorMeshFiles[spawns[i].kind]);
+    }
+}
+
+// Simulation thread, every tick: keeps the sectors around the player generated, nearest missing one first and
+// only one a tick so flying into new space doesn't make a tick take ages, then throws away whatever's been out
+// of range longest until it's back under the budget
+// Generating comes first so it only reuses slots freed on earlier ticks, a slot freed and refilled in the same
+// tick would get drawn sliding from the old object to the new one
+void updateSectors() {
+    if (!sectorsEnabled || numObjects == 0) return;
+    
+    SectorCoord center = sectorOf(objects[0].position);
+    int radius = sectorMap.radius;
+    int nearest = -1;
+    SectorCoord missing = center;
+    for (int dz = -radius; dz <= radius; dz++) {
+        for (int dy = -radius; dy <= radius; dy++) {
+            for (int dx = -radius; dx <= radius; dx++) {
+                SectorCoord coord = {center.x + dx, center.y + dy, center.z + dz};
+                LoadedSector* sector = findSector(&sectorMap, coord);
+                if (sector) {
+                    sector->lastWanted = simTick;
+                    continue;
+                }
+                int distance = dx * dx + dy * dy + dz * dz;
+                if (nearest < 0 || distance < nearest) {
+                    nearest = distance;
+                    missing = coord;
+                }
+            }
+        }
+    }
+    if (nearest >= 0 && loadSector(missing) != 0) {
+        LOG_ERROR("Failed to generate sector %d %d %d\n", missing.x, missing.y, missing.z);
+    }
+    if (nearest < 0) prefetchAhead(radius);
+    
+    while (sectorMap.bytes > sectorMap.budget) {
+        LoadedSector* oldest = oldestSector(&sectorMap, simTick);
+        if (!oldest) break; // Everything loaded is in range, the budget is just too small for the radius
+        for (uint32_t i = 0; i < oldest->numObjects; i++) {
+            removeObject(oldest->objects[i]);
+        }
+        removeSector(&sectorMap, oldest);
+    }
+}
+
+// Simulation thread, in between ticks: writes everything the simulation needs to carry on from here
+// The big arrays go out as they are, only the pointers in them need anything built, on the heap since they grow
+// with the world and the sim arena is kept for the tick
+int saveWorld(const char* filename, const float camera[3]) {
+    int result = -1;
+    int32_t* meshIndexes = (int32_t*)malloc((numObjects + 1) * sizeof(int32_t));
+    SavedMeshName* meshNames = (SavedMeshName*)malloc(SAVE_MAX_MESHES * sizeof(SavedMeshName));
+    SavedSector* savedSectors = (SavedSector*)malloc((sectorMap.numSectors + 1) * sizeof(SavedSector));
+    PathDestination* destinations = NULL;
+    uint32_t* sectorObjects = NULL;
+    if (!meshIndexes || !meshNames || !savedSectors) {
+        LOG_ERROR("Failed to allocate memory to save %d objects\n", numObjects);
+        goto done;
+    }
+    
+    uint32_t numMeshNames = 0;
+    size_t totalDestinations = 0, totalSectorObjects = 0;
+    for (int j = 0; j < numObjects; j++) {
+        const Object* object = &objects[j];
+        totalDestinations += object->pathing.numDestinations;
+        // Something still loading doesn't have a mesh yet, the loader knows which file it's waiting for
+        const char* file = object->mesh ? object->mesh->filename :
+                           object->loadingMesh ? assetLoader.assets[object->loadingMesh - 1].filename : NULL;
+        meshIndexes[j] = -1;
+        if (!file) continue;
+        uint32_t m = 0;
+        while (m < numMeshNames && strcmp(meshNames[m].file, file) != 0) m++;
+        if (m == numMeshNames) {
+            if (numMeshNames == SAVE_MAX_MESHES) {
+                LOG_ERROR("Too many different meshes to save\n");
+                goto done;
+            }
+            strncpy(meshNames[m].file, file, sizeof(meshNames[m].file) - 1);
+            meshNames[m].file[sizeof(meshNames[m].file) - 1] = '\0';
+            numMeshNames++;
+        }
+        meshIndexes[j] = m;
+    }
+    for (uint32_t i = 0; i < sectorMap.numSectors; i++) {
+        totalSectorObjects += sectorMap.sectors[i].numObjects;
+    }
+    
+    destinations = (PathDestination*)malloc((totalDestinations + 1) * sizeof(PathDestination));
+    sectorObjects = (uint32_t*)malloc((totalSectorObjects + 1) * sizeof(uint32_t));
+    if (!destinations || !sectorObjects) {
+        LOG_ERROR("Failed to allocate memory to save %zu path destinations\n", totalDestinations);
+        goto done;
+    }
+    PathDestination* nextDestination = destinations;
+    for (int j = 0; j < numObjects; j++) {
+        memcpy(nextDestination, objects[j].pathing.destinations, objects[j].pathing.numDestinations * sizeof(PathDestination));
+        nextDestination += objects[j].pathing.numDestinations;
+    }
+    uint32_t* nextSectorObject = sectorObjects;
+    for (uint32_t i = 0; i < sectorMap.numSectors; i++) {
+        const LoadedSector* sector = &sectorMap.sectors[i];
+        savedSectors[i] = (SavedSector){sector->coord, sector->numObjects, sector->lastWanted};
+        memcpy(nextSectorObject, sector->objects, sector->numObjects * sizeof(uint32_t));
+        nextSectorObject += sector->numObjects;
+    }
+    
+    Rng4 workerRngs[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++) workerRngs[i] = workers[i].rng;
+    SavedWorld world = {
+        .worldSeed = worldSeed,
+        .simTick = simTick,
+        .aiCursor = aiCursor,
+        .camera = {camera[0], camera[1], camera[2]},
+        .sectorsEnabled = sectorsEnabled,
+        .sectorRadius = sectorMap.radius,
+        .sectorBudget = sectorMap.budget,
+        .prefetchedSector = prefetchedSector
+    };
+    SaveSection sections[] = {
+        {SAVE_WORLD, sizeof(SavedWorld), 1, &world},
+        {SAVE_OBJECTS, sizeof(Object), numObjects, objects},
+        {SAVE_MESH_NAMES, sizeof(SavedMeshName), numMeshNames, meshNames},
+        {SAVE_OBJECT_MESHES, sizeof(int32_t), numObjects, meshIndexes},
+        {SAVE_DESTINATIONS, sizeof(PathDestination), totalDestinations, destinations},
+        {SAVE_FREE_SLOTS, sizeof(int), numAvailableObjectIndexes, availableObjectIndexes},
+        {SAVE_PLANETS, sizeof(Planet), numPlanets, planets},
+        {SAVE_STARS, sizeof(Star), numStars, stars},
+        {SAVE_WORKER_RNG, sizeof(Rng4), NUM_THREADS, workerRngs},
+        {SAVE_SECTORS, sizeof(SavedSector), sectorMap.numSectors, savedSectors},
+        {SAVE_SECTOR_OBJECTS, sizeof(uint32_t), totalSectorObjects, sectorObjects}
+    };
+    result = saveWrite(filename, SAVE_FORMAT, sections, sizeof(sections) / sizeof(sections[0]));
+    
+done:
+    free(meshIndexes);
+    free(meshNames);
+    free(savedSectors);
+    free(destinations);
+    free(sectorObjects);
+    return result;
+}
+
+// Before the simulation starts, instead of a scene: puts the world back how saveWorld found it
+// Objects, planets and stars are a memcpy each out of the mapping, then meshes and path destinations get hooked
+// back up, the destinations all go in one pooled allocation like spawnScene's
+int loadWorld(const char* filename) {
+    SaveFile file;
+    if (saveOpen(filename, &file) != 0) return -1;
+    
+    uint64_t numWorlds, count, numMeshNames, numMeshIndexes, numDestinations, numFreeSlots, savedPlanets, savedStars;
+    uint64_t numRngs, numSectors, numSectorObjects;
+    const SavedWorld* world = saveSection(&file, SAVE_WORLD, sizeof(SavedWorld), &numWorlds);
+    const Object* savedObjects = saveSection(&file, SAVE_OBJECTS, sizeof(Object), &count);
+    const SavedMeshName* meshNames = saveSection(&file, SAVE_MESH_NAMES, sizeof(SavedMeshName), &numMeshNames);
+    const int32_t* meshIndexes = saveSection(&file, SAVE_OBJECT_MESHES, sizeof(int32_t), &numMeshIndexes);
+    const PathDestination* destinations = saveSection(&file, SAVE_DESTINATIONS, sizeof(PathDestination), &numDestinations);
+    const int* freeSlots = saveSection(&file, SAVE_FREE_SLOTS, sizeof(int), &numFreeSlots);
+    const Planet* savedPlanetList = saveSection(&file, SAVE_PLANETS, sizeof(Planet), &savedPlanets);
+    const Star* savedStarList = saveSection(&file, SAVE_STARS, sizeof(Star), &savedStars);
+    const Rng4* workerRngs = saveSection(&file, SAVE_WORKER_RNG, sizeof(Rng4), &numRngs);
+    const SavedSector* savedSectors = saveSection(&file, SAVE_SECTORS, sizeof(SavedSector), &numSectors);
+    const uint32_t* sectorObjects = saveSection(&file, SAVE_SECTOR_OBJECTS, sizeof(uint32_t), &numSectorObjects);
+    if (file.version != SAVE_FORMAT || !world || numWorlds != 1 || !savedObjects || !meshNames || !meshIndexes ||
+        numMeshIndexes != count || !destinations || !freeSlots || !savedPlanetList || !savedStarList || !workerRngs ||
+        !savedSectors || !sectorObjects) {
+        printf("Save file is from a different build: %s\n", filename);
+        saveClose(&file);
+        return -1;
+    }
+    
+    // Everything the pointers will be rebuilt from has to add up before anything gets touched
+    uint64_t totalDestinations = 0, totalSectorObjects = 0;
+    int badMesh = 0;
+    for (uint64_t j = 0; j < count; j++) {
+        totalDestinations += savedObjects[j].pathing.numDestinations;
+        badMesh |= meshIndexes[j] >= (int32_t)numMeshNames;
+    }
+    for (uint64_t i = 0; i < numSectors; i++) totalSectorObjects += savedSectors[i].numObjects;
+    if (badMesh || totalDestinations != numDestinations || totalSectorObjects != numSectorObjects) {
+        printf("Save file doesn't add up: %s\n", filename);
+        saveClose(&file);
+        return -1;
+    }
+    
+    const Mesh** meshes = (const Mesh**)calloc(numMeshNames + 1, sizeof(Mesh*));
+    Object* loadedObjects = (Object*)malloc((count + 1) * sizeof(Object));
+    PathDestination* pathPool = (PathDestination*)malloc((numDestinations + 1) * sizeof(PathDestination));
+    int* slots = (int*)malloc((numFreeSlots + 1) * sizeof(int));
+    Planet* loadedPlanets = (Planet*)malloc((savedPlanets + 1) * sizeof(Planet));
+    Star* loadedStars = (Star*)malloc((savedStars + 1) * sizeof(Star));
+    void** pools = (void**)realloc(objectPools, (numObjectPools + 1) * sizeof(void*));
+    if (pools) objectPools = pools;
+    if (!meshes || !loadedObjects || !pathPool || !slots || !loadedPlanets || !loadedStars || !pools) {
+        printf("Failed to allocate memory for save file\n");
+        free(meshes); free(loadedObjects); free(pathPool); free(slots); free(loadedPlanets); free(loadedStars);
+        saveClose(&file);
+        return -1;
+    }
+    
+    memcpy(loadedObjects, savedObjects, count * sizeof(Object));
+    memcpy(pathPool, destinations, numDestinations * sizeof(PathDestination));
+    memcpy(slots, freeSlots, numFreeSlots * sizeof(int));
+    memcpy(loadedPlanets, savedPlanetList, savedPlanets * sizeof(Planet));
+    memcpy(loadedStars, savedStarList, savedStars * sizeof(Star));
+    for (uint64_t m = 0; m < numMeshNames; m++) {
+        meshes[m] = getMesh(meshNames[m].file);
+    }
+    
+    PathDestination* nextDestination = pathPool;
+    for (uint64_t j = 0; j < count; j++) {
+        Object* object = &loadedObjects[j];
+        object->mesh = meshIndexes[j] >= 0 ? meshes[meshIndexes[j]] : NULL;
+        // Was still waiting on its mesh when it was saved, so it never got the offset meshLoaded gives
+        if (object->loadingMesh && object->mesh) {
+            object->position[0] += object->mesh->center[0] * object->scale;
+            object->position[1] += object->mesh->center[1] * object->scale;
+            object->position[2] += object->mesh->center[2] * object->scale;
+        }
+        object->loadingMesh = 0;
+        object->pooled = 0;
+        object->pathing.destinations = NULL;
+        if (object->pathing.numDestinations > 0) {
+            object->pathing.destinations = nextDestination;
+            object->pooled |= POOLED_PATH;
+            nextDestination += object->pathing.numDestinations;
+        }
+    }
+    
+    objects = loadedObjects;
+    numObjects = objectCapacity = (int)count;
+    objectPools[numObjectPools++] = pathPool;
+    availableObjectIndexes = slots;
+    numAvailableObjectIndexes = availableObjectCapacity = (int)numFreeSlots;
+    planets = loadedPlanets;
+    numPlanets = (int)savedPlanets;
+    stars = loadedStars;
+    numStars = (int)savedStars;
+    // A different thread count can't carry on the same streams, those keep what initWorkers gave them
+    for (uint64_t i = 0; i < numRngs && i < NUM_THREADS; i++) workers[i].rng = workerRngs[i];
+    
+    worldSeed = world->worldSeed;
+    simTick = world->simTick;
+    aiCursor = world->aiCursor;
+    cameraPos = (Vec3){world->camera[0], world->camera[1], world->camera[2]};
+    sectorsEnabled = world->sectorsEnabled;
+    sectorMap.radius = world->sectorRadius;
+    sectorMap.budget = world->sectorBudget;
+    prefetchedSector = world->prefetchedSector;
+    const uint32_t* nextSectorObject = sectorObjects;
+    for (uint64_t i = 0; i < numSectors; i++) {
+        LoadedSector* sector = addSector(&sectorMap, savedSectors[i].coord);
+        if (sector) sector->lastWanted = savedSectors[i].lastWanted;
+        if (sector && savedSectors[i].numObjects > 0) {
+            sector->objects = (uint32_t*)malloc(savedSectors[i].numObjects * sizeof(uint32_t));
+        }
+        // Half a sector map would have sectors that never get unloaded, or get generated a second time
+        if (!sector || (savedSectors[i].numObjects > 0 && !sector->objects)) {
+            LOG_ERROR("Failed to allocate memory for the saved sectors: %s\n", filename);
+            free(meshes);
+            saveClose(&file);
+            return -1;
+        }
+        if (savedSectors[i].numObjects > 0) {
+            memcpy(sector->objects, nextSectorObject, savedSectors[i].numObjects * sizeof(uint32_t));
+            sector->numObjects = savedSectors[i].numObjects;
+        }
+        nextSectorObject += savedSectors[i].numObjects;
+        sector->bytes = sizeof(LoadedSector) + sector->numObjects * (sizeof(uint32_t) + SECTOR_OBJECT_BYTES);
+        sectorMap.bytes += sector->bytes;
+    }
+    
+    free(meshes);
+    saveClose(&file);
+    return 0;
+}
+
+void freeFlock() {
+    flockFree(&flock);
+    free(flockSteering);
+    free(flockActive);
+    flockSteering = NULL;
+    flockActive = NULL;
+    flockCapacity = 0;
+}
+
 void processObjectsMultithreaded(Object* objects) {
     pthread_t threads[NUM_THREADS];
     ThreadData threadData[NUM_THREADS];
+    
+    // All the flock steering has to be done before any viper uses it, so it gets its own pass
+    if (flocking) {
+        if (buildFlock(objects) != 0) {
+            flocking = 0;
+        } else {
+            int agentsPerThread = flock.count / NUM_THREADS;
+            for (int i = 0; i < NUM_THREADS; i++) {
+                threadData[i].objects = objects;
+                threadData[i].start = i * agentsPerThread;
+                threadData[i].end = (i == NUM_THREADS - 1) ? (int)flock.count : (i + 1) * agentsPerThread;
+                threadData[i].worker = &workers[i];
+                pthread_create(&threads[i], NULL, steerFlock, &threadData[i]);
+            }
+            for (int i = 0; i < NUM_THREADS; i++) {
+                pthread_join(threads[i], NULL);
+            }
+        }
+    }
+
+    // Only the chasing AI avoids, the flock's separation does it for the vipers otherwise
+    if (!flocking) buildAvoidanceGrid(objects);
+    else avoidanceGrid.built = 0;
 
     int objectsPerThread = numObjects / NUM_THREADS;
     for (int i = 0; i < NUM_THREADS; i++) {
         threadData[i].objects = objects;
         threadData[i].start = i * objectsPerThread;
         threadData[i].end = (i == NUM_THREADS - 1) ? numObjects : (i + 1) * objectsPerThread;
+        threadData[i].worker = &workers[i];
         pthread_create(&threads[i], NULL, processObjects, &threadData[i]);
     }
 
@@ -1862,7 +3286,576 @@ void processObjectsMultithreaded(Object* objects) {
     }
 }
 
+// Main thread, every frame: hands the keyboard and camera over to the simulation
+void sampleSimInput() {
+    const Uint8* state = SDL_GetKeyboardState(NULL);
+    pthread_mutex_lock(&simLock);
+    for (int k = 0; k < SDL_NUM_SCANCODES; k++) {
+        heldKeys[k] = state[k];
+        simInput.keys[k] |= state[k];
+    }
+    simInput.paused = paused;
+    simInput.firstPerson = firstPerson;
+    simInput.cameraPosition[0] = cameraPos.x; simInput.cameraPosition[1] = cameraPos.y; simInput.cameraPosition[2] = cameraPos.z;
+    simInput.cameraForward[0] = camForward.x; simInput.cameraForward[1] = camForward.y; simInput.cameraForward[2] = camForward.z;
+    simInput.cameraRight[0] = camRight.x; simInput.cameraRight[1] = camRight.y; simInput.cameraRight[2] = camRight.z;
+    simInput.cameraUp[0] = camUp.x; simInput.cameraUp[1] = camUp.y; simInput.cameraUp[2] = camUp.z;
+    pthread_mutex_unlock(&simLock);
+}
+
+// Simulation thread, every tick: takes everything pressed since the last tick, keys still held carry on
+void takeSimInput(SimInput* input) {
+    pthread_mutex_lock(&simLock);
+    *input = simInput;
+    memcpy(simInput.keys, heldKeys, sizeof(simInput.keys));
+    pthread_mutex_unlock(&simLock);
+}
+
+// Finds a snapshot nobody is using and makes room in it for count transforms, -1 if it couldn't
+int claimSnapshot(int count) {
+    pthread_mutex_lock(&simLock);
+    int index = 0;
+    while (index == latestSnapshot || index == renderSnapshots[0] || index == renderSnapshots[1]) index++;
+    pthread_mutex_unlock(&simLock);
+    
+    Snapshot* snapshot = &snapshots[index];
+    if (count > snapshot->capacity) {
+        RenderTransform* transforms = (RenderTransform*)realloc(snapshot->transforms, count * 2 * sizeof(RenderTransform));
+        if (!transforms) {
+            printf("Failed to allocate memory for snapshot\n");
+            return -1;
+        }
+        snapshot->transforms = transforms;
+        snapshot->capacity = count * 2;
+    }
+    return index;
+}
+
+// Copies every transform into a snapshot nobody is using and makes it the newest
+int publishSnapshot(float tickTime) {
+    int index = claimSnapshot(numObjects);
+    if (index < 0) return -1;
+    Snapshot* snapshot = &snapshots[index];
+    for (int j = 0; j < numObjects; j++) {
+        const Object* object = &objects[j];
+        RenderTransform* transform = &snapshot->transforms[j];
+        transform->mesh = object->mesh;
+        memcpy(transform->position, object->position, sizeof(transform->position));
+        memcpy(transform->forward, object->forward, sizeof(transform->forward));
+        memcpy(transform->up, object->up, sizeof(transform->up));
+        memcpy(transform->right, object->right, sizeof(transform->right));
+        transform->scale = object->scale;
+        transform->color = object->color;
+        transform->id = object->id;
+        transform->hidden = object->id == 255 || object->invisible;
+        // No mesh to tell how big it is yet, the avoidance radius is the closest thing there is
+        transform->impostorRadius = object->loadingMesh ? object->avoidanceRadius : 0.0f;
+        transform->velocity[0] = object->velX;
+        transform->velocity[1] = object->velY;
+        transform->velocity[2] = object->velZ;
+        transform->thrust = object->ai.thrust;
+    }
+    snapshot->count = numObjects;
+    snapshot->tick = simTick;
+    snapshot->tickTime = tickTime;
+    snapshot->overruns = tickOverruns;
+    snapshot->dropped = ticksDropped;
+    snapshot->time = SDL_GetPerformanceCounter();
+    
+    pthread_mutex_lock(&simLock);
+    latestSnapshot = index;
+    for (int i = 0; i < numTickBursts && numPendingBursts < MAX_BURSTS; i++) {
+        pendingBursts[numPendingBursts++] = tickBursts[i];
+    }
+    pthread_mutex_unlock(&simLock);
+    numTickBursts = 0;
+    return 0;
+}
+
+// Main thread: moves on to the newest snapshot if there is one, returns 1 if it did
+int acquireSnapshots(const Snapshot** previous, const Snapshot** current) {
+    pthread_mutex_lock(&simLock);
+    int fresh = latestSnapshot != renderSnapshots[1];
+    if (fresh) {
+        renderSnapshots[0] = renderSnapshots[1] >= 0 ? renderSnapshots[1] : latestSnapshot;
+        renderSnapshots[1] = latestSnapshot;
+    }
+    pthread_mutex_unlock(&simLock);
+    *previous = renderSnapshots[0] >= 0 ? &snapshots[renderSnapshots[0]] : NULL;
+    *current = renderSnapshots[1] >= 0 ? &snapshots[renderSnapshots[1]] : NULL;
+    return fresh;
+}
+
+// Main thread, every frame: emits the explosions published since last frame, the engine trails, then moves
+// every particle on by however long the frame was
+void updateEffects(float seconds) {
+    ParticleBurst bursts[MAX_BURSTS];
+    pthread_mutex_lock(&simLock);
+    int numBursts = numPendingBursts;
+    memcpy(bursts, pendingBursts, numBursts * sizeof(ParticleBurst));
+    numPendingBursts = 0;
+    pthread_mutex_unlock(&simLock);
+    
+    const float still[3] = {0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < numBursts; i++) {
+        particlesEmit(&particles, bursts[i].position, still, EXPLOSION_SPREAD, EXPLOSION_LIFE, bursts[i].color,
+                      EXPLOSION_PARTICLES, &effectsRng);
+    }
+    
+    // Whole particles only, the rest carries over so low frame times still get the full rate
+    engineEmitCarry += ENGINE_PARTICLE_RATE * seconds;
+    int perShip = (int)engineEmitCarry;
+    engineEmitCarry -= perShip;
+    for (int j = 0; j < frameTransformCount && perShip > 0; j++) {
+        const RenderTransform* transform = &frameTransforms[j];
+        if (transform->hidden || !transform->mesh || (transform->id != 0 && transform->id != 10)) continue;
+        const float* v = transform->velocity;
+        if (transform->thrust <= 0.0f) continue; // Engines off, coasting doesn't leave a trail
+        
+        // Thrust pushes along forward, so the engines are the back of the ship
+        float back = transform->mesh->radius * transform->scale;
+        float engine[3], velocity[3];
+        for (int k = 0; k < 3; k++) {
+            engine[k] = transform->position[k] - transform->forward[k] * back;
+            velocity[k] = v[k] * tickRate - transform->forward[k] * ENGINE_EXHAUST_SPEED;
+        }
+        particlesEmit(&particles, engine, velocity, ENGINE_PARTICLE_SPREAD, ENGINE_PARTICLE_LIFE, ENGINE_PARTICLE_COLOR,
+                      perShip, &effectsRng);
+    }
+    
+    particlesUpdate(&particles, seconds, PARTICLE_DRAG);
+}
+
+static inline void lerp3(float out[3], const float a[3], const float b[3], float t) {
+    out[0] = a[0] + (b[0] - a[0]) * t;
+    out[1] = a[1] + (b[1] - a[1]) * t;
+    out[2] = a[2] + (b[2] - a[2]) * t;
+}
+
+// Builds this frame's transforms t of the way from previous to current, into the frame arena
+// The basis vectors are lerped and renormalised, they only turn a little per tick so that's close enough to a slerp
+// Returns -1 if there was nowhere to put them, there's nothing to draw then
+int interpolateSnapshots(const Snapshot* previous, const Snapshot* current, float t) {
+    frameTransformCount = 0;
+    frameTransforms = (RenderTransform*)arenaAlloc(&frameArena, current->count * sizeof(RenderTransform));
+    if (!frameTransforms) {
+        // The arena only grows at the end of the frame, the heap keeps this one from coming out empty
+        if (current->count > heapTransformCapacity) {
+            RenderTransform* transforms = (RenderTransform*)realloc(heapTransforms, current->count * sizeof(RenderTransform));
+            if (!transforms) return -1;
+            heapTransforms = transforms;
+            heapTransformCapacity = current->count;
+        }
+        frameTransforms = heapTransforms;
+    }
+    
+    for (int j = 0; j < current->count; j++) {
+        RenderTransform* transform = &frameTransforms[j];
+        *transform = current->transforms[j];
+        if (transform->hidden || j >= previous->count) continue;
+        const RenderTransform* before = &previous->transforms[j];
+        // Slot got reused for something else, nothing to come from
+        if (before->hidden || before->mesh != transform->mesh) continue;
+        lerp3(transform->position, before->position, current->transforms[j].position, t);
+        lerp3(transform->forward, before->forward, current->transforms[j].forward, t);
+        lerp3(transform->up, before->up, current->transforms[j].up, t);
+        lerp3(transform->right, before->right, current->transforms[j].right, t);
+        fnormalize(transform->forward);
+        fnormalize(transform->up);
+        fnormalize(transform->right);
+    }
+    frameTransformCount = current->count;
+    return 0;
+}
+
+// The simulation thread, runs tickRate fixed length ticks per second of real time and publishes a snapshot after each
+// Real time goes into an accumulator and every full tick period in it gets simulated, so the game runs at the
+// same speed whatever the frame rate or how long a tick takes, as long as ticks fit in their period on average
+void* simulate(void* arg) {
+    (void)arg;
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+    uint64_t period = frequency / tickRate;
+    uint64_t lastTime = SDL_GetPerformanceCounter();
+    uint64_t accumulator = 0;
+    SimInput input;
+    
+    while (isRunning()) {
+        uint64_t now = SDL_GetPerformanceCounter();
+        accumulator += now - lastTime;
+        lastTime = now;
+        if (accumulator < period) {
+            uint32_t wait = (uint32_t)((period - accumulator) * 1000 / frequency);
+            SDL_Delay(wait > 0 ? wait : 1);
+            continue;
+        }
+        
+        // Fallen too far behind (slow ticks, the window being dragged), catching all of it up would only
+        // make the next frame later still, so the world just slows down for a moment instead
+        if (accumulator > MAX_CATCH_UP_TICKS * period) {
+            ticksDropped += (uint32_t)(accumulator / period) - MAX_CATCH_UP_TICKS;
+            accumulator = MAX_CATCH_UP_TICKS * period;
+        }
+        
+        while (accumulator >= period && isRunning()) {
+            accumulator -= period;
+            takeSimInput(&input);
+            // Time doesn't pile up while paused
+            if (input.paused) {
+                accumulator = 0;
+                break;
+            }
+            
+            uint64_t tickStart = SDL_GetPerformanceCounter();
+            arenaReset(&simArena);
+            handleSimInput(&input);
+            loaderPoll(&assetLoader);
+            updateSectors();
+            scheduleAI(objects, &input);
+            processObjectsMultithreaded(objects);
+            resolveCollisions(objects);
+            simTick++;
+            
+            uint64_t tickTicks = SDL_GetPerformanceCounter() - tickStart;
+            if (tickTicks > period) tickOverruns++;
+            if (publishSnapshot(tickTicks * 1000.0 / frequency) != 0) return NULL;
+        }
+    }
+    return NULL;
+}
+
+// Server, every tick: turns the newest snapshot into entities and sends it to every client
+// Entity ids are object indexes, removed objects just aren't sent and the slot comes back as something new
+int broadcastSnapshot(const Snapshot* snapshot) {
+    if ((uint32_t)snapshot->count > netEntityCapacity) {
+        NetEntity* entities = (NetEntity*)realloc(netEntities, snapshot->count * 2 * sizeof(NetEntity));
+        if (!entities) {
+            printf("Failed to allocate memory for network entities\n");
+            return -1;
+        }
+        netEntities = entities;
+        netEntityCapacity = snapshot->count * 2;
+    }
+    
+    uint32_t count = 0;
+    for (int j = 0; j < snapshot->count; j++) {
+        const RenderTransform* transform = &snapshot->transforms[j];
+        if (transform->hidden) continue;
+        NetEntity* entity = &netEntities[count++];
+        entity->id = j;
+        memcpy(entity->position, transform->position, sizeof(entity->position));
+        netOrientationFromBasis(transform->forward, transform->up, transform->right, entity->orientation);
+        entity->scale = transform->scale;
+        entity->color = transform->color;
+        entity->kind = transform->id;
+        // Meshes are shared, so comparing pointers finds the index without going near the names
+        entity->mesh = NET_NO_MESH;
+        if (!transform->mesh) continue;
+        for (uint32_t m = 0; m < netServer.numMeshes; m++) {
+            if (netServerMeshes[m] == transform->mesh) {
+                entity->mesh = (uint16_t)m;
+                break;
+            }
+        }
+        if (entity->mesh == NET_NO_MESH) {
+            entity->mesh = netServerMesh(&netServer, transform->mesh->filename);
+            if (entity->mesh != NET_NO_MESH) netServerMeshes[entity->mesh] = transform->mesh;
+        }
+    }
+    return netServerBroadcast(&netServer, snapshot->tick + 1, netEntities, count); // Tick 0 means none on the wire
+}
+
+// Client, network thread: makes the newest snapshot from the server into a renderer snapshot, indexed by entity id
+// so interpolateSnapshots lines things up the same way it does locally
+int publishNetSnapshot() {
+    uint32_t count = netClientEntities(&netClient, netEntities, netEntityCapacity);
+    if (count > netEntityCapacity) {
+        NetEntity* entities = (NetEntity*)realloc(netEntities, count * 2 * sizeof(NetEntity));
+        if (!entities) {
+            printf("Failed to allocate memory for network entities\n");
+            return -1;
+        }
+        netEntities = entities;
+        netEntityCapacity = count * 2;
+        count = netClientEntities(&netClient, netEntities, netEntityCapacity);
+    }
+    
+    int slots = count > 0 ? (int)netEntities[count - 1].id + 1 : 0;
+    int index = claimSnapshot(slots);
+    if (index < 0) return -1;
+    Snapshot* snapshot = &snapshots[index];
+    // Velocity from the last one, only the particles use it
+    pthread_mutex_lock(&simLock);
+    const Snapshot* previous = latestSnapshot >= 0 ? &snapshots[latestSnapshot] : NULL;
+    pthread_mutex_unlock(&simLock);
+    uint32_t ticks = previous && netClient.latestTick > previous->tick ? netClient.latestTick - previous->tick : 1;
+    
+    memset(snapshot->transforms, 0, slots * sizeof(RenderTransform));
+    for (int j = 0; j < slots; j++) snapshot->transforms[j].hidden = 1;
+    for (uint32_t i = 0; i < count; i++) {
+        const NetEntity* entity = &netEntities[i];
+        RenderTransform* transform = &snapshot->transforms[entity->id];
+        if (entity->mesh != NET_NO_MESH && !netClientMeshes[entity->mesh] && netClient.meshNames[entity->mesh][0]) {
+            netClientMeshes[entity->mesh] = getMesh(netClient.meshNames[entity->mesh]);
+        }
+        transform->mesh = entity->mesh != NET_NO_MESH ? netClientMeshes[entity->mesh] : NULL;
+        memcpy(transform->position, entity->position, sizeof(transform->position));
+        netBasisFromOrientation(entity->orientation, transform->forward, transform->up, transform->right);
+        transform->scale = entity->scale;
+        transform->color = entity->color;
+        transform->id = entity->kind;
+        transform->hidden = transform->mesh == NULL; // Nothing to draw it with yet
+        if (previous && (int)entity->id < previous->count && !previous->transforms[entity->id].hidden) {
+            for (int k = 0; k < 3; k++) {
+                transform->velocity[k] = (transform->position[k] - previous->transforms[entity->id].position[k]) / ticks;
+            }
+        }
+        // Thrust doesn't go over the wire, moving is the closest thing a client has to go on
+        const float* v = transform->velocity;
+        transform->thrust = v[0] * v[0] + v[1] * v[1] + v[2] * v[2] >= 0.01f ? 1.0f : 0.0f;
+    }
+    snapshot->count = slots;
+    snapshot->tick = netClient.latestTick;
+    snapshot->tickTime = 0.0f;
+    snapshot->time = SDL_GetPerformanceCounter();
+    
+    pthread_mutex_lock(&simLock);
+    latestSnapshot = index;
+    if (netClient.tickRate > 0) tickRate = netClient.tickRate;
+    pthread_mutex_unlock(&simLock);
+    return 0;
+}
+
+// Client, takes the simulation thread's place: gets snapshots from the server and tells it where the camera is
+void* receiveSnapshots(void* arg) {
+    (void)arg;
+    while (isRunning()) {
+        pthread_mutex_lock(&simLock);
+        memcpy(netClient.view, simInput.cameraPosition, sizeof(netClient.view));
+        pthread_mutex_unlock(&simLock);
+        
+        int fresh = netClientPoll(&netClient);
+        if (fresh < 0 || (fresh > 0 && publishNetSnapshot() != 0)) {
+            LOG_ERROR("Lost the connection, out of memory\n");
+            return NULL;
+        }
+        if (fresh == 0) SDL_Delay(1);
+    }
+    return NULL;
+}
+
+void freeSnapshots() {
+    for (int i = 0; i < SNAPSHOT_COUNT; i++) {
+        free(snapshots[i].transforms);
+        snapshots[i].transforms = NULL;
+        snapshots[i].count = snapshots[i].capacity = 0;
+    }
+}
+
+void setRenderScale(float scale) {
+    renderScale = CLAMP(scale, RENDER_SCALE_MIN, 1.0f);
+    // Width kept to a multiple of 4 so every RGB row stays 4 byte aligned for glDrawPixels
+    renderWidth = ((int)(SCREEN_WIDTH * renderScale)) & ~3;
+    renderHeight = (int)(SCREEN_HEIGHT * renderScale);
+    renderScale = (float)renderWidth / SCREEN_WIDTH;
+    f = renderWidth / 2.0f;
+}
+
+// Averages the render time over a few frames and moves the internal resolution towards whatever
+// should hit the target, the cost is mostly per pixel so it goes with the square of the scale
+// Only ever moves by a step at a time and leaves a dead band around the target, so it doesn't flicker
+void updateRenderScale(float renderTime) {
+    static float renderTimeSum = 0.0f;
+    static int frames = 0;
+    
+    renderTimeSum += renderTime;
+    if (++frames < RENDER_SCALE_FRAMES) return;
+    float average = renderTimeSum / frames;
+    renderTimeSum = 0.0f;
+    frames = 0;
+    if (average <= 0.0f) return;
+    
+    if (average < renderTargetMs * 0.85f && renderScale >= 1.0f) return;
+    if (average > renderTargetMs * 0.85f && average < renderTargetMs * 1.05f) return;
+    
+    float wanted = renderScale * sqrtf(renderTargetMs / average);
+    float scale = CLAMP(wanted, renderScale - RENDER_SCALE_STEP, renderScale + RENDER_SCALE_STEP);
+    if (fabsf(scale - renderScale) < 0.01f) return;
+    setRenderScale(scale);
+}
+
+// Everything the simulation and the views need, then the world from a save, a scene, or nothing at all for a
+// client that gets its world from a server
+int setupWorld(const char* sceneFile, const char* saveFile) {
+    if (logInit() != 0 || loaderStart(&assetLoader, meshLoaded, NULL) != 0) {
+        return -1;
+    }
+    
+    uint64_t sceneStart = SDL_GetPerformanceCounter();
+    Scene scene;
+    memset(&scene, 0, sizeof(Scene));
+    if (sceneFile && !saveFile && (loadScene(sceneFile, &scene) != 0 || spawnScene(&scene) != 0)) {
+        printf("Failed to load scene: %s\n", sceneFile);
+        return -1;
+    }
+    if (scene.hasCamera) {
+        cameraPos = (Vec3){scene.camera[0], scene.camera[1], scene.camera[2]};
+    }
+    if (scene.hasSeed) {
+        worldSeed = scene.seed;
+    }
+    if (scene.hasSectors) {
+        sectorsEnabled = 1;
+        sectorMap.radius = scene.sectorRadius;
+        sectorMap.budget = scene.sectorBudget;
+    }
+    for (uint32_t i = 0; i < scene.numPrefetch; i++) {
+        loaderPrefetchMesh(&assetLoader, scene.prefetch[i]);
+    }
+    if (arenaInit(&frameArena, "frame", FRAME_ARENA_SIZE) != 0 || arenaInit(&simArena, "sim", SIM_ARENA_SIZE) != 0 ||
+        initWorkers(worldSeed) != 0 || hizInit(&depthPyramid) != 0 || radarInit(&radar, RADAR_WIDTH, RADAR_HEIGHT, RADAR_RANGE) != 0 ||
+        particlesInit(&particles, MAX_PARTICLES) != 0) {
+        return -1;
+    }
+    // After initWorkers, the save has the workers' generators where they were
+    if (saveFile && loadWorld(saveFile) != 0) {
+        printf("Failed to load save: %s\n", saveFile);
+        return -1;
+    }
+    rngSeed(&effectsRng, worldSeed ^ 0x5A5A5A5A); // Its own stream, sparks don't change what the simulation does
+    if (sceneFile || saveFile) {
+        printf("Loaded %s: %d objects in %.2f ms\n", saveFile ? saveFile : sceneFile, numObjects,
+               (SDL_GetPerformanceCounter() - sceneStart) * 1000.0 / SDL_GetPerformanceFrequency());
+    }
+    freeScene(&scene);
+    return 0;
+}
+
+// The other half, once whatever fills the snapshots has stopped
+void shutdownWorld() {
+    loaderStop(&assetLoader);
+    freeSnapshots();
+    freeSectorMap(&sectorMap);
+    freeObjects();
+    freeMeshes();
+    freeWorkers();
+    freeFlock();
+    freeAvoidanceGrid();
+    freeDrawOrder();
+    freeCollisionWorld(&collisionWorld);
+    arenaFree(&frameArena);
+    arenaFree(&simArena);
+    hizFree(&depthPyramid);
+    stopRadarWorker();
+    radarFree(&radar);
+    particlesFree(&particles);
+    free(heapTransforms);
+    heapTransforms = NULL;
+    heapTransformCapacity = 0;
+    free(netEntities);
+    netEntities = NULL;
+    netEntityCapacity = 0;
+    logShutdown();
+}
+
+void handleStopSignal(int signal) {
+    (void)signal;
+    stopRequested = 1;
+}
+
+// --server, no window, the simulation runs like it always does and this thread sends every snapshot it publishes
+int runServer(const char* sceneFile, const char* saveFile, uint16_t port) {
+    if (SDL_Init(SDL_INIT_TIMER) < 0) {
+        printf("SDL could not initialize: %s\n", SDL_GetError());
+        return -1;
+    }
+    if (setupWorld(sceneFile, saveFile) != 0 || netServerStart(&netServer, port, NET_INTEREST_RADIUS, tickRate) != 0) {
+        return -1;
+    }
+    signal(SIGINT, handleStopSignal);
+    signal(SIGTERM, handleStopSignal);
+    if (publishSnapshot(0.0f) != 0 || pthread_create(&simThread, NULL, simulate, NULL) != 0) {
+        printf("Failed to start the simulation\n");
+        return -1;
+    }
+    printf("Serving on port %u, %d ticks a second, Ctrl+C to stop\n", port, tickRate);
+    
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+    uint64_t lastStats = SDL_GetPerformanceCounter();
+    uint64_t bytes = 0;
+    float encodeTime = 0.0f;
+    int broadcasts = 0;
+    while (isRunning() && !stopRequested) {
+        netServerPoll(&netServer);
+        const Snapshot *previousSnapshot, *currentSnapshot;
+        if (!acquireSnapshots(&previousSnapshot, &currentSnapshot)) {
+            SDL_Delay(1);
+            continue;
+        }
+        if (broadcastSnapshot(currentSnapshot) != 0) break;
+        bytes += netServer.bytesSent;
+        encodeTime += netServer.encodeTime;
+        broadcasts++;
+        
+        uint64_t now = SDL_GetPerformanceCounter();
+        if (now - lastStats >= frequency) {
+            printf("Server: %d clients, %d objects, tick %.2f ms, %.1f KB/s out, %.3f ms encoding per tick, %u full snapshots last tick\n",
+                   netServer.clients, numObjects, currentSnapshot->tickTime, bytes / 1024.0 * frequency / (now - lastStats),
+                   encodeTime / broadcasts, netServer.fullSnapshots);
+            lastStats = now;
+            bytes = 0;
+            encodeTime = 0.0f;
+            broadcasts = 0;
+        }
+    }
+    
+    stopRunning();
+    pthread_join(simThread, NULL);
+    netServerStop(&netServer);
+    shutdownWorld();
+    SDL_Quit();
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
+    // Everything in the world comes from a scene file, default.scene is the old hardcoded setup
+    const char* sceneFile = "default.scene";
+    const char* saveFile = NULL;
+    const char* serverAddress = NULL;
+    int serverMode = 0;
+    int port = NET_PORT;
+    PresentMode presentMode = PRESENT_TEXTURE;
+    int presentCheckOnly = 0;
+    const char* simdForce = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--target-ms") == 0 && i + 1 < argc) {
+            renderTargetMs = strtof(argv[++i], NULL);
+            if (renderTargetMs <= 0.0f) renderTargetMs = RENDER_TARGET_MS;
+        } else if (strcmp(argv[i], "--present") == 0 && i + 1 < argc) {
+            i++;
+            presentMode = strcmp(argv[i], "drawpixels") == 0 ? PRESENT_DRAW_PIXELS : PRESENT_TEXTURE;
+        } else if (strcmp(argv[i], "--present-check") == 0) {
+            presentCheckOnly = 1;
+        } else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            saveFile = argv[++i];
+        } else if (strcmp(argv[i], "--server") == 0) {
+            serverMode = 1;
+        } else if (strcmp(argv[i], "--connect") == 0 && i + 1 < argc) {
+            serverAddress = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+            if (port <= 0 || port > 65535) port = NET_PORT;
+        } else if (strcmp(argv[i], "--simd") == 0 && i + 1 < argc) {
+            simdForce = argv[++i];
+        } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            tickRate = atoi(argv[++i]);
+            if (tickRate <= 0 || tickRate > 1000) tickRate = TICK_RATE;
+        } else {
+            sceneFile = argv[i];
+        }
+    }
+    printf("SIMD kernels: %s\n", simdInit(simdForce));
+    if (serverMode) return runServer(sceneFile, saveFile, (uint16_t)port);
+    
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         printf("SDL could not initialize: %s\n", SDL_GetError());
         return -1;
@@ -1885,7 +3878,6 @@ int main(int argc, char* argv[]) {
     uint64_t frequency = SDL_GetPerformanceFrequency();
     
     uint64_t lastTime = SDL_GetPerformanceCounter();
-	uint64_t lastLogicTime = SDL_GetPerformanceCounter();
     uint64_t frameStart, frameEnd;
     
     SDL_GLContext glContext = SDL_GL_CreateContext(window);
@@ -1893,53 +3885,57 @@ int main(int argc, char* argv[]) {
     glewInit();
     SDL_GL_SetSwapInterval(0);
     
-    // Allocate pixel buffer (RGB format)
-    unsigned char* pixels = (unsigned char*)malloc(SCREEN_WIDTH * SCREEN_HEIGHT * 3);
+    // Allocate pixel buffer (BGRA format)
+    unsigned char* pixels = (unsigned char*)malloc(SCREEN_WIDTH * SCREEN_HEIGHT * BYTES_PER_PIXEL);
     if (!pixels) {
         printf("Failed to allocate pixel buffer\n");
         return -1;
     }
-    unsigned char* pixels2 = (unsigned char*)malloc(SCREEN_WIDTH * SCREEN_HEIGHT * 3);
+    unsigned char* pixels2 = (unsigned char*)malloc(SCREEN_WIDTH * SCREEN_HEIGHT * BYTES_PER_PIXEL);
     if (!pixels2) {
         printf("Failed to allocate second pixel buffer\n");
         return -1;
     }
     
-    addObject("cobra.bin", 1, 20000, 0, 0, 0xA900FF, 0);
-    addObject("sphere.bin", 1000, 25000, 0, 0, 0x0000FF, 1);
-    //addObject("theory.bin", 10000, 0, 0, 0, 0xFFFFFF, 0);
-
-    //addPlanet((float[3]){100, 100, 100}, 0xFFFFFF, 10000, 0); 
+    if (presentInit(&presenter, presentMode, SCREEN_WIDTH, SCREEN_HEIGHT) != 0) {
+        return -1;
+    }
+    printf("Presenting with %s\n", presentModeName(presenter.mode));
+    if (hudInit(&hud, HUD_SCALE) != 0) {
+        return -1;
+    }
+    if (presentCheckOnly) {
+        int windowWidth, windowHeight;
+        SDL_GetWindowSize(window, &windowWidth, &windowHeight);
+        int wrong = presentCheck(&presenter, windowWidth, windowHeight);
+        presentFree(&presenter);
+        return wrong == 0 ? 0 : 1;
+    }
     
-    int amount = 1000;
-    int size = (int)ceil(cbrt(amount)); // Find the cube root to arrange in 3D
-	int index = 0; // Track object count
-	
-	for (int x = -size/2; x < size/2; x++) {
-	    for (int y = -size/2; y < size/2; y++) {
-	        for (int z = -size/2; z < size/2; z++) {
-	            if (index >= amount) break; // Stop after placing
-	
-	            float posX = 20000 + x * 2.0f;
-	            float posY = y * 2.0f;
-	            float posZ = z * 2.0f;
+    if (setupWorld(serverAddress ? NULL : sceneFile, serverAddress ? NULL : saveFile) != 0) {
+        return -1;
+    }
+    if (serverAddress && netClientConnect(&netClient, serverAddress, (uint16_t)port) != 0) {
+        return -1;
+    }
 	
-	            // Add the object and set up its path
-	            int objectID = addObject("viper.bin", 1, posX, posY, posZ, 0xFF0000, 10);
-	            addPath(&objects[objectID], (PathDestination){.position = {0, 0, 0}, .velX = 0, .velY = 0, .velZ = 0, .strength = 1.0f});
+	//generateSkyboxStars((float[3]){0,0,0});
 	
-	            //printf("Object %d placed at: [%.2f, %.2f, %.2f]\n", index, posX, posY, posZ);
+	settings.bumpscosity.value = 1;
 	
-	            index++;
-	        }
+	// The first snapshot is the world as loaded, then the simulation takes over on its own thread
+	// A client starts with an empty one and fills them from the server instead
+	if (serverAddress) {
+	    if (publishNetSnapshot() != 0 || pthread_create(&simThread, NULL, receiveSnapshots, NULL) != 0) {
+	        printf("Failed to start receiving from the server\n");
+	        return -1;
 	    }
+	} else if (publishSnapshot(0.0f) != 0 || pthread_create(&simThread, NULL, simulate, NULL) != 0) {
+	    printf("Failed to start the simulation\n");
+	    return -1;
 	}
-	
-	//generateSkyboxStars((float[3]){0,0,0});
-	
-	settings.bumpscosity.value = 1;
     
-    while (running) {
+    while (isRunning()) {
 		// Just in case the frequency changes
 	    frequency = SDL_GetPerformanceFrequency();
 	    
@@ -1947,30 +3943,35 @@ int main(int argc, char* argv[]) {
 		
 		float frameSkyboxStart = SDL_GetTicks();
         // Handle events
-        while (SDL_PollEvent(&event)) {
+        // Nothing on the pause menu changes without input, so a paused frame sleeps until there is some
+        int windowChanged = 0;
+        int pending = paused ? SDL_WaitEventTimeout(&event, PAUSE_WAIT_MS) : SDL_PollEvent(&event);
+        for (; pending; pending = SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT)
-                running = 0;
+                stopRunning();
+            if (event.type == SDL_WINDOWEVENT)
+                windowChanged = 1; // Resized or uncovered, the menu has to go up again even if it's the same
+            if (paused)
+                pause_menu_event(&event);
         }
         
-		// Calculate elapsed time since last logic execution (in ticks)
-        uint64_t elapsedTime = frameStart - lastLogicTime;
-        float elapsedTimeInSeconds = (float)elapsedTime / frequency;
-        float elapsedTimeInMs = elapsedTimeInSeconds * 1000.0f;
-        
-        
         uint64_t logicStart = SDL_GetPerformanceCounter();
-        // Updates work on a 30 tps system
-        if (elapsedTimeInMs >= 33.33f) {
-			memset(pixels2, 0, SCREEN_WIDTH * SCREEN_HEIGHT * 3);
-			handleInput(pixels);
-            // Now that all the inputs have been handled, do the logic
-	        if (!paused) {
-				processObjectsMultithreaded(objects);
-			}
+        float frameTicks = (float)(frameStart - lastTime) * TICK_RATE / frequency;
+        handleCameraInput(pixels, fminf(frameTicks, 4.0f)); // Clamped so a hitch doesn't throw the camera across the map
+        sampleSimInput();
+        
+        // Draw a tick behind the simulation, in between the last two snapshots, so motion stays smooth at any fps
+        const Snapshot *previousSnapshot, *currentSnapshot;
+        if (acquireSnapshots(&previousSnapshot, &currentSnapshot)) {
+			memset(pixels2, 0, renderWidth * renderHeight * BYTES_PER_PIXEL);
+        }
+        float t = (float)(frameStart - currentSnapshot->time) * tickRate / frequency;
+        if (interpolateSnapshots(previousSnapshot, currentSnapshot, CLAMP(t, 0.0f, 1.0f)) != 0) {
+            LOG_ERROR("Failed to allocate memory for %d interpolated transforms, skipping the world this frame\n", currentSnapshot->count);
         }
         
-        if (firstPerson) {
-			setCameraToObject(&objects[0], 0.3f, -0.5f, 0.0f);
+        if (firstPerson && frameTransformCount > 0) {
+			setCameraToObject(&frameTransforms[0], 0.3f, -0.5f, 0.0f);
 		}
   		uint64_t logicEnd = SDL_GetPerformanceCounter();
                 
@@ -1979,17 +3980,29 @@ int main(int argc, char* argv[]) {
 	    camRight = rotateVecByQuat((Vec3){1, 0, 0}, cameraOrientation);
 	    camUp = rotateVecByQuat((Vec3){0, 1, 0}, cameraOrientation);
 	    
-        // Clear the pixel buffer (black background)
-        memset(pixels, 0, SCREEN_WIDTH * SCREEN_HEIGHT * 3);
+        // The pause menu is always drawn at full resolution
+        // It keeps the buffer between frames and only draws what changed, a game frame overwrites all of it instead
+        int frameWidth = paused ? SCREEN_WIDTH : renderWidth;
+        int frameHeight = paused ? SCREEN_HEIGHT : renderHeight;
+        static int wasPaused = 0;
+        int menuChanged = 0;
+        DirtyRect dirty = {0, 0, 0, 0};
         
         if (!paused) {
-			memcpy(pixels, pixels2, SCREEN_WIDTH * SCREEN_HEIGHT * 3);
+			memcpy(pixels, pixels2, renderWidth * renderHeight * BYTES_PER_PIXEL);
 	        // Keep drawSkyboxStars out of the main render function, to make sure it's always first
 			drawSkyboxStars(pixels);
+			updateEffects(fminf((float)(frameStart - lastTime) / frequency, 0.1f)); // Clamped like the camera
 			renderScene(pixels);
+			if (hudEnabled) {
+			    hudSetScale(&hud, (int)(HUD_SCALE * renderScale + 0.5f));
+			    hudDraw(&hud, (uint32_t*)pixels, renderWidth, renderHeight, &hudStats);
+			}
 		} else {
-			draw_pause_menu(pixels, &event);
+			if (!wasPaused) pause_menu_invalidate(); // The game's been drawing over it
+			menuChanged = draw_pause_menu(pixels, &dirty);
 		}
+		wasPaused = paused;
         uint64_t renderEnd = SDL_GetPerformanceCounter();
         
         uint64_t rasterStart = SDL_GetPerformanceCounter();
@@ -1997,28 +4010,25 @@ int main(int argc, char* argv[]) {
 		int windowWidth, windowHeight;
 		SDL_GetWindowSize(window, &windowWidth, &windowHeight);
 		
-		// Set up an orthographic projection that matches the window size
-		glMatrixMode(GL_PROJECTION);
-		glLoadIdentity();
-		glOrtho(0, windowWidth, 0, windowHeight, -10, 10);
-		glMatrixMode(GL_MODELVIEW);
-		glLoadIdentity();
-		
-		// Enable pixel zoom to scale the image to fit the window
-		float zoomX = (float)windowWidth / (float)SCREEN_WIDTH;
-		float zoomY = (float)windowHeight / (float)SCREEN_HEIGHT;
-		glPixelZoom(zoomX, zoomY);
-		
-		// Set the raster position to the lower-left corner
-		glRasterPos2i(0, 0);
-		glDrawPixels(SCREEN_WIDTH, SCREEN_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, pixels);
-		SDL_GL_SwapWindow(window);
+		if (!paused) {
+			presentFrame(&presenter, pixels, frameWidth, frameHeight, windowWidth, windowHeight);
+			SDL_GL_SwapWindow(window);
+		} else if (menuChanged || windowChanged) {
+			// Only the rectangle the menu drew over gets uploaded, the rest of the last frame is still in the texture
+			presentFrameRegion(&presenter, pixels, frameWidth, frameHeight, dirty.x, dirty.y, dirty.width, dirty.height,
+			                   windowWidth, windowHeight);
+			SDL_GL_SwapWindow(window);
+		}
 
         uint64_t rasterEnd = SDL_GetPerformanceCounter();
         
         static float fpsSum = 0.0f;
 		static float frameTimeSum = 0.0f;
 		static float logicTimeSum = 0.0f;
+		static float tickTimeSum = 0.0f;
+		static int tickCount = 0;
+		static uint32_t lastCountedTick = 0;
+		static uint32_t lastOverruns = 0, lastDropped = 0;
 		static float renderTimeSum = 0.0f;
 		static float rasterTimeSum = 0.0f;
 		
@@ -2033,6 +4043,23 @@ int main(int argc, char* argv[]) {
 	    float logicTime = ((uint64_t)(logicEnd - logicStart) / (double)frequency) * 1000.0;
 	    float renderTime = ((uint64_t)(renderEnd - renderStart) / (double)frequency) * 1000.0;
 	    float rasterTime = ((uint64_t)(rasterEnd - rasterStart) / (double)frequency) * 1000.0;
+	    
+	    if (!paused) updateRenderScale(renderTime);
+	    
+	    // For the overlay on the next frame
+	    hudRecord(&hud, frameTimeInMs);
+	    hudStats.frameMs = frameTimeInMs;
+	    hudStats.fps = hudStats.fps * 0.9f + (frameTimeInMs > 0.0f ? 1000.0f / frameTimeInMs : 0.0f) * 0.1f;
+	    hudStats.logicMs = logicTime;
+	    hudStats.renderMs = renderTime;
+	    hudStats.rasterMs = rasterTime;
+	    hudStats.objectsDrawn = drawnObjects;
+	    hudStats.triangles = drawnTriangles;
+	    hudStats.edges = drawnEdges;
+	    hudStats.culled = occlusionCulled;
+	    hudStats.aiUpdates = aiUpdates; // The simulation thread's, read unlocked like the stats printout
+	    hudStats.width = renderWidth;
+	    hudStats.height = renderHeight;
 	
 	    if (frameTime > 0) {
 	        float actualFPS = 1000.0f / frameTimeInMs;
@@ -2041,6 +4068,11 @@ int main(int argc, char* argv[]) {
 	        fpsSum += actualFPS;
 	        frameTimeSum += frameTimeInMs;
 	        logicTimeSum += logicTime;
+	        if (currentSnapshot->tick != lastCountedTick) {
+	            tickTimeSum += currentSnapshot->tickTime;
+	            tickCount++;
+	            lastCountedTick = currentSnapshot->tick;
+	        }
 	        renderTimeSum += renderTime;
 	        rasterTimeSum += rasterTime;
 	        frameCount++;
@@ -2051,17 +4083,56 @@ int main(int argc, char* argv[]) {
 	            float avgFPS = fpsSum / frameCount;
 	            float avgFrameTime = frameTimeSum / frameCount;
 	            float avgLogicTime = logicTimeSum / frameCount;
+	            float avgTickTime = tickCount ? tickTimeSum / tickCount : 0.0f;
 	            float avgRenderTime = renderTimeSum / frameCount;
 	            float avgRasterTime = rasterTimeSum / frameCount;
 	
 	            // Print averages
-	            printf("AVG FPS: %-9.2f \tmspf: %-7.2f logic time: %-8.3f render time: %-8.3f raster time: %-8.3f (over %d frames)\n",
+	            printf("AVG FPS: %-9.2f \tmspf: %-7.2f input time: %-8.3f render time: %-8.3f raster time: %-8.3f (over %d frames)\n",
 	                   avgFPS, avgFrameTime, avgLogicTime, avgRenderTime, avgRasterTime, frameCount);
+	            printf("Simulation: %-8.3f ms per tick on its own thread (over %d ticks at %d Hz), %u overran, %u dropped\n",
+	                   avgTickTime, tickCount, tickRate, currentSnapshot->overruns - lastOverruns, currentSnapshot->dropped - lastDropped);
+	            lastOverruns = currentSnapshot->overruns;
+	            lastDropped = currentSnapshot->dropped;
+	            printf("AI: %d updates, %d deferred last tick\n", aiUpdates, aiDeferred);
+	            printf("Collisions: %u contacts, %u pairs, %u triangle tests, %.3f ms last tick\n", collisionWorld.numContacts,
+	                   collisionWorld.broadPairs, collisionWorld.narrowTests, collisionTime);
+	            printf("Resolution: %dx%d (%.0f%%), target %.2f ms render time\n", renderWidth, renderHeight,
+	                   renderScale * 100.0f, renderTargetMs);
+	            printf("Occlusion: %d occluders, %d of %d objects culled last frame, %.3f ms building the pyramid\n",
+	                   occluderCount, occlusionCulled, occlusionTested, occlusionTime);
+	            printf("Views: main %.3f ms, radar %.3f ms on its own thread (%d blips), overlay %.3f ms last frame\n", mainViewTime,
+	                   radarEnabled ? radarTime : 0.0f, radarEnabled ? radar.blipsDrawn : 0, hudEnabled ? hud.drawTime : 0.0f);
+	            printf("Particles: %zu alive, %zu drawn last frame, %llu emitted, %llu dropped\n", particles.count,
+	                   particlesDrawn, (unsigned long long)particles.emitted, (unsigned long long)particles.dropped);
+	            printf("Draw order: %d insertion sorts, %d radix sorts\n", drawOrderInsertionSorts, drawOrderRadixSorts);
+	            drawOrderInsertionSorts = 0;
+	            drawOrderRadixSorts = 0;
+	            size_t workerHighWater = 0;
+	            for (int i = 0; i < NUM_THREADS; i++) {
+	                if (workers[i].arena.highWater > workerHighWater) workerHighWater = workers[i].arena.highWater;
+	            }
+	            printf("Arenas: frame %zu KB high water of %zu KB, sim %zu KB of %zu KB, worker %zu KB high water of %zu KB\n",
+	                   frameArena.highWater / 1024, frameArena.capacity / 1024, simArena.highWater / 1024, simArena.capacity / 1024,
+	                   workerHighWater / 1024, workers[0].arena.capacity / 1024);
+	            // Same as the sectors, unlocked reads of counters
+	            printf("Loader: %u loaded, %u failed, %u prefetch hits, %.2f ms loading in the background\n", assetLoader.loaded,
+	                   assetLoader.failed, assetLoader.prefetchHits, assetLoader.loadTime);
+	            printf("Log: %llu written, %llu suppressed, %llu dropped\n", (unsigned long long)logStats.written,
+	                   (unsigned long long)logStats.suppressed, (unsigned long long)logStats.dropped);
+	            if (sectorsEnabled) {
+	                // Read without the lock, it's only stats and a torn value just prints wrong for a second
+	                printf("Sectors: %u loaded, %zu KB of %zu KB budget, %u generated, %u evicted, %d objects\n",
+	                       sectorMap.numSectors, sectorMap.bytes / 1024, sectorMap.budget / 1024, sectorMap.generated,
+	                       sectorMap.evicted, currentSnapshot->count);
+	            }
 	
 	            // Reset counters
 	            fpsSum = 0.0f;
 	            frameTimeSum = 0.0f;
 	            logicTimeSum = 0.0f;
+	            tickTimeSum = 0.0f;
+	            tickCount = 0;
 	            renderTimeSum = 0.0f;
 	            rasterTimeSum = 0.0f;
 	            frameCount = 0;
@@ -2075,13 +4146,22 @@ int main(int argc, char* argv[]) {
 	        printf("Frametime less than 0?\n");
 	    }
 
+        // Everything the frame allocated from the arena is done with now
+        arenaReset(&frameArena);
+        
         // Update last time
         lastTime = frameStart;
     }
     
-    freeObjects();
+    // Let the simulation finish its tick before anything it uses goes away
+    pthread_join(simThread, NULL);
+    if (serverAddress) netClientClose(&netClient);
+    shutdownWorld();
     free(pixels);
     free(pixels2);
+    hudFree(&hud);
+    free_pause_menu();
+    presentFree(&presenter);
     SDL_GL_DeleteContext(glContext);
     SDL_DestroyWindow(window);
     SDL_Quit();
@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <emmintrin.h>
+#include "flock.h"
+
+// Sorted arrays get a few floats of slack so the SSE loop can always load 4 at a time
+#define FLOCK_PADDING 4
+
+static uint32_t nextPowerOfTwo(size_t n) {
+    uint32_t p = 64;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// Runs of 4 cells along z hash together and get consecutive buckets, so the z neighbours of a cell
+// are usually next to it in the sorted arrays and can be scanned in one go
+#define FLOCK_RUN 4
+
+static inline uint32_t hashCell(int x, int y, int z, uint32_t mask) {
+    uint32_t run = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)(z >> 2) * 83492791u;
+    return (run * FLOCK_RUN + (z & (FLOCK_RUN - 1))) & mask;
+}
+
+static inline int cellCoordinate(float v, float inverseCellSize) {
+    return (int)floorf(v * inverseCellSize);
+}
+
+int flockReserve(Flock* flock, size_t capacity) {
+    if (capacity <= flock->capacity) return 0;
+
+    float** arrays[] = {
+        &flock->posX, &flock->posY, &flock->posZ,
+        &flock->velX, &flock->velY, &flock->velZ,
+        &flock->sortedPosX, &flock->sortedPosY, &flock->sortedPosZ,
+        &flock->sortedVelX, &flock->sortedVelY, &flock->sortedVelZ
+    };
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+        float* grown = (float*)realloc(*arrays[i], (capacity + FLOCK_PADDING) * sizeof(float));
+        if (!grown) {
+            printf("Failed to allocate memory for flock\n");
+            return -1;
+        }
+        *arrays[i] = grown;
+    }
+
+    uint32_t** indexArrays[] = {&flock->bucketOf, &flock->sortedAgent};
+    for (size_t i = 0; i < sizeof(indexArrays) / sizeof(indexArrays[0]); i++) {
+        uint32_t* grown = (uint32_t*)realloc(*indexArrays[i], capacity * sizeof(uint32_t));
+        if (!grown) {
+            printf("Failed to allocate memory for flock\n");
+            return -1;
+        }
+        *indexArrays[i] = grown;
+    }
+
+    // Twice as many buckets as agents keeps hash collisions between unrelated cells rare
+    uint32_t* bucketStart = (uint32_t*)realloc(flock->bucketStart, (nextPowerOfTwo(capacity * 2) + 1) * sizeof(uint32_t));
+    if (!bucketStart) {
+        printf("Failed to allocate memory for flock\n");
+        return -1;
+    }
+    flock->bucketStart = bucketStart;
+
+    flock->capacity = capacity;
+    return 0;
+}
+
+void flockFree(Flock* flock) {
+    free(flock->posX);
+    free(flock->posY);
+    free(flock->posZ);
+    free(flock->velX);
+    free(flock->velY);
+    free(flock->velZ);
+    free(flock->sortedPosX);
+    free(flock->sortedPosY);
+    free(flock->sortedPosZ);
+    free(flock->sortedVelX);
+    free(flock->sortedVelY);
+    free(flock->sortedVelZ);
+    free(flock->bucketOf);
+    free(flock->sortedAgent);
+    free(flock->bucketStart);
+    memset(flock, 0, sizeof(Flock));
+}
+
+void flockBuildGrid(Flock* flock, float cellSize) {
+    size_t count = flock->count;
+    flock->numBuckets = nextPowerOfTwo(count * 2);
+    flock->inverseCellSize = 1.0f / cellSize;
+    uint32_t mask = flock->numBuckets - 1;
+    uint32_t* start = flock->bucketStart;
+
+    // Counting sort by bucket, count first, then turn the counts into where each bucket ends
+    memset(start, 0, (flock->numBuckets + 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < count; i++) {
+        uint32_t bucket = hashCell(cellCoordinate(flock->posX[i], flock->inverseCellSize),
+                                   cellCoordinate(flock->posY[i], flock->inverseCellSize),
+                                   cellCoordinate(flock->posZ[i], flock->inverseCellSize), mask);
+        flock->bucketOf[i] = bucket;
+        start[bucket]++;
+    }
+    uint32_t sum = 0;
+    for (uint32_t b = 0; b < flock->numBuckets; b++) {
+        sum += start[b];
+        start[b] = sum;
+    }
+    start[flock->numBuckets] = sum;
+
+    // Filling from the back moves every bucket's end down to its start
+    for (size_t i = count; i-- > 0;) {
+        uint32_t slot = --start[flock->bucketOf[i]];
+        flock->sortedPosX[slot] = flock->posX[i];
+        flock->sortedPosY[slot] = flock->posY[i];
+        flock->sortedPosZ[slot] = flock->posZ[i];
+        flock->sortedVelX[slot] = flock->velX[i];
+        flock->sortedVelY[slot] = flock->velY[i];
+        flock->sortedVelZ[slot] = flock->velZ[i];
+        flock->sortedAgent[slot] = i;
+    }
+}
+
+static inline float horizontalSum(__m128 v) {
+    __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+
+// Scales v to length weight, leaves it alone if it's zero
+static inline void weightDirection(float v[3], float weight) {
+    float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (length < 1e-6f) {
+        v[0] = v[1] = v[2] = 0.0f;
+        return;
+    }
+    float s = weight / length;
+    v[0] *= s;
+    v[1] *= s;
+    v[2] *= s;
+}
+
+static void steerAt(const Flock* flock, const FlockParams* params, float x, float y, float z,
+                    float velX, float velY, float velZ, float steer[3]) {
+    int cx = cellCoordinate(x, flock->inverseCellSize);
+    int cy = cellCoordinate(y, flock->inverseCellSize);
+    int cz = cellCoordinate(z, flock->inverseCellSize);
+    uint32_t mask = flock->numBuckets - 1;
+
+    __m128 px = _mm_set1_ps(x), py = _mm_set1_ps(y), pz = _mm_set1_ps(z);
+    __m128 radiusSqr = _mm_set1_ps(params->neighbourRadius * params->neighbourRadius);
+    __m128 separationSqr = _mm_set1_ps(params->separationRadius * params->separationRadius);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    const __m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+
+    __m128 count = zero;
+    __m128 sepX = zero, sepY = zero, sepZ = zero;
+    __m128 aliX = zero, aliY = zero, aliZ = zero;
+    __m128 cohX = zero, cohY = zero, cohZ = zero;
+
+    // Different columns can hash to the same buckets, only scan each range once
+    uint32_t visited[18];
+    int numVisited = 0;
+
+    for (int ox = -1; ox <= 1; ox++) {
+        for (int oy = -1; oy <= 1; oy++) {
+            // The three cells of the column, as one bucket range when they're in the same run, two otherwise
+            uint32_t ranges[2][2];
+            int numRanges = 0;
+            if (((cz - 1) >> 2) == ((cz + 1) >> 2)) {
+                ranges[numRanges][0] = hashCell(cx + ox, cy + oy, cz - 1, mask);
+                ranges[numRanges++][1] = hashCell(cx + ox, cy + oy, cz + 1, mask);
+            } else {
+                int split = ((cz - 1) >> 2) == (cz >> 2) ? cz : cz - 1; // Last cell of the first run
+                ranges[numRanges][0] = hashCell(cx + ox, cy + oy, cz - 1, mask);
+                ranges[numRanges++][1] = hashCell(cx + ox, cy + oy, split, mask);
+                ranges[numRanges][0] = hashCell(cx + ox, cy + oy, split + 1, mask);
+                ranges[numRanges++][1] = hashCell(cx + ox, cy + oy, cz + 1, mask);
+            }
+
+            for (int r = 0; r < numRanges; r++) {
+                int seen = 0;
+                for (int v = 0; v < numVisited; v++) {
+                    if (visited[v] == ranges[r][0]) {
+                        seen = 1;
+                        break;
+                    }
+                }
+                if (seen) continue;
+                visited[numVisited++] = ranges[r][0];
+
+                uint32_t begin = flock->bucketStart[ranges[r][0]];
+                uint32_t end = flock->bucketStart[ranges[r][1] + 1];
+                __m128i endLanes = _mm_set1_epi32((int)end);
+
+                for (uint32_t k = begin; k < end; k += 4) {
+                    // Lanes past the end of the range read the padding/next bucket and get masked off
+                    __m128 valid = _mm_castsi128_ps(_mm_cmplt_epi32(_mm_add_epi32(_mm_set1_epi32((int)k), lanes), endLanes));
+
+                    __m128 dx = _mm_sub_ps(_mm_loadu_ps(flock->sortedPosX + k), px);
+                    __m128 dy = _mm_sub_ps(_mm_loadu_ps(flock->sortedPosY + k), py);
+                    __m128 dz = _mm_sub_ps(_mm_loadu_ps(flock->sortedPosZ + k), pz);
+                    __m128 distanceSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+                    // Zero distance is the agent itself (or something right on top of it, nothing sensible to do there)
+                    __m128 notSelf = _mm_and_ps(valid, _mm_cmpgt_ps(distanceSqr, zero));
+                    __m128 near = _mm_and_ps(notSelf, _mm_cmplt_ps(distanceSqr, radiusSqr));
+                    __m128 tooClose = _mm_and_ps(notSelf, _mm_cmplt_ps(distanceSqr, separationSqr));
+
+                    count = _mm_add_ps(count, _mm_and_ps(near, one));
+                    cohX = _mm_add_ps(cohX, _mm_and_ps(near, dx));
+                    cohY = _mm_add_ps(cohY, _mm_and_ps(near, dy));
+                    cohZ = _mm_add_ps(cohZ, _mm_and_ps(near, dz));
+                    aliX = _mm_add_ps(aliX, _mm_and_ps(near, _mm_loadu_ps(flock->sortedVelX + k)));
+                    aliY = _mm_add_ps(aliY, _mm_and_ps(near, _mm_loadu_ps(flock->sortedVelY + k)));
+                    aliZ = _mm_add_ps(aliZ, _mm_and_ps(near, _mm_loadu_ps(flock->sortedVelZ + k)));
+
+                    // Push away harder the closer it is, 1/distance in the direction away
+                    __m128 inverse = _mm_and_ps(tooClose, _mm_div_ps(one, distanceSqr));
+                    sepX = _mm_sub_ps(sepX, _mm_mul_ps(dx, inverse));
+                    sepY = _mm_sub_ps(sepY, _mm_mul_ps(dy, inverse));
+                    sepZ = _mm_sub_ps(sepZ, _mm_mul_ps(dz, inverse));
+                }
+            }
+        }
+    }
+
+    float neighbours = horizontalSum(count);
+    float separation[3] = {horizontalSum(sepX), horizontalSum(sepY), horizontalSum(sepZ)};
+    float alignment[3] = {0.0f, 0.0f, 0.0f};
+    float cohesion[3] = {0.0f, 0.0f, 0.0f};
+
+    if (neighbours > 0.0f) {
+        float inverseCount = 1.0f / neighbours;
+        // Match the average velocity, steer towards the average position
+        alignment[0] = horizontalSum(aliX) * inverseCount - velX;
+        alignment[1] = horizontalSum(aliY) * inverseCount - velY;
+        alignment[2] = horizontalSum(aliZ) * inverseCount - velZ;
+        cohesion[0] = horizontalSum(cohX) * inverseCount;
+        cohesion[1] = horizontalSum(cohY) * inverseCount;
+        cohesion[2] = horizontalSum(cohZ) * inverseCount;
+    }
+
+    // Aim where the target will be by the time we get there, not where it is
+    float toTarget[3] = {params->target[0] - x, params->target[1] - y, params->target[2] - z};
+    float distance = sqrtf(toTarget[0] * toTarget[0] + toTarget[1] * toTarget[1] + toTarget[2] * toTarget[2]);
+    float lookAhead = params->maxSpeed > 0.0f ? distance / params->maxSpeed : 0.0f;
+    float pursuit[3] = {
+        toTarget[0] + params->targetVelocity[0] * lookAhead,
+        toTarget[1] + params->targetVelocity[1] * lookAhead,
+        toTarget[2] + params->targetVelocity[2] * lookAhead
+    };
+
+    weightDirection(separation, params->separationWeight);
+    weightDirection(alignment, params->alignmentWeight);
+    weightDirection(cohesion, params->cohesionWeight);
+    weightDirection(pursuit, params->pursuitWeight);
+
+    steer[0] = separation[0] + alignment[0] + cohesion[0] + pursuit[0];
+    steer[1] = separation[1] + alignment[1] + cohesion[1] + pursuit[1];
+    steer[2] = separation[2] + alignment[2] + cohesion[2] + pursuit[2];
+}
+
+void flockSteer(const Flock* flock, const FlockParams* params, uint32_t agent, float steer[3]) {
+    steerAt(flock, params, flock->posX[agent], flock->posY[agent], flock->posZ[agent],
+            flock->velX[agent], flock->velY[agent], flock->velZ[agent], steer);
+}
+
+void flockSteerRange(const Flock* flock, const FlockParams* params, uint32_t begin, uint32_t end,
+                     const uint8_t* active, float (*steer)[3]) {
+    for (uint32_t slot = begin; slot < end; slot++) {
+        uint32_t agent = flock->sortedAgent[slot];
+        if (active && !active[agent]) continue;
+        steerAt(flock, params, flock->sortedPosX[slot], flock->sortedPosY[slot], flock->sortedPosZ[slot],
+                flock->sortedVelX[slot], flock->sortedVelY[slot], flock->sortedVelZ[slot], steer[agent]);
+    }
+}
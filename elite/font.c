@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <emmintrin.h>
+#include "font.h"
+
+const unsigned char fontGlyphs[FONT_GLYPHS][FONT_HEIGHT] = {
+    {0b01110, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001},  // 'A'
+    {0b11110, 0b10001, 0b10001, 0b11110, 0b10001, 0b10001, 0b11110},  // 'B'
+    {0b01110, 0b10001, 0b10000, 0b10000, 0b10000, 0b10001, 0b01110},  // 'C'
+    {0b11110, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b11110},  // 'D'
+    {0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b11111},  // 'E'
+    {0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b10000},  // 'F'
+    {0b01110, 0b10001, 0b10000, 0b10111, 0b10001, 0b10001, 0b01110},  // 'G'
+    {0b10001, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001},  // 'H'
+    {0b01110, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110},  // 'I'
+    {0b00111, 0b00010, 0b00010, 0b00010, 0b00010, 0b10010, 0b01100},  // 'J'
+    {0b10001, 0b10010, 0b10100, 0b11000, 0b10100, 0b10010, 0b10001},  // 'K'
+    {0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b11111},  // 'L'
+    {0b10001, 0b11011, 0b10101, 0b10101, 0b10001, 0b10001, 0b10001},  // 'M'
+    {0b10001, 0b10001, 0b11001, 0b10101, 0b10011, 0b10001, 0b10001},  // 'N'
+    {0b01110, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110},  // 'O'
+    {0b11110, 0b10001, 0b10001, 0b11110, 0b10000, 0b10000, 0b10000},  // 'P'
+    {0b01110, 0b10001, 0b10001, 0b10001, 0b10101, 0b10010, 0b01101},  // 'Q'
+    {0b11110, 0b10001, 0b10001, 0b11110, 0b10100, 0b10010, 0b10001},  // 'R'
+    {0b01111, 0b10000, 0b10000, 0b01110, 0b00001, 0b00001, 0b11110},  // 'S'
+    {0b11111, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100},  // 'T'
+    {0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110},  // 'U'
+    {0b10001, 0b10001, 0b10001, 0b10001, 0b01010, 0b01010, 0b00100},  // 'V'
+    {0b10001, 0b10001, 0b10001, 0b10101, 0b10101, 0b11011, 0b10001},  // 'W'
+    {0b10001, 0b10001, 0b01010, 0b00100, 0b01010, 0b10001, 0b10001},  // 'X'
+    {0b10001, 0b10001, 0b01010, 0b00100, 0b00100, 0b00100, 0b00100},  // 'Y'
+    {0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b10000, 0b11111},  // 'Z'
+    {0b01110, 0b10001, 0b10011, 0b10101, 0b11001, 0b10001, 0b01110},  // '0'
+    {0b00100, 0b01100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110},  // '1'
+    {0b01110, 0b10001, 0b00001, 0b00010, 0b00100, 0b01000, 0b11111},  // '2'
+    {0b11111, 0b00010, 0b00100, 0b00010, 0b00001, 0b10001, 0b01110},  // '3'
+    {0b00010, 0b00110, 0b01010, 0b10010, 0b11111, 0b00010, 0b00010},  // '4'
+    {0b11111, 0b10000, 0b11110, 0b00001, 0b00001, 0b10001, 0b01110},  // '5'
+    {0b00110, 0b01000, 0b10000, 0b11110, 0b10001, 0b10001, 0b01110},  // '6'
+    {0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b01000, 0b01000},  // '7'
+    {0b01110, 0b10001, 0b10001, 0b01110, 0b10001, 0b10001, 0b01110},  // '8'
+    {0b01110, 0b10001, 0b10001, 0b01111, 0b00001, 0b00010, 0b01100},  // '9'
+    {0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b01100, 0b01100},  // '.'
+    {0b00000, 0b01100, 0b01100, 0b00000, 0b01100, 0b01100, 0b00000},  // ':'
+    {0b00000, 0b00000, 0b00000, 0b11111, 0b00000, 0b00000, 0b00000},  // '-'
+    {0b00001, 0b00010, 0b00010, 0b00100, 0b01000, 0b01000, 0b10000},  // '/'
+    {0b11001, 0b11010, 0b00010, 0b00100, 0b01000, 0b01011, 0b10011},  // '%'
+    {0b00010, 0b00100, 0b01000, 0b01000, 0b01000, 0b00100, 0b00010},  // '('
+    {0b01000, 0b00100, 0b00010, 0b00010, 0b00010, 0b00100, 0b01000},  // ')'
+    {0b00000, 0b00100, 0b00100, 0b11111, 0b00100, 0b00100, 0b00000}   // '+'
+};
+
+static const char fontPunctuation[] = ".:-/%()+";
+
+const unsigned char* fontGlyph(unsigned char c) {
+    if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+    if (c >= 'A' && c <= 'Z') return fontGlyphs[c - 'A'];
+    if (c >= '0' && c <= '9') return fontGlyphs[c - '0' + 26];
+    const char* punctuation = c ? strchr(fontPunctuation, c) : NULL;
+    return punctuation ? fontGlyphs[36 + (punctuation - fontPunctuation)] : NULL;
+}
+
+int fontAtlasInit(FontAtlas* atlas, int scale) {
+    if (scale < 1) scale = 1;
+    atlas->scale = scale;
+    atlas->glyphWidth = FONT_WIDTH * scale;
+    atlas->glyphHeight = FONT_HEIGHT * scale;
+    atlas->advance = (FONT_WIDTH + 1) * scale;
+    atlas->rowWidth = (atlas->glyphWidth + 3) & ~3;
+    atlas->colored = NULL;
+    size_t glyphSize = (size_t)atlas->rowWidth * atlas->glyphHeight;
+    atlas->masks = (uint32_t*)malloc(FONT_GLYPHS * glyphSize * sizeof(uint32_t));
+    if (!atlas->masks) {
+        printf("Failed to allocate memory for the font atlas\n");
+        return -1;
+    }
+
+    for (int g = 0; g < FONT_GLYPHS; g++) {
+        uint32_t* mask = atlas->masks + g * glyphSize;
+        for (int y = 0; y < atlas->glyphHeight; y++) {
+            unsigned char bits = fontGlyphs[g][FONT_HEIGHT - 1 - y / scale]; // The frame's upside down
+            for (int x = 0; x < atlas->rowWidth; x++) {
+                int lit = x < atlas->glyphWidth && bits & (1 << (FONT_WIDTH - 1 - x / scale));
+                mask[y * atlas->rowWidth + x] = lit ? 0xFFFFFFFF : 0;
+            }
+        }
+    }
+    return 0;
+}
+
+void fontAtlasFree(FontAtlas* atlas) {
+    free(atlas->masks);
+    free(atlas->colored);
+    atlas->masks = NULL;
+    atlas->colored = NULL;
+}
+
+int fontAtlasColor(FontAtlas* atlas, uint32_t color, uint32_t background) {
+    // One extra glyph at the end that's all background, for spaces
+    size_t glyphSize = (size_t)atlas->advance * atlas->glyphHeight;
+    uint32_t* colored = (uint32_t*)realloc(atlas->colored, (FONT_GLYPHS + 1) * glyphSize * sizeof(uint32_t));
+    if (!colored) {
+        printf("Failed to allocate memory for the coloured font atlas\n");
+        return -1;
+    }
+    atlas->colored = colored;
+
+    size_t maskSize = (size_t)atlas->rowWidth * atlas->glyphHeight;
+    for (int g = 0; g <= FONT_GLYPHS; g++) {
+        for (int y = 0; y < atlas->glyphHeight; y++) {
+            uint32_t* row = colored + g * glyphSize + y * atlas->advance;
+            const uint32_t* mask = g < FONT_GLYPHS ? atlas->masks + g * maskSize + y * atlas->rowWidth : NULL;
+            for (int x = 0; x < atlas->advance; x++) {
+                int lit = mask && x < atlas->glyphWidth && mask[x];
+                row[x] = lit ? color : background;
+            }
+        }
+    }
+    return 0;
+}
+
+int fontBlitText(const FontAtlas* atlas, uint32_t* frame, int frameWidth, int frameHeight, int x, int y, const char* text) {
+    int startX = x;
+    size_t glyphSize = (size_t)atlas->advance * atlas->glyphHeight;
+    int firstRow = y < 0 ? -y : 0;
+    int lastRow = y + atlas->glyphHeight > frameHeight ? frameHeight - y : atlas->glyphHeight;
+
+    for (; *text; text++, x += atlas->advance) {
+        int firstColumn = x < 0 ? -x : 0;
+        int lastColumn = x + atlas->advance > frameWidth ? frameWidth - x : atlas->advance;
+        if (firstColumn >= lastColumn) continue;
+
+        const unsigned char* glyph = fontGlyph((unsigned char)*text);
+        int g = glyph ? (int)((glyph - fontGlyphs[0]) / FONT_HEIGHT) : FONT_GLYPHS;
+        const uint32_t* source = atlas->colored + g * glyphSize;
+        size_t bytes = (size_t)(lastColumn - firstColumn) * sizeof(uint32_t);
+        for (int row = firstRow; row < lastRow; row++) {
+            memcpy(frame + (size_t)(y + row) * frameWidth + x + firstColumn, source + row * atlas->advance + firstColumn, bytes);
+        }
+    }
+    return x - startX;
+}
+
+int fontDrawText(const FontAtlas* atlas, uint32_t* frame, int frameWidth, int frameHeight, int x, int y,
+                 const char* text, uint32_t color) {
+    int startX = x;
+    size_t glyphSize = (size_t)atlas->rowWidth * atlas->glyphHeight;
+    __m128i fill = _mm_set1_epi32((int)color);
+    // Rows that are on screen, the same for every glyph
+    int firstRow = y < 0 ? -y : 0;
+    int lastRow = y + atlas->glyphHeight > frameHeight ? frameHeight - y : atlas->glyphHeight;
+
+    for (; *text; text++, x += atlas->advance) {
+        const unsigned char* glyph = fontGlyph((unsigned char)*text);
+        if (!glyph) continue;
+        int firstColumn = x < 0 ? -x : 0;
+        int lastColumn = x + atlas->glyphWidth > frameWidth ? frameWidth - x : atlas->glyphWidth;
+        if (firstColumn >= lastColumn) continue;
+
+        const uint32_t* mask = atlas->masks + (glyph - fontGlyphs[0]) / FONT_HEIGHT * glyphSize;
+        if (firstColumn == 0 && x + atlas->rowWidth <= frameWidth) {
+            // All of it's on screen with room for the padding, whole rows four pixels at a time
+            for (int row = firstRow; row < lastRow; row++) {
+                const __m128i* source = (const __m128i*)(mask + row * atlas->rowWidth);
+                uint32_t* destination = frame + (size_t)(y + row) * frameWidth + x;
+                for (int i = 0; i < atlas->rowWidth; i += 4) {
+                    __m128i lit = _mm_loadu_si128(source + i / 4);
+                    __m128i behind = _mm_loadu_si128((const __m128i*)(destination + i));
+                    _mm_storeu_si128((__m128i*)(destination + i), _mm_or_si128(_mm_andnot_si128(lit, behind), _mm_and_si128(lit, fill)));
+                }
+            }
+            continue;
+        }
+        for (int row = firstRow; row < lastRow; row++) {
+            const uint32_t* source = mask + row * atlas->rowWidth;
+            uint32_t* destination = frame + (size_t)(y + row) * frameWidth + x;
+            for (int i = firstColumn; i < lastColumn; i++) {
+                destination[i] = (destination[i] & ~source[i]) | (color & source[i]);
+            }
+        }
+    }
+    return x - startX;
+}
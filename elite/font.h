@@ -0,0 +1,45 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+
+// The 5x7 pixel font the pause menu started out with, letters, digits and a bit of punctuation
+// Drawing a glyph bit by bit is fine for a few words, anything drawn every frame goes through a FontAtlas instead,
+// every glyph rasterized once at one scale, so drawing text is masked copies of rows
+
+#define FONT_WIDTH 5
+#define FONT_HEIGHT 7
+#define FONT_GLYPHS 44
+
+// Top row first, bit 4 is the leftmost pixel
+extern const unsigned char fontGlyphs[FONT_GLYPHS][FONT_HEIGHT];
+
+// The glyph for c, lowercase gets drawn as uppercase, NULL for space and anything the font doesn't have
+const unsigned char* fontGlyph(unsigned char c);
+
+typedef struct {
+    uint32_t* masks; // Every glyph, one after the other, 0xFFFFFFFF where it's lit, bottom row first like the frame
+    int scale;
+    int glyphWidth, glyphHeight; // Pixels, scaled
+    int rowWidth; // Mask pixels per row, glyphWidth padded to a multiple of 4 with unlit ones
+    int advance; // Glyph plus the gap after it
+    uint32_t* colored; // NULL until fontAtlasColor, then every glyph and its gap in colour, advance pixels a row
+} FontAtlas;
+
+// Returns 0 on success, -1 if it couldn't be allocated
+int fontAtlasInit(FontAtlas* atlas, int scale);
+void fontAtlasFree(FontAtlas* atlas);
+
+// Draws text onto a 0x00RRGGBB frame, x y is the bottom left corner, clipped to the frame, returns the width
+int fontDrawText(const FontAtlas* atlas, uint32_t* frame, int frameWidth, int frameHeight, int x, int y,
+                 const char* text, uint32_t color);
+
+// Colours every glyph in once over a solid background, after that fontBlitText draws them as plain row copies
+// Returns 0 on success, -1 if it couldn't be allocated
+int fontAtlasColor(FontAtlas* atlas, uint32_t color, uint32_t background);
+
+// Like fontDrawText but opaque, the gaps and anything the font doesn't have come out as the background, so it's only
+// for text on that background, needs fontAtlasColor first
+int fontBlitText(const FontAtlas* atlas, uint32_t* frame, int frameWidth, int frameHeight, int x, int y, const char* text);
+
+#endif // FONT_H
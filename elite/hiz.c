@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
+#include "hiz.h"
+
+int hizInit(DepthPyramid* pyramid) {
+    int width = HIZ_WIDTH, height = HIZ_HEIGHT;
+    pyramid->levels = 0;
+    while (pyramid->levels < HIZ_MAX_LEVELS) {
+        int level = pyramid->levels;
+        pyramid->width[level] = width;
+        pyramid->height[level] = height;
+        pyramid->depth[level] = (float*)malloc(width * height * sizeof(float));
+        if (!pyramid->depth[level]) {
+            printf("Failed to allocate memory for depth pyramid\n");
+            hizFree(pyramid);
+            return -1;
+        }
+        pyramid->levels++;
+        if (width == 1 && height == 1) break;
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+    pyramid->empty = 1;
+    return 0;
+}
+
+void hizFree(DepthPyramid* pyramid) {
+    for (int i = 0; i < pyramid->levels; i++) {
+        free(pyramid->depth[i]);
+        pyramid->depth[i] = NULL;
+    }
+    pyramid->levels = 0;
+}
+
+void hizClear(DepthPyramid* pyramid, float screenWidth, float screenHeight) {
+    float* depth = pyramid->depth[0];
+    for (int i = 0; i < HIZ_WIDTH * HIZ_HEIGHT; i++) depth[i] = FLT_MAX;
+    pyramid->screenWidth = screenWidth;
+    pyramid->screenHeight = screenHeight;
+    pyramid->scaleX = HIZ_WIDTH / screenWidth;
+    pyramid->scaleY = HIZ_HEIGHT / screenHeight;
+    pyramid->empty = 1;
+}
+
+void hizDrawDisc(DepthPyramid* pyramid, float centerX, float centerY, float radius, float depth) {
+    if (radius <= 0.0f) return;
+    int x0 = (int)floorf((centerX - radius) * pyramid->scaleX);
+    int x1 = (int)floorf((centerX + radius) * pyramid->scaleX);
+    int y0 = (int)floorf((centerY - radius) * pyramid->scaleY);
+    int y1 = (int)floorf((centerY + radius) * pyramid->scaleY);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= HIZ_WIDTH) x1 = HIZ_WIDTH - 1;
+    if (y1 >= HIZ_HEIGHT) y1 = HIZ_HEIGHT - 1;
+    
+    float texelWidth = 1.0f / pyramid->scaleX, texelHeight = 1.0f / pyramid->scaleY;
+    float radiusSquared = radius * radius;
+    for (int y = y0; y <= y1; y++) {
+        // Furthest corner of the texel from the center decides if all of it is covered
+        float top = y * texelHeight - centerY, bottom = top + texelHeight;
+        float dy = fmaxf(fabsf(top), fabsf(bottom));
+        float* row = &pyramid->depth[0][y * HIZ_WIDTH];
+        for (int x = x0; x <= x1; x++) {
+            float left = x * texelWidth - centerX, right = left + texelWidth;
+            float dx = fmaxf(fabsf(left), fabsf(right));
+            if (dx * dx + dy * dy > radiusSquared) continue;
+            // Nearest occluder wins, any one of them hiding something is enough
+            if (depth < row[x]) row[x] = depth;
+            pyramid->empty = 0;
+        }
+    }
+}
+
+void hizBuild(DepthPyramid* pyramid) {
+    if (pyramid->empty) return;
+    for (int level = 1; level < pyramid->levels; level++) {
+        const float* below = pyramid->depth[level - 1];
+        int belowWidth = pyramid->width[level - 1], belowHeight = pyramid->height[level - 1];
+        float* depth = pyramid->depth[level];
+        for (int y = 0; y < pyramid->height[level]; y++) {
+            int by0 = y * 2, by1 = by0 + 1 < belowHeight ? by0 + 1 : by0;
+            for (int x = 0; x < pyramid->width[level]; x++) {
+                int bx0 = x * 2, bx1 = bx0 + 1 < belowWidth ? bx0 + 1 : bx0;
+                float a = fmaxf(below[by0 * belowWidth + bx0], below[by0 * belowWidth + bx1]);
+                float b = fmaxf(below[by1 * belowWidth + bx0], below[by1 * belowWidth + bx1]);
+                depth[y * pyramid->width[level] + x] = fmaxf(a, b);
+            }
+        }
+    }
+}
+
+int hizOccluded(const DepthPyramid* pyramid, float minX, float minY, float maxX, float maxY, float nearest) {
+    if (pyramid->empty) return 0;
+    // Anything reaching off screen isn't worth the bother, it might be seen past the edge
+    if (minX < 0.0f || minY < 0.0f || maxX >= pyramid->screenWidth || maxY >= pyramid->screenHeight) return 0;
+    
+    int x0 = (int)(minX * pyramid->scaleX), x1 = (int)(maxX * pyramid->scaleX);
+    int y0 = (int)(minY * pyramid->scaleY), y1 = (int)(maxY * pyramid->scaleY);
+    int level = 0;
+    while (level < pyramid->levels - 1 && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+        level++;
+    }
+    
+    const float* depth = pyramid->depth[level];
+    int width = pyramid->width[level];
+    for (int y = y0 >> level; y <= y1 >> level; y++) {
+        for (int x = x0 >> level; x <= x1 >> level; x++) {
+            if (depth[y * width + x] >= nearest) return 0;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,42 @@
+#ifndef HIZ_H
+#define HIZ_H
+
+#include <stdint.h>
+
+// Hierarchical depth buffer for occlusion culling, big occluders (planets, stars) get drawn in as discs at low
+// resolution, then each level up keeps the furthest depth of the 4 below it
+// Conservative both ways: a texel only gets an occluder's depth if the disc covers all of it, and the depth
+// written is at least as far as the occluder's surface there, so a hidden answer is always right
+// Depths are distances from the camera, anything works as long as the tests use the same measure
+
+#define HIZ_WIDTH 256
+#define HIZ_HEIGHT 160
+#define HIZ_MAX_LEVELS 10
+
+typedef struct {
+    float* depth[HIZ_MAX_LEVELS]; // Level 0 is HIZ_WIDTH x HIZ_HEIGHT, FLT_MAX where there's no occluder
+    int width[HIZ_MAX_LEVELS], height[HIZ_MAX_LEVELS];
+    int levels;
+    float scaleX, scaleY; // Screen pixels to level 0 texels
+    float screenWidth, screenHeight;
+    int empty; // Nothing drawn since the last clear, every test can stop straight away
+} DepthPyramid;
+
+// Returns 0 on success, -1 if the memory couldn't be allocated
+int hizInit(DepthPyramid* pyramid);
+void hizFree(DepthPyramid* pyramid);
+
+// Starts a new frame for a screen of this size
+void hizClear(DepthPyramid* pyramid, float screenWidth, float screenHeight);
+
+// Disc in screen pixels, depth has to be at least as far as whatever the disc covers
+void hizDrawDisc(DepthPyramid* pyramid, float centerX, float centerY, float radius, float depth);
+
+// Fills in the levels above 0, call once everything is drawn
+void hizBuild(DepthPyramid* pyramid);
+
+// 1 if everything in the screen rectangle is behind an occluder, nearest is the closest the tested thing gets
+// Goes up the pyramid until the rectangle covers at most 2x2 texels, so it's a handful of reads whatever the size
+int hizOccluded(const DepthPyramid* pyramid, float minX, float minY, float maxX, float maxY, float nearest);
+
+#endif // HIZ_H
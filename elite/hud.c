@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "hud.h"
+
+#define HUD_GRAPH_HEIGHT 24 // Font pixels
+#define HUD_LABEL_CHARS 7 // Room for the stage names in front of the bars
+#define HUD_VALUE_CHARS 6 // And for the ms after them
+#define HUD_TEXT_COLOR 0xE0E0E0
+#define HUD_DIM_COLOR 0x606060
+#define HUD_TRACK_COLOR 0x202020 // Behind the bars
+#define HUD_FAST_COLOR 0x40FF40 // 60 fps or better
+#define HUD_SLOW_COLOR 0xFFD040 // 30 fps or better
+#define HUD_DROPPED_COLOR 0xFF4040
+
+static double nowMs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+int hudInit(Hud* hud, int scale) {
+    memset(hud, 0, sizeof(Hud));
+    return fontAtlasInit(&hud->font, scale);
+}
+
+void hudFree(Hud* hud) {
+    fontAtlasFree(&hud->font);
+}
+
+int hudSetScale(Hud* hud, int scale) {
+    if (scale < 1) scale = 1;
+    if (scale == hud->font.scale) return 0;
+    FontAtlas atlas;
+    if (fontAtlasInit(&atlas, scale) != 0) return -1;
+    fontAtlasFree(&hud->font);
+    hud->font = atlas;
+    return 0;
+}
+
+void hudRecord(Hud* hud, float frameMs) {
+    hud->frameMs[hud->next] = frameMs;
+    hud->next = (hud->next + 1) % HUD_HISTORY;
+}
+
+// Clipped to the frame, y is the bottom row
+static void fillRect(uint32_t* frame, int width, int height, int x, int y, int w, int h, uint32_t color) {
+    int x0 = x < 0 ? 0 : x, x1 = x + w > width ? width : x + w;
+    int y0 = y < 0 ? 0 : y, y1 = y + h > height ? height : y + h;
+    for (int row = y0; row < y1; row++) {
+        uint32_t* line = frame + (size_t)row * width;
+        for (int i = x0; i < x1; i++) line[i] = color;
+    }
+}
+
+// Halves whatever's behind the panel so the text stays readable over the wireframes
+static void darkenRect(uint32_t* frame, int width, int height, int x, int y, int w, int h) {
+    int x0 = x < 0 ? 0 : x, x1 = x + w > width ? width : x + w;
+    int y0 = y < 0 ? 0 : y, y1 = y + h > height ? height : y + h;
+    for (int row = y0; row < y1; row++) {
+        uint32_t* line = frame + (size_t)row * width;
+        for (int i = x0; i < x1; i++) line[i] = (line[i] >> 1) & 0x7F7F7F;
+    }
+}
+
+static uint32_t frameColor(float ms) {
+    if (ms <= 1000.0f / 60.0f) return HUD_FAST_COLOR;
+    if (ms <= 1000.0f / 30.0f) return HUD_SLOW_COLOR;
+    return HUD_DROPPED_COLOR;
+}
+
+// Label, a bar as long as the stage took against HUD_GRAPH_MS, and the time after it
+static void drawBar(const Hud* hud, uint32_t* frame, int width, int height, int x, int y, int barWidth,
+                    const char* label, float ms, uint32_t color) {
+    const FontAtlas* font = &hud->font;
+    fontDrawText(font, frame, width, height, x, y, label, HUD_TEXT_COLOR);
+    int barX = x + HUD_LABEL_CHARS * font->advance;
+    float fraction = ms / HUD_GRAPH_MS;
+    if (fraction > 1.0f) fraction = 1.0f;
+    fillRect(frame, width, height, barX, y, barWidth, font->glyphHeight, HUD_TRACK_COLOR);
+    fillRect(frame, width, height, barX, y, (int)(barWidth * fraction), font->glyphHeight, color);
+    char value[16];
+    snprintf(value, sizeof(value), "%.2f", ms);
+    fontDrawText(font, frame, width, height, barX + barWidth + font->advance, y, value, HUD_TEXT_COLOR);
+}
+
+void hudDraw(Hud* hud, uint32_t* frame, int width, int height, const HudStats* stats) {
+    double start = nowMs();
+    const FontAtlas* font = &hud->font;
+    int scale = font->scale;
+    int margin = HUD_MARGIN * scale;
+    int lineHeight = font->glyphHeight + 2 * scale;
+    int columnWidth = (scale + 1) / 2;
+    int graphWidth = HUD_HISTORY * columnWidth;
+    int graphHeight = HUD_GRAPH_HEIGHT * scale;
+    int barWidth = graphWidth - (HUD_LABEL_CHARS + HUD_VALUE_CHARS) * font->advance;
+    int textLines = 7;
+
+    // The frame's bottom row is row 0, so the panel hangs down from the top
+    int panelWidth = graphWidth + 2 * margin;
+    int panelHeight = textLines * lineHeight + graphHeight + 3 * margin;
+    int panelX = margin, panelTop = height - margin;
+    darkenRect(frame, width, height, panelX, panelTop - panelHeight, panelWidth, panelHeight);
+
+    int x = panelX + margin;
+    int y = panelTop - margin - font->glyphHeight; // Bottom of the current line
+    char line[96];
+    snprintf(line, sizeof(line), "FPS %.0f  FRAME %.2f MS  %dX%d", stats->fps, stats->frameMs, stats->width,
+             stats->height);
+    fontDrawText(font, frame, width, height, x, y, line, HUD_TEXT_COLOR);
+
+    // Oldest frame on the left, a line where 60 fps is
+    int graphY = y - scale - graphHeight;
+    int sixty = (int)(graphHeight * (1000.0f / 60.0f) / HUD_GRAPH_MS);
+    for (int i = 0; i < graphWidth; i += 2 * scale) {
+        fillRect(frame, width, height, x + i, graphY + sixty, scale, 1, HUD_DIM_COLOR);
+    }
+    for (int i = 0; i < HUD_HISTORY; i++) {
+        float ms = hud->frameMs[(hud->next + i) % HUD_HISTORY];
+        if (ms <= 0.0f) continue; // Not filled yet
+        float fraction = ms / HUD_GRAPH_MS;
+        int columnHeight = fraction >= 1.0f ? graphHeight : (int)(graphHeight * fraction) + 1;
+        fillRect(frame, width, height, x + i * columnWidth, graphY, columnWidth, columnHeight, frameColor(ms));
+    }
+    y = graphY - margin - font->glyphHeight;
+
+    drawBar(hud, frame, width, height, x, y, barWidth, "LOGIC", stats->logicMs, 0x40A0FF);
+    y -= lineHeight;
+    drawBar(hud, frame, width, height, x, y, barWidth, "RENDER", stats->renderMs, 0x40FF80);
+    y -= lineHeight;
+    drawBar(hud, frame, width, height, x, y, barWidth, "RASTER", stats->rasterMs, 0xFF8040);
+    y -= lineHeight;
+
+    snprintf(line, sizeof(line), "OBJECTS %d  CULLED %d", stats->objectsDrawn, stats->culled);
+    fontDrawText(font, frame, width, height, x, y, line, HUD_TEXT_COLOR);
+    y -= lineHeight;
+    snprintf(line, sizeof(line), "TRIS %d  EDGES %d", stats->triangles, stats->edges);
+    fontDrawText(font, frame, width, height, x, y, line, HUD_TEXT_COLOR);
+    y -= lineHeight;
+    snprintf(line, sizeof(line), "AI %d  HUD %.3f MS", stats->aiUpdates, hud->drawTime);
+    fontDrawText(font, frame, width, height, x, y, line, HUD_TEXT_COLOR);
+
+    hud->drawTime = (float)(nowMs() - start);
+}
@@ -0,0 +1,42 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include <stdint.h>
+#include "font.h"
+
+// Performance overlay drawn straight into the frame, the top left corner, a scrolling graph of the last
+// HUD_HISTORY frame times, a bar for each stage of the frame and the renderer's counters
+// Doesn't know where the numbers come from, the caller fills in HudStats
+
+#define HUD_HISTORY 240 // Frames in the graph
+#define HUD_GRAPH_MS 33.3f // Frame time at the top of the graph and the end of the bars, anything slower gets cut off
+#define HUD_MARGIN 4 // Font pixels, scaled like everything else
+
+typedef struct {
+    float frameMs; // Last frame
+    float fps; // Averaged, however the caller likes
+    float logicMs, renderMs, rasterMs; // Stages of the last frame
+    int objectsDrawn, triangles, edges, culled, aiUpdates;
+    int width, height; // Internal resolution
+} HudStats;
+
+typedef struct {
+    float frameMs[HUD_HISTORY]; // Ring, oldest at next
+    int next;
+    FontAtlas font;
+    float drawTime; // ms, last hudDraw, shown on the overlay itself
+} Hud;
+
+// Returns 0 on success, -1 if the font atlas couldn't be allocated
+int hudInit(Hud* hud, int scale);
+void hudFree(Hud* hud);
+
+// Rebuilds the font atlas if the scale changed, returns -1 if that failed, the old one stays then
+int hudSetScale(Hud* hud, int scale);
+
+// Adds a frame to the graph
+void hudRecord(Hud* hud, float frameMs);
+
+void hudDraw(Hud* hud, uint32_t* frame, int width, int height, const HudStats* stats);
+
+#endif // HUD_H
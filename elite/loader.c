@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "loader.h"
+
+static double nowMs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+// Caller holds the lock, anything waited on first, oldest first within that, -1 if there's nothing queued
+static int nextAsset(const AssetLoader* loader) {
+    int next = -1;
+    for (int i = 0; i < loader->numAssets; i++) {
+        const LoaderAsset* asset = &loader->assets[i];
+        if (asset->state != ASSET_QUEUED) continue;
+        if (!asset->prefetch) return i;
+        if (next < 0) next = i;
+    }
+    return next;
+}
+
+static void* loaderThread(void* arg) {
+    AssetLoader* loader = (AssetLoader*)arg;
+    pthread_mutex_lock(&loader->lock);
+    while (1) {
+        while (loader->running && loader->queued == 0) {
+            pthread_cond_wait(&loader->wake, &loader->lock);
+        }
+        if (!loader->running) break;
+        
+        int handle = nextAsset(loader);
+        LoaderAsset* asset = &loader->assets[handle];
+        asset->state = ASSET_LOADING;
+        loader->queued--;
+        
+        // The filename never changes once it's in the table, so it's fine to read without the lock
+        pthread_mutex_unlock(&loader->lock);
+        double start = nowMs();
+        const Mesh* mesh = getMesh(asset->filename);
+        float time = (float)(nowMs() - start);
+        pthread_mutex_lock(&loader->lock);
+        
+        asset->mesh = mesh;
+        asset->state = mesh ? ASSET_READY : ASSET_FAILED;
+        asset->loadTime = time;
+        loader->loadTime += time;
+        if (mesh) loader->loaded++;
+        else loader->failed++;
+        __atomic_fetch_add(&loader->finished, 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&loader->lock);
+    return NULL;
+}
+
+int loaderStart(AssetLoader* loader, AssetLoadedCallback callback, void* user) {
+    memset(loader, 0, sizeof(AssetLoader));
+    loader->callback = callback;
+    loader->user = user;
+    loader->running = 1;
+    pthread_mutex_init(&loader->lock, NULL);
+    pthread_cond_init(&loader->wake, NULL);
+    if (pthread_create(&loader->thread, NULL, loaderThread, loader) != 0) {
+        printf("Failed to start the asset loader\n");
+        loader->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void loaderStop(AssetLoader* loader) {
+    pthread_mutex_lock(&loader->lock);
+    int wasRunning = loader->running;
+    loader->running = 0;
+    pthread_cond_signal(&loader->wake);
+    pthread_mutex_unlock(&loader->lock);
+    if (wasRunning) pthread_join(loader->thread, NULL);
+    pthread_cond_destroy(&loader->wake);
+    pthread_mutex_destroy(&loader->lock);
+}
+
+// Caller holds the lock, -1 if the file isn't in the table
+static int findAsset(const AssetLoader* loader, const char* filename) {
+    for (int i = 0; i < loader->numAssets; i++) {
+        if (strcmp(loader->assets[i].filename, filename) == 0) return i;
+    }
+    return -1;
+}
+
+// Caller holds the lock, adds an entry and wakes the loader, -1 if the table is full
+static int queueAsset(AssetLoader* loader, const char* filename, int prefetch) {
+    if (loader->numAssets == LOADER_MAX_ASSETS) {
+        printf("Too many assets to load %s\n", filename);
+        return -1;
+    }
+    int handle = loader->numAssets++;
+    LoaderAsset* asset = &loader->assets[handle];
+    memset(asset, 0, sizeof(LoaderAsset));
+    snprintf(asset->filename, sizeof(asset->filename), "%s", filename);
+    asset->state = ASSET_QUEUED;
+    asset->prefetch = prefetch;
+    loader->queued++;
+    pthread_cond_signal(&loader->wake);
+    return handle;
+}
+
+const Mesh* loaderRequestMesh(AssetLoader* loader, const char* filename, int* handle) {
+    const Mesh* mesh = NULL;
+    pthread_mutex_lock(&loader->lock);
+    *handle = findAsset(loader, filename);
+    if (*handle >= 0) {
+        LoaderAsset* asset = &loader->assets[*handle];
+        if (asset->state == ASSET_READY) {
+            mesh = asset->mesh;
+            if (asset->prefetch) loader->prefetchHits++;
+            *handle = -1;
+        } else if (asset->state == ASSET_FAILED) {
+            *handle = -1;
+        } else {
+            asset->prefetch = 0; // Something's waiting on it now
+        }
+    } else {
+        // Loaded some other way (the scene maps its meshes up front), the loader doesn't need to know
+        mesh = findLoadedMesh(filename);
+        if (!mesh) *handle = queueAsset(loader, filename, 0);
+    }
+    pthread_mutex_unlock(&loader->lock);
+    return mesh;
+}
+
+void loaderPrefetchMesh(AssetLoader* loader, const char* filename) {
+    pthread_mutex_lock(&loader->lock);
+    if (findAsset(loader, filename) < 0 && !findLoadedMesh(filename)) queueAsset(loader, filename, 1);
+    pthread_mutex_unlock(&loader->lock);
+}
+
+int loaderPoll(AssetLoader* loader) {
+    // Unlocked peek, worst case a finished one waits for the next poll
+    if (__atomic_load_n(&loader->finished, __ATOMIC_RELAXED) == 0) return 0;
+    
+    int handles[LOADER_MAX_ASSETS];
+    const Mesh* loadedMeshes[LOADER_MAX_ASSETS];
+    int count = 0;
+    pthread_mutex_lock(&loader->lock);
+    for (int i = 0; i < loader->numAssets; i++) {
+        LoaderAsset* asset = &loader->assets[i];
+        if (asset->notified || (asset->state != ASSET_READY && asset->state != ASSET_FAILED)) continue;
+        asset->notified = 1;
+        handles[count] = i;
+        loadedMeshes[count] = asset->mesh;
+        count++;
+    }
+    __atomic_store_n(&loader->finished, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&loader->lock);
+    
+    // Without the lock, so the callback can ask for more
+    for (int i = 0; i < count; i++) {
+        loader->callback(handles[i], loadedMeshes[i], loader->user);
+    }
+    return count;
+}
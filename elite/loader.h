@@ -0,0 +1,67 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "mesh.h"
+
+// Loads meshes on a thread of its own, so spawning something whose mesh isn't loaded yet doesn't stall anything
+// Every file gets one entry the first time it's asked for, its handle stays the same until loaderStop
+// When a file is done the callback runs on whichever thread calls loaderPoll, never on the loader thread,
+// so it can touch the same things as the rest of that thread does
+
+#define LOADER_MAX_ASSETS 64
+
+typedef enum {
+    ASSET_QUEUED,
+    ASSET_LOADING,
+    ASSET_READY,
+    ASSET_FAILED
+} AssetState;
+
+typedef struct {
+    char filename[256];
+    uint8_t state; // AssetState
+    uint8_t prefetch; // Nothing's waiting on it yet, anything that is goes first
+    uint8_t notified; // Callback has run
+    const Mesh* mesh;
+    float loadTime; // ms the loader spent on it
+} LoaderAsset;
+
+// mesh is NULL if the file couldn't be loaded
+typedef void (*AssetLoadedCallback)(int handle, const Mesh* mesh, void* user);
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock; // Covers everything below
+    pthread_cond_t wake;
+    LoaderAsset assets[LOADER_MAX_ASSETS];
+    int numAssets;
+    int queued; // Entries still ASSET_QUEUED
+    int finished; // Done loading but the callback hasn't run yet
+    int running;
+    AssetLoadedCallback callback;
+    void* user;
+    // Totals, for the stats
+    uint32_t loaded, failed;
+    uint32_t prefetchHits; // Asked for and already there because of a prefetch
+    float loadTime; // ms
+} AssetLoader;
+
+// Starts the loader thread, returns 0 on success, -1 if it couldn't be started
+int loaderStart(AssetLoader* loader, AssetLoadedCallback callback, void* user);
+
+// Waits for whatever is loading to finish and stops the thread, meshes stay loaded
+void loaderStop(AssetLoader* loader);
+
+// Returns the mesh if it's already loaded, otherwise queues it and returns NULL, *handle is what the callback
+// will get once it's done, or -1 if it can't be loaded (failed before, or too many files)
+const Mesh* loaderRequestMesh(AssetLoader* loader, const char* filename, int* handle);
+
+// Hint that a file is probably going to be wanted soon, loaded when there's nothing more urgent to do
+void loaderPrefetchMesh(AssetLoader* loader, const char* filename);
+
+// Runs the callback for everything that finished since the last call, returns how many
+int loaderPoll(AssetLoader* loader);
+
+#endif // LOADER_H
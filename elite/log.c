@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
+#include "log.h"
+
+typedef struct {
+    uint8_t level;
+    char text[LOG_MESSAGE_LENGTH];
+} LogEntry;
+
+// Single producer single consumer ring, the owning thread moves head and the flush thread moves tail
+// A thread that exits gives its queue back and the next new thread takes it over, the worker threads
+// get created every tick so they'd pile up otherwise
+typedef struct LogQueue {
+    LogEntry entries[LOG_QUEUE_SIZE];
+    uint32_t head, tail;
+    uint32_t dropped; // Since the last flush
+    int inUse;
+    struct LogQueue* next;
+} LogQueue;
+
+LogStats logStats;
+
+static const char* levelNames[] = {"debug", "info", "warn", "error"};
+
+static LogQueue* queues = NULL; // Pushed onto, never removed from until logShutdown
+static LogSite* sites = NULL; // Same
+static pthread_key_t queueKey;
+static pthread_t flushThread;
+static int running = 0;
+static uint32_t clockSecond = 0; // Kept by the flush thread, so logging never has to read the clock
+
+static uint32_t monotonicSecond(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)now.tv_sec;
+}
+
+static void releaseQueue(void* queue) {
+    __atomic_store_n(&((LogQueue*)queue)->inUse, 0, __ATOMIC_RELEASE);
+}
+
+static LogQueue* threadQueue(void) {
+    LogQueue* queue = (LogQueue*)pthread_getspecific(queueKey);
+    if (queue) return queue;
+    
+    // Take over one an exited thread left behind, or make a new one
+    for (queue = __atomic_load_n(&queues, __ATOMIC_ACQUIRE); queue; queue = queue->next) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&queue->inUse, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) break;
+    }
+    if (!queue) {
+        queue = (LogQueue*)calloc(1, sizeof(LogQueue));
+        if (!queue) return NULL;
+        queue->inUse = 1;
+        queue->next = __atomic_load_n(&queues, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&queues, &queue->next, queue, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+    pthread_setspecific(queueKey, queue);
+    return queue;
+}
+
+static void registerSite(LogSite* site) {
+    if (__atomic_exchange_n(&site->registered, 1, __ATOMIC_ACQ_REL)) return;
+    site->next = __atomic_load_n(&sites, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&sites, &site->next, site, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+void logWrite(LogSite* site, const char* format, ...) {
+    va_list args;
+    if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+        // No flush thread, just print it
+        va_start(args, format);
+        printf("[%s] ", levelNames[site->level]);
+        vprintf(format, args);
+        va_end(args);
+        return;
+    }
+    
+    // Rate limit before formatting anything, a site over its limit costs a couple of atomics
+    // Two threads rolling the second over at once can let a few extra through, doesn't matter
+    uint32_t second = __atomic_load_n(&clockSecond, __ATOMIC_RELAXED);
+    uint32_t siteSecond = __atomic_load_n(&site->second, __ATOMIC_RELAXED);
+    if (siteSecond != second &&
+        __atomic_compare_exchange_n(&site->second, &siteSecond, second, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&site->count, 0, __ATOMIC_RELAXED);
+    }
+    if (__atomic_fetch_add(&site->count, 1, __ATOMIC_RELAXED) >= LOG_SITE_PER_SECOND) {
+        registerSite(site);
+        __atomic_fetch_add(&site->suppressed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    
+    LogQueue* queue = threadQueue();
+    if (!queue) return;
+    uint32_t head = queue->head;
+    if (head - __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE) >= LOG_QUEUE_SIZE) {
+        __atomic_fetch_add(&queue->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    LogEntry* entry = &queue->entries[head % LOG_QUEUE_SIZE];
+    entry->level = site->level;
+    va_start(args, format);
+    vsnprintf(entry->text, sizeof(entry->text), format, args);
+    va_end(args);
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// Everything below is the flush thread only
+
+static char lastText[LOG_MESSAGE_LENGTH]; // Last line written, repeats of it only get counted
+static uint8_t lastLevel;
+static uint32_t repeats;
+
+static void writeRepeats(void) {
+    if (repeats == 0) return;
+    printf("[%s] (last message repeated %u more times)\n", levelNames[lastLevel], repeats);
+    logStats.written++;
+    repeats = 0;
+}
+
+static void writeEntry(const LogEntry* entry) {
+    if (entry->level == lastLevel && strcmp(entry->text, lastText) == 0) {
+        repeats++;
+        logStats.suppressed++;
+        return;
+    }
+    writeRepeats();
+    size_t length = strlen(entry->text);
+    // Messages are written like printf's, with their own newline, one cut off by the length limit gets one added
+    printf("[%s] %s%s", levelNames[entry->level], entry->text, length && entry->text[length - 1] == '\n' ? "" : "\n");
+    logStats.written++;
+    memcpy(lastText, entry->text, length + 1);
+    lastLevel = entry->level;
+}
+
+static void flush(int reportSites) {
+    for (LogQueue* queue = __atomic_load_n(&queues, __ATOMIC_ACQUIRE); queue; queue = queue->next) {
+        uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+        uint32_t tail = queue->tail;
+        for (; tail != head; tail++) {
+            writeEntry(&queue->entries[tail % LOG_QUEUE_SIZE]);
+        }
+        __atomic_store_n(&queue->tail, tail, __ATOMIC_RELEASE);
+        
+        uint32_t dropped = __atomic_exchange_n(&queue->dropped, 0, __ATOMIC_RELAXED);
+        if (dropped) {
+            writeRepeats();
+            printf("[warn] %u log messages dropped, a thread logged faster than they could be written\n", dropped);
+            logStats.dropped += dropped;
+        }
+    }
+    writeRepeats();
+    
+    if (reportSites) {
+        for (LogSite* site = __atomic_load_n(&sites, __ATOMIC_ACQUIRE); site; site = site->next) {
+            uint32_t suppressed = __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+            if (!suppressed) continue;
+            printf("[%s] %s:%d: %u more like that in the last second\n", levelNames[site->level], site->file, site->line, suppressed);
+            logStats.suppressed += suppressed;
+            logStats.written++;
+        }
+        lastText[0] = '\0'; // So a repeat after a report is written out again
+    }
+    fflush(stdout);
+}
+
+static void* flushLoop(void* arg) {
+    (void)arg;
+    struct timespec wait = {0, LOG_FLUSH_MS * 1000000L};
+    while (__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+        nanosleep(&wait, NULL);
+        uint32_t second = monotonicSecond();
+        int newSecond = second != __atomic_load_n(&clockSecond, __ATOMIC_RELAXED);
+        __atomic_store_n(&clockSecond, second, __ATOMIC_RELAXED);
+        flush(newSecond);
+    }
+    return NULL;
+}
+
+int logInit(void) {
+    if (pthread_key_create(&queueKey, releaseQueue) != 0) {
+        printf("Failed to create the log queue key\n");
+        return -1;
+    }
+    clockSecond = monotonicSecond();
+    running = 1;
+    if (pthread_create(&flushThread, NULL, flushLoop, NULL) != 0) {
+        printf("Failed to start the log thread\n");
+        running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void logShutdown(void) {
+    if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE)) return;
+    __atomic_store_n(&running, 0, __ATOMIC_RELEASE);
+    pthread_join(flushThread, NULL);
+    flush(1); // Whatever came in after the last flush
+    
+    while (queues) {
+        LogQueue* next = queues->next;
+        free(queues);
+        queues = next;
+    }
+    sites = NULL;
+    pthread_key_delete(queueKey);
+}
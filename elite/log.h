@@ -0,0 +1,86 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+
+// Logging for anything that can happen on a hot path, printf takes stdout's lock on every call so a message
+// hit by every AI ship would make the workers queue up behind each other
+// LOG_WARN(...) and friends format into a queue only the calling thread writes to, a background thread
+// writes them out every LOG_FLUSH_MS, nothing waits on stdout
+// Every call site gets LOG_SITE_PER_SECOND messages a second, anything past that is only counted and the count
+// gets written once a second instead, and the same line repeated back to back is written once with a count
+// Anything below LOG_LEVEL isn't compiled in at all, build with -DLOG_LEVEL=LOG_LEVEL_DEBUG to see more
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_MESSAGE_LENGTH 120 // Longer messages get cut off
+#define LOG_QUEUE_SIZE 256 // Per thread, messages past that are dropped until the next flush
+#define LOG_SITE_PER_SECOND 5
+#define LOG_FLUSH_MS 50
+
+// One per LOG_* line, made by the macro
+typedef struct LogSite {
+    const char* file;
+    int line;
+    uint8_t level;
+    uint8_t registered; // On the list the flush thread reports suppressed counts from
+    uint32_t second; // Which second count is for
+    uint32_t count; // Messages so far in that second
+    uint32_t suppressed; // Not written since the last report
+    struct LogSite* next;
+} LogSite;
+
+typedef struct {
+    uint64_t written; // Lines that made it to stdout
+    uint64_t suppressed; // Rate limited or collapsed into a repeat count
+    uint64_t dropped; // Queue was full
+} LogStats;
+
+extern LogStats logStats; // Only the flush thread writes it
+
+// Starts the flush thread, returns 0 on success, -1 if it couldn't be started (messages get printed directly then)
+int logInit(void);
+
+// Writes out everything still queued and stops the flush thread
+void logShutdown(void);
+
+void logWrite(LogSite* site, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+#define LOG_AT(level, ...) do { \
+    static LogSite logSite = {__FILE__, __LINE__, level, 0, 0, 0, 0, 0}; \
+    logWrite(&logSite, __VA_ARGS__); \
+} while (0)
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#endif // LOG_H
@@ -0,0 +1,564 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include "mesh.h"
+
+_Static_assert(sizeof(MeshHeader) % MESH_ALIGNMENT == 0, "MeshHeader has to keep the sections aligned");
+_Static_assert(sizeof(MeshLod) % MESH_ALIGNMENT == 0, "MeshLod has to keep the sections aligned");
+
+static Mesh** meshes = NULL;
+static int numMeshes = 0;
+static pthread_mutex_t meshLock = PTHREAD_MUTEX_INITIALIZER; // Covers the list only, so a lookup never waits on a load
+
+static size_t alignUp(size_t value) {
+    return (value + MESH_ALIGNMENT - 1) & ~(size_t)(MESH_ALIGNMENT - 1);
+}
+
+static uint32_t fnv1a(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t hashVertex(const float v[3]) {
+    uint32_t bits[3];
+    memcpy(bits, v, sizeof(bits));
+    return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+}
+
+static uint64_t hashEdge(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return key;
+}
+
+void* buildMeshImage(const Triangle* triangles, size_t triangleCount, size_t* imageSize) {
+    size_t cornerCount = triangleCount * 3;
+
+    // Open addressing tables, at least twice as big as the most entries they can get
+    size_t tableSize = 16;
+    while (tableSize < cornerCount * 2) tableSize *= 2;
+
+    float (*vertices)[4] = (float(*)[4])malloc((cornerCount + 1) * sizeof(float[4]));
+    uint32_t (*indices)[3] = (uint32_t(*)[3])malloc((triangleCount + 1) * sizeof(uint32_t[3]));
+    uint32_t (*edges)[2] = (uint32_t(*)[2])malloc((cornerCount + 1) * sizeof(uint32_t[2]));
+    uint32_t* vertexTable = (uint32_t*)malloc(tableSize * sizeof(uint32_t));
+    uint64_t* edgeTable = (uint64_t*)malloc(tableSize * sizeof(uint64_t));
+    void* image = NULL;
+
+    if (!vertices || !indices || !edges || !vertexTable || !edgeTable) {
+        printf("Failed to allocate memory for mesh conversion\n");
+        goto done;
+    }
+    memset(vertexTable, 0xFF, tableSize * sizeof(uint32_t));
+    memset(edgeTable, 0xFF, tableSize * sizeof(uint64_t));
+
+    // Deduplicate the vertices, they only ever match exactly since they come from the same STL corners
+    size_t vertexCount = 0;
+    for (size_t i = 0; i < triangleCount; i++) {
+        const float* corners[3] = {triangles[i].v1, triangles[i].v2, triangles[i].v3};
+        for (int c = 0; c < 3; c++) {
+            float v[3] = {corners[c][0] + 0.0f, corners[c][1] + 0.0f, corners[c][2] + 0.0f}; // + 0.0f folds -0 into 0
+            size_t slot = hashVertex(v) & (tableSize - 1);
+            while (vertexTable[slot] != UINT32_MAX) {
+                const float* existing = vertices[vertexTable[slot]];
+                if (existing[0] == v[0] && existing[1] == v[1] && existing[2] == v[2]) break;
+                slot = (slot + 1) & (tableSize - 1);
+            }
+            if (vertexTable[slot] == UINT32_MAX) {
+                vertexTable[slot] = vertexCount;
+                vertices[vertexCount][0] = v[0];
+                vertices[vertexCount][1] = v[1];
+                vertices[vertexCount][2] = v[2];
+                vertices[vertexCount][3] = 0.0f;
+                vertexCount++;
+            }
+            indices[i][c] = vertexTable[slot];
+        }
+    }
+
+    // Unique edges, each one is shared by two triangles on a closed mesh so this halves the line drawing
+    size_t edgeCount = 0;
+    for (size_t i = 0; i < triangleCount; i++) {
+        for (int c = 0; c < 3; c++) {
+            uint32_t a = indices[i][c];
+            uint32_t b = indices[i][(c + 1) % 3];
+            if (a == b) continue; // Degenerate triangle
+            if (a > b) { uint32_t t = a; a = b; b = t; }
+
+            uint64_t key = ((uint64_t)a << 32) | b;
+            size_t slot = hashEdge(key) & (tableSize - 1);
+            while (edgeTable[slot] != UINT64_MAX && edgeTable[slot] != key) {
+                slot = (slot + 1) & (tableSize - 1);
+            }
+            if (edgeTable[slot] == UINT64_MAX) {
+                edgeTable[slot] = key;
+                edges[edgeCount][0] = a;
+                edges[edgeCount][1] = b;
+                edgeCount++;
+            }
+        }
+    }
+
+    // Lay the sections out like the file, so the loader can use this image the same way as a mapping
+    size_t vertexOffset = alignUp(sizeof(MeshHeader));
+    size_t indexOffset = alignUp(vertexOffset + vertexCount * sizeof(float[4]));
+    size_t edgeOffset = alignUp(indexOffset + triangleCount * sizeof(uint32_t[3]));
+    size_t normalOffset = alignUp(edgeOffset + edgeCount * sizeof(uint32_t[2]));
+    size_t lodOffset = alignUp(normalOffset + triangleCount * sizeof(float[4]));
+    size_t fileSize = lodOffset; // No LODs generated here
+
+    image = aligned_alloc(MESH_ALIGNMENT, fileSize);
+    if (!image) {
+        printf("Failed to allocate memory for mesh image\n");
+        goto done;
+    }
+    memset(image, 0, fileSize);
+
+    uint8_t* bytes = (uint8_t*)image;
+    MeshHeader* header = (MeshHeader*)image;
+    header->magic = MESH_MAGIC;
+    header->version = MESH_VERSION;
+    header->headerSize = sizeof(MeshHeader);
+    header->vertexCount = vertexCount;
+    header->triangleCount = triangleCount;
+    header->edgeCount = edgeCount;
+    header->lodCount = 0;
+    header->vertexOffset = vertexOffset;
+    header->indexOffset = indexOffset;
+    header->edgeOffset = edgeOffset;
+    header->normalOffset = normalOffset;
+    header->lodOffset = lodOffset;
+    header->fileSize = fileSize;
+
+    memcpy(bytes + vertexOffset, vertices, vertexCount * sizeof(float[4]));
+    memcpy(bytes + indexOffset, indices, triangleCount * sizeof(uint32_t[3]));
+    memcpy(bytes + edgeOffset, edges, edgeCount * sizeof(uint32_t[2]));
+
+    // Face normals, from the original winding
+    float (*normals)[4] = (float(*)[4])(bytes + normalOffset);
+    for (size_t i = 0; i < triangleCount; i++) {
+        const Triangle* tri = &triangles[i];
+        float edge1[3] = {tri->v2[0] - tri->v1[0], tri->v2[1] - tri->v1[1], tri->v2[2] - tri->v1[2]};
+        float edge2[3] = {tri->v3[0] - tri->v1[0], tri->v3[1] - tri->v1[1], tri->v3[2] - tri->v1[2]};
+        float n[3] = {
+            edge1[1] * edge2[2] - edge1[2] * edge2[1],
+            edge1[2] * edge2[0] - edge1[0] * edge2[2],
+            edge1[0] * edge2[1] - edge1[1] * edge2[0]
+        };
+        float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length > 0.0f) {
+            n[0] /= length;
+            n[1] /= length;
+            n[2] /= length;
+        }
+        normals[i][0] = n[0];
+        normals[i][1] = n[1];
+        normals[i][2] = n[2];
+    }
+
+    // Bounds, the rotation center is the average over triangle corners like the old loader had it
+    double sum[3] = {0.0, 0.0, 0.0};
+    for (int j = 0; j < 3; j++) {
+        header->boundsMin[j] = vertexCount ? vertices[0][j] : 0.0f;
+        header->boundsMax[j] = vertexCount ? vertices[0][j] : 0.0f;
+    }
+    for (size_t i = 0; i < vertexCount; i++) {
+        for (int j = 0; j < 3; j++) {
+            if (vertices[i][j] < header->boundsMin[j]) header->boundsMin[j] = vertices[i][j];
+            if (vertices[i][j] > header->boundsMax[j]) header->boundsMax[j] = vertices[i][j];
+        }
+    }
+    for (size_t i = 0; i < triangleCount; i++) {
+        for (int j = 0; j < 3; j++) {
+            sum[j] += triangles[i].v1[j] + triangles[i].v2[j] + triangles[i].v3[j];
+        }
+    }
+    for (int j = 0; j < 3; j++) {
+        header->center[j] = cornerCount ? sum[j] / cornerCount : 0.0;
+        header->sphere[j] = (header->boundsMin[j] + header->boundsMax[j]) * 0.5f;
+    }
+    for (size_t i = 0; i < vertexCount; i++) {
+        float dc[3], ds[3];
+        for (int j = 0; j < 3; j++) {
+            dc[j] = vertices[i][j] - header->center[j];
+            ds[j] = vertices[i][j] - header->sphere[j];
+        }
+        float centerDistance = sqrtf(dc[0] * dc[0] + dc[1] * dc[1] + dc[2] * dc[2]);
+        float sphereDistance = sqrtf(ds[0] * ds[0] + ds[1] * ds[1] + ds[2] * ds[2]);
+        if (centerDistance > header->center[3]) header->center[3] = centerDistance;
+        if (sphereDistance > header->sphere[3]) header->sphere[3] = sphereDistance;
+    }
+
+    // Keep whichever sphere is tighter, the AABB center isn't always better than the rotation center
+    if (header->center[3] < header->sphere[3]) {
+        memcpy(header->sphere, header->center, sizeof(header->sphere));
+    }
+
+    header->checksum = fnv1a(bytes + sizeof(MeshHeader), fileSize - sizeof(MeshHeader));
+    *imageSize = fileSize;
+
+done:
+    free(vertices);
+    free(indices);
+    free(edges);
+    free(vertexTable);
+    free(edgeTable);
+    return image;
+}
+
+// Points a mesh at a v2 image, checking everything so a bad file can't send the renderer out of bounds
+static int attachMesh(const void* data, size_t size, Mesh* mesh) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    const MeshHeader* header = (const MeshHeader*)data;
+
+    if (size < sizeof(MeshHeader) || header->magic != MESH_MAGIC) {
+        printf("%s: not a mesh file\n", mesh->filename);
+        return -1;
+    }
+    if (header->version != MESH_VERSION || header->headerSize != sizeof(MeshHeader)) {
+        printf("%s: unsupported mesh version %u\n", mesh->filename, header->version);
+        return -1;
+    }
+    if (header->fileSize != size) {
+        printf("%s: truncated mesh file\n", mesh->filename);
+        return -1;
+    }
+
+    // Totals over the full detail mesh and every LOD
+    uint64_t triangleTotal = header->triangleCount;
+    uint64_t edgeTotal = header->edgeCount;
+    uint64_t offsets[5] = {header->vertexOffset, header->indexOffset, header->edgeOffset, header->normalOffset, header->lodOffset};
+    for (int i = 0; i < 5; i++) {
+        if (offsets[i] % MESH_ALIGNMENT != 0 || offsets[i] > size) {
+            printf("%s: bad section offset\n", mesh->filename);
+            return -1;
+        }
+    }
+    if (header->lodOffset + (uint64_t)header->lodCount * sizeof(MeshLod) > size) {
+        printf("%s: bad LOD table\n", mesh->filename);
+        return -1;
+    }
+    const MeshLod* lods = (const MeshLod*)(bytes + header->lodOffset);
+    for (uint32_t i = 0; i < header->lodCount; i++) {
+        uint64_t triangleEnd = (uint64_t)lods[i].firstTriangle + lods[i].triangleCount;
+        uint64_t edgeEnd = (uint64_t)lods[i].firstEdge + lods[i].edgeCount;
+        if (triangleEnd > triangleTotal) triangleTotal = triangleEnd;
+        if (edgeEnd > edgeTotal) edgeTotal = edgeEnd;
+    }
+    if (header->vertexOffset + (uint64_t)header->vertexCount * sizeof(float[4]) > size ||
+        header->indexOffset + triangleTotal * sizeof(uint32_t[3]) > size ||
+        header->edgeOffset + edgeTotal * sizeof(uint32_t[2]) > size ||
+        header->normalOffset + triangleTotal * sizeof(float[4]) > size) {
+        printf("%s: section runs past the end of the file\n", mesh->filename);
+        return -1;
+    }
+    if (fnv1a(bytes + sizeof(MeshHeader), size - sizeof(MeshHeader)) != header->checksum) {
+        printf("%s: checksum mismatch\n", mesh->filename);
+        return -1;
+    }
+
+    // Indices have to stay inside the vertex list, done once here instead of every frame
+    const uint32_t (*indices)[3] = (const uint32_t(*)[3])(bytes + header->indexOffset);
+    const uint32_t (*edges)[2] = (const uint32_t(*)[2])(bytes + header->edgeOffset);
+    for (uint64_t i = 0; i < triangleTotal; i++) {
+        if (indices[i][0] >= header->vertexCount || indices[i][1] >= header->vertexCount || indices[i][2] >= header->vertexCount) {
+            printf("%s: triangle index out of range\n", mesh->filename);
+            return -1;
+        }
+    }
+    for (uint64_t i = 0; i < edgeTotal; i++) {
+        if (edges[i][0] >= header->vertexCount || edges[i][1] >= header->vertexCount) {
+            printf("%s: edge index out of range\n", mesh->filename);
+            return -1;
+        }
+    }
+
+    mesh->vertices = (const float(*)[4])(bytes + header->vertexOffset);
+    mesh->vertexCount = header->vertexCount;
+    mesh->indices = indices;
+    mesh->triangle_count = header->triangleCount;
+    mesh->edges = edges;
+    mesh->edgeCount = header->edgeCount;
+    mesh->normals = (const float(*)[4])(bytes + header->normalOffset);
+    mesh->lods = lods;
+    mesh->lodCount = header->lodCount;
+    for (int j = 0; j < 3; j++) {
+        mesh->boundsMin[j] = header->boundsMin[j];
+        mesh->boundsMax[j] = header->boundsMax[j];
+        mesh->center[j] = header->center[j];
+        mesh->sphereCenter[j] = header->sphere[j];
+    }
+    mesh->radius = header->center[3];
+    mesh->sphereRadius = header->sphere[3];
+    return 0;
+}
+
+typedef struct {
+    MeshBvhNode* nodes;
+    uint32_t numNodes;
+    uint32_t depth; // Deepest level reached so far
+    uint32_t* triangles;
+    float (*centroids)[3];
+    const float (*vertices)[4];
+    const uint32_t (*indices)[3];
+} BvhBuild;
+
+// Builds the node for triangles [first, first + count) and everything under it, returns its index
+static uint32_t buildBvhNode(BvhBuild* build, uint32_t first, uint32_t count, uint32_t depth) {
+    uint32_t index = build->numNodes++;
+    if (depth > build->depth) build->depth = depth;
+    MeshBvhNode* node = &build->nodes[index];
+
+    float centroidMin[3] = {INFINITY, INFINITY, INFINITY};
+    float centroidMax[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (int k = 0; k < 3; k++) {
+        node->boundsMin[k] = INFINITY;
+        node->boundsMax[k] = -INFINITY;
+    }
+    for (uint32_t i = first; i < first + count; i++) {
+        uint32_t triangle = build->triangles[i];
+        for (int corner = 0; corner < 3; corner++) {
+            const float* v = build->vertices[build->indices[triangle][corner]];
+            for (int k = 0; k < 3; k++) {
+                node->boundsMin[k] = fminf(node->boundsMin[k], v[k]);
+                node->boundsMax[k] = fmaxf(node->boundsMax[k], v[k]);
+            }
+        }
+        for (int k = 0; k < 3; k++) {
+            centroidMin[k] = fminf(centroidMin[k], build->centroids[triangle][k]);
+            centroidMax[k] = fmaxf(centroidMax[k], build->centroids[triangle][k]);
+        }
+    }
+
+    if (count <= MESH_BVH_LEAF_SIZE) {
+        node->first = first;
+        node->count = count;
+        return index;
+    }
+
+    // Split the longest axis of the centroids down the middle
+    int axis = 0;
+    for (int k = 1; k < 3; k++) {
+        if (centroidMax[k] - centroidMin[k] > centroidMax[axis] - centroidMin[axis]) axis = k;
+    }
+    float split = (centroidMin[axis] + centroidMax[axis]) * 0.5f;
+    uint32_t middle = first;
+    for (uint32_t i = first; i < first + count; i++) {
+        if (build->centroids[build->triangles[i]][axis] < split) {
+            uint32_t swap = build->triangles[i];
+            build->triangles[i] = build->triangles[middle];
+            build->triangles[middle++] = swap;
+        }
+    }
+    // Everything on one side (all centroids the same), just cut the list in half
+    if (middle == first || middle == first + count) middle = first + count / 2;
+
+    node->count = 0;
+    buildBvhNode(build, first, middle - first, depth + 1);
+    uint32_t second = buildBvhNode(build, middle, first + count - middle, depth + 1);
+    node->first = second;
+    return index;
+}
+
+static int buildMeshBvh(Mesh* mesh) {
+    uint32_t count = mesh->triangle_count;
+    if (count == 0) return 0;
+
+    BvhBuild build = {0};
+    build.nodes = (MeshBvhNode*)malloc(2 * count * sizeof(MeshBvhNode)); // A binary tree never needs more
+    build.triangles = (uint32_t*)malloc(count * sizeof(uint32_t));
+    build.centroids = (float(*)[3])malloc(count * sizeof(float[3]));
+    build.vertices = mesh->vertices;
+    build.indices = mesh->indices;
+    if (!build.nodes || !build.triangles || !build.centroids) {
+        printf("Failed to allocate memory for mesh BVH\n");
+        free(build.nodes);
+        free(build.triangles);
+        free(build.centroids);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        build.triangles[i] = i;
+        for (int k = 0; k < 3; k++) {
+            build.centroids[i][k] = (mesh->vertices[mesh->indices[i][0]][k] +
+                                     mesh->vertices[mesh->indices[i][1]][k] +
+                                     mesh->vertices[mesh->indices[i][2]][k]) / 3.0f;
+        }
+    }
+    buildBvhNode(&build, 0, count, 0);
+    free(build.centroids);
+
+    mesh->bvh = build.nodes;
+    mesh->bvhNodeCount = build.numNodes;
+    mesh->bvhDepth = build.depth;
+    mesh->bvhTriangles = build.triangles;
+    return 0;
+}
+
+// Maps a mesh file read-only, v2 files are used in place, legacy ones get converted
+static int loadMeshFile(const char* filename, Mesh* mesh) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Failed to open file: %s\n", filename);
+        return -1;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(Triangle)) {
+        printf("Mesh file is empty: %s\n", filename);
+        close(fd);
+        return -1;
+    }
+
+    // MAP_SHARED + PROT_READ, every process running the engine shares the same page cache copy
+    void* mapping = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        printf("Failed to map file: %s\n", filename);
+        return -1;
+    }
+
+    if ((size_t)info.st_size >= sizeof(MeshHeader) && ((const MeshHeader*)mapping)->magic == MESH_MAGIC) {
+        if (attachMesh(mapping, info.st_size, mesh) != 0) {
+            munmap(mapping, info.st_size);
+            return -1;
+        }
+        mesh->mapping = mapping;
+        mesh->mappingSize = info.st_size;
+        return 0;
+    }
+
+    // Legacy file, a headerless dump of triangles, convert it to a v2 image in memory
+    size_t imageSize = 0;
+    void* image = buildMeshImage((const Triangle*)mapping, info.st_size / sizeof(Triangle), &imageSize);
+    munmap(mapping, info.st_size);
+    if (!image || attachMesh(image, imageSize, mesh) != 0) {
+        free(image);
+        return -1;
+    }
+    mesh->image = image;
+    return 0;
+}
+
+// Only used for occlusion, a convex mesh hides at least everything behind this sphere
+static void measureInnerRadius(Mesh* mesh) {
+    float inner = mesh->radius;
+    for (size_t i = 0; i < mesh->triangle_count; i++) {
+        const float* n = mesh->normals[i];
+        if (n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f) continue;
+        const float* v = mesh->vertices[mesh->indices[i][0]];
+        float distance = fabsf((v[0] - mesh->center[0]) * n[0] + (v[1] - mesh->center[1]) * n[1] + (v[2] - mesh->center[2]) * n[2]);
+        if (distance < inner) inner = distance;
+    }
+    mesh->innerRadius = inner;
+}
+
+static void destroyMesh(Mesh* mesh) {
+    if (mesh->mapping) munmap(mesh->mapping, mesh->mappingSize);
+    free(mesh->image);
+    free((void*)mesh->bvh);
+    free((void*)mesh->bvhTriangles);
+    free(mesh);
+}
+
+// Caller holds meshLock
+static const Mesh* lookupMesh(const char* filename) {
+    for (int i = 0; i < numMeshes; i++) {
+        if (strcmp(meshes[i]->filename, filename) == 0) return meshes[i];
+    }
+    return NULL;
+}
+
+const Mesh* findLoadedMesh(const char* filename) {
+    pthread_mutex_lock(&meshLock);
+    const Mesh* mesh = lookupMesh(filename);
+    pthread_mutex_unlock(&meshLock);
+    return mesh;
+}
+
+const Mesh* getMesh(const char* filename) {
+    const Mesh* loaded = findLoadedMesh(filename);
+    if (loaded) return loaded;
+
+    Mesh* mesh = (Mesh*)calloc(1, sizeof(Mesh));
+    if (!mesh) {
+        printf("Failed to allocate memory for mesh\n");
+        return NULL;
+    }
+    snprintf(mesh->filename, sizeof(mesh->filename), "%s", filename);
+
+    if (loadMeshFile(filename, mesh) != 0) {
+        free(mesh);
+        return NULL;
+    }
+    measureInnerRadius(mesh);
+    if (buildMeshBvh(mesh) != 0) {
+        destroyMesh(mesh);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&meshLock);
+    // Another thread loaded the same file while this one was, keep theirs, it might already be in use
+    loaded = lookupMesh(filename);
+    if (loaded) {
+        pthread_mutex_unlock(&meshLock);
+        destroyMesh(mesh);
+        return loaded;
+    }
+    Mesh** newMeshes = (Mesh**)realloc(meshes, (numMeshes + 1) * sizeof(Mesh*));
+    if (!newMeshes) {
+        pthread_mutex_unlock(&meshLock);
+        printf("Failed to allocate memory for mesh list\n");
+        destroyMesh(mesh);
+        return NULL;
+    }
+    meshes = newMeshes;
+    meshes[numMeshes++] = mesh;
+    pthread_mutex_unlock(&meshLock);
+    return mesh;
+}
+
+void freeMeshes(void) {
+    pthread_mutex_lock(&meshLock);
+    for (int i = 0; i < numMeshes; i++) {
+        destroyMesh(meshes[i]);
+    }
+    free(meshes);
+    meshes = NULL;
+    numMeshes = 0;
+    pthread_mutex_unlock(&meshLock);
+}
+
+int writeMeshFile(const char* filename, const Triangle* triangles, size_t triangleCount) {
+    size_t imageSize = 0;
+    void* image = buildMeshImage(triangles, triangleCount, &imageSize);
+    if (!image) return -1;
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        printf("Failed to open file for writing: %s\n", filename);
+        free(image);
+        return -1;
+    }
+    size_t written = fwrite(image, 1, imageSize, file);
+    fclose(file);
+    free(image);
+
+    if (written != imageSize) {
+        printf("Failed to write mesh file: %s\n", filename);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    float v1[3];
+    float v2[3];
+    float v3[3];
+} Triangle;
+
+// Mesh file format v2, everything little-endian and every section starts 16-byte aligned
+// Legacy .bin files are just a list of Triangles with no header, they're converted when loaded
+#define MESH_MAGIC 0x324D4C45 // "ELM2"
+#define MESH_VERSION 2
+#define MESH_ALIGNMENT 16
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize; // sizeof(MeshHeader), so the header can grow later
+    uint32_t checksum; // FNV-1a over everything after the header
+    uint32_t vertexCount; // Unique vertices
+    uint32_t triangleCount; // Full detail triangles, LOD triangles come after these
+    uint32_t edgeCount; // Full detail unique edges, LOD edges come after these
+    uint32_t lodCount;
+    float boundsMin[4]; // AABB, w unused
+    float boundsMax[4];
+    float center[4]; // Average of the triangle vertices, what objects rotate around, w is the radius around it
+    float sphere[4]; // Bounding sphere, xyz center and w radius
+    uint64_t vertexOffset; // float[4] per vertex
+    uint64_t indexOffset; // uint32_t[3] per triangle
+    uint64_t edgeOffset; // uint32_t[2] per edge
+    uint64_t normalOffset; // float[4] per triangle, face normals
+    uint64_t lodOffset; // MeshLod per LOD
+    uint64_t fileSize;
+} MeshHeader;
+
+// Lower detail versions of the mesh, ranges into the same index/edge/normal arrays as the full detail one
+typedef struct {
+    uint32_t firstTriangle, triangleCount;
+    uint32_t firstEdge, edgeCount;
+    float switchDistance; // Use this LOD from this distance on, in unscaled mesh units
+    uint32_t padding[3];
+} MeshLod;
+
+// Bounding volume hierarchy over the full detail triangles, built when the mesh is loaded, for collisions
+typedef struct {
+    float boundsMin[3];
+    uint32_t first; // Leaf: first entry in Mesh.bvhTriangles, inner: index of the second child, the first is the next node
+    float boundsMax[3];
+    uint32_t count; // Triangles in a leaf, 0 for inner nodes
+} MeshBvhNode;
+
+#define MESH_BVH_LEAF_SIZE 4
+
+// Mesh data shared by every object that uses the same file
+// For v2 files every array points straight into a read-only mapping of the file, legacy files
+// get converted into a v2 image in memory, either way it's model space and never modified
+typedef struct {
+    char filename[256];
+    const float (*vertices)[4];
+    size_t vertexCount;
+    const uint32_t (*indices)[3];
+    size_t triangle_count;
+    const uint32_t (*edges)[2];
+    size_t edgeCount;
+    const float (*normals)[4];
+    const MeshLod* lods;
+    uint32_t lodCount;
+    float boundsMin[3], boundsMax[3];
+    float center[3]; // Objects rotate around this
+    float radius; // Furthest vertex from the center, unscaled
+    float sphereCenter[3]; // Tighter bounding sphere
+    float sphereRadius;
+    float innerRadius; // Center to the nearest face plane, the biggest sphere that fits inside if the mesh is convex
+    void* mapping; // Set for v2 files
+    size_t mappingSize;
+    void* image; // Set for converted legacy files
+    const MeshBvhNode* bvh; // Node 0 is the root
+    uint32_t bvhNodeCount;
+    uint32_t bvhDepth; // Levels below the root, a walk that pushes both children never has more than this + 1 waiting
+    const uint32_t* bvhTriangles; // Triangle indices in leaf order
+} Mesh;
+
+// Returns the mesh for a file, loading it the first time it's asked for, NULL if it can't be loaded
+// Safe to call from any thread, loader.h does it in the background so nothing has to wait on the disk
+const Mesh* getMesh(const char* filename);
+
+// Same but never loads, NULL if nothing has loaded it yet
+const Mesh* findLoadedMesh(const char* filename);
+
+// Unmaps every loaded mesh, anything still pointing at one is invalid afterwards
+void freeMeshes(void);
+
+// Builds a v2 image from a list of triangles, returns a 16-byte aligned block to free() and its size
+void* buildMeshImage(const Triangle* triangles, size_t triangleCount, size_t* imageSize);
+
+// Converts a list of triangles and writes them out as a v2 file, returns 0 on success
+int writeMeshFile(const char* filename, const Triangle* triangles, size_t triangleCount);
+
+#endif // MESH_H
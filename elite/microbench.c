@@ -0,0 +1,369 @@
+// Micro-benchmarks for the engine's own math and raster primitives, one at a time on the same inputs every run
+// elite.c gets included as it is, so what's timed is exactly what the game runs, static inline ones included
+// Needs SDL and GL to link like the game does, but never opens a window, built by compile.sh
+// ./microbench.x86_64 [--reps 21] [--filter drawEdge] [--json results.json] [--label name]
+// Run it with --json on two commits and compare the median ns/op, the spread says how much of a change is noise
+
+#define main eliteMain // The game's main, never called
+#include "elite.c"
+#undef main
+
+#include <time.h>
+
+#define MICRO_SEED 27182818
+#define MICRO_WARMUP_REPS 3 // After the calibration runs, before anything's timed
+#define MICRO_REPS 21 // Default, --reps changes it
+#define MICRO_MAX_REPS 1000
+#define MICRO_REP_NS 2000000.0 // Each repetition runs about this long, the calibration picks the op count for it
+#define MICRO_OBJECTS 64 // Copies of a mesh in front of the camera
+#define MICRO_LINES 4096
+#define MICRO_SHORT_LINE 24.0f // Longest of the short lines, about what an edge of a far away ship is
+#define MICRO_AXES 64
+#define MICRO_MAX_RESULTS 32
+
+typedef struct {
+    const char* name;
+    char input[48];
+    size_t ops; // Per repetition
+    int reps;
+    double minNs, medianNs, meanNs, stddevNs; // Per op
+} MicroResult;
+
+MicroResult microResults[MICRO_MAX_RESULTS];
+int numMicroResults = 0;
+volatile float microSink; // Everything a benchmark works out ends up here, so none of it gets optimized away
+
+// Inputs, the current one for each benchmark
+float (*microPoints)[3] = NULL; // World space mesh vertices in front of the camera
+size_t numMicroPoints = 0;
+float (*microTriangles)[3][3] = NULL; // World space triangles, same objects
+size_t numMicroTriangles = 0;
+float (*microLines)[4] = NULL; // x0 y0 x1 y1 in screen space
+unsigned char* microPixels = NULL;
+float microAxes[MICRO_AXES][3];
+Object microObject;
+
+static double microNowNs(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void microProjectVertex(size_t ops) {
+    float sum = 0.0f;
+    size_t i = 0;
+    for (size_t n = 0; n < ops; n++) {
+        float x, y;
+        if (projectVertex(microPoints[i], &x, &y)) sum += x + y;
+        if (++i == numMicroPoints) i = 0;
+    }
+    microSink = sum;
+}
+
+static void microDistance(size_t ops) {
+    float sum = 0.0f;
+    size_t i = 0;
+    for (size_t n = 0; n < ops; n++) {
+        size_t j = i + 1 == numMicroPoints ? 0 : i + 1;
+        sum += fgetDistance3D(microPoints[i], microPoints[j]);
+        i = j;
+    }
+    microSink = sum;
+}
+
+static void microDrawEdge(size_t ops) {
+    size_t i = 0;
+    for (size_t n = 0; n < ops; n++) {
+        const float* line = microLines[i];
+        drawEdge(line[0], line[1], line[2], line[3], microPixels, 0xFFFFFF);
+        if (++i == MICRO_LINES) i = 0;
+    }
+    microSink = microPixels[0];
+}
+
+static void microShadeColor(size_t ops) {
+    float lightPos[3] = {50000.0f, 20000.0f, 10000.0f};
+    uint32_t sum = 0;
+    size_t i = 0;
+    for (size_t n = 0; n < ops; n++) {
+        sum += shadeColor(0xC0A080, microTriangles[i][0], microTriangles[i][1], microTriangles[i][2], lightPos);
+        if (++i == numMicroTriangles) i = 0;
+    }
+    microSink = (float)sum;
+}
+
+static void microRotateObject(size_t ops) {
+    size_t i = 0;
+    for (size_t n = 0; n < ops; n++) {
+        rotateObjectAroundAxis(&microObject, microAxes[i], 0.01f);
+        if (++i == MICRO_AXES) i = 0;
+    }
+    microSink = microObject.forward[0];
+}
+
+static void microObjectCenter(size_t ops) {
+    float sum = 0.0f;
+    for (size_t n = 0; n < ops; n++) {
+        float center[3] = {0.0f, 0.0f, 0.0f};
+        calculateObjectCenter(&microObject, center);
+        sum += center[0];
+        microObject.position[0] += 1.0f; // So it isn't the same call every time
+    }
+    microSink = sum;
+}
+
+// The whole overlay at full resolution with the graph full
+static void microHudDraw(size_t ops) {
+    HudStats stats = {.frameMs = 7.5f, .fps = 133.0f, .logicMs = 0.4f, .renderMs = 5.2f, .rasterMs = 1.1f,
+                      .objectsDrawn = 1234, .triangles = 5678, .edges = 23456, .culled = 321, .aiUpdates = 4000,
+                      .width = SCREEN_WIDTH, .height = SCREEN_HEIGHT};
+    for (size_t n = 0; n < ops; n++) hudDraw(&hud, (uint32_t*)microPixels, SCREEN_WIDTH, SCREEN_HEIGHT, &stats);
+    microSink = microPixels[0];
+}
+
+// The first paused frame, the whole screen
+static void microPauseMenuFull(size_t ops) {
+    DirtyRect dirty;
+    for (size_t n = 0; n < ops; n++) {
+        pause_menu_invalidate();
+        draw_pause_menu(microPixels, &dirty);
+    }
+    microSink = microPixels[0];
+}
+
+// Dragging the slider, the value changes every frame and only its line gets drawn
+static void microPauseMenuSlider(size_t ops) {
+    DirtyRect dirty;
+    for (size_t n = 0; n < ops; n++) {
+        settings.bumpscosity.value = (int)(n % 1000);
+        draw_pause_menu(microPixels, &dirty);
+    }
+    microSink = microPixels[0];
+}
+
+static double microTime(void (*body)(size_t), size_t ops) {
+    double start = microNowNs();
+    body(ops);
+    return microNowNs() - start;
+}
+
+// Quickest of a few, one run getting preempted shouldn't throw the calibration off
+static double microTimeBest(void (*body)(size_t), size_t ops) {
+    double best = microTime(body, ops);
+    for (int i = 0; i < 2; i++) best = fmin(best, microTime(body, ops));
+    return best;
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Finds how many ops fill a repetition, warms up, then times every repetition on its own
+static void microRun(const char* name, const char* input, void (*body)(size_t), int reps, const char* filter) {
+    if (filter && !strstr(name, filter)) return;
+    if (numMicroResults == MICRO_MAX_RESULTS) return;
+
+    size_t ops = 64;
+    double elapsed;
+    body(ops); // Untimed, the first call pays for cold caches
+    while ((elapsed = microTimeBest(body, ops)) < MICRO_REP_NS / 8 && ops < ((size_t)1 << 32)) ops *= 2;
+    ops = (size_t)(ops * MICRO_REP_NS / fmax(elapsed, 1.0));
+    if (ops == 0) ops = 1;
+    for (int r = 0; r < MICRO_WARMUP_REPS; r++) body(ops);
+
+    double perOp[MICRO_MAX_REPS];
+    double sum = 0.0;
+    for (int r = 0; r < reps; r++) {
+        perOp[r] = microTime(body, ops) / ops;
+        sum += perOp[r];
+    }
+    qsort(perOp, reps, sizeof(double), compareDoubles);
+
+    MicroResult* result = &microResults[numMicroResults++];
+    result->name = name;
+    snprintf(result->input, sizeof(result->input), "%s", input);
+    result->ops = ops;
+    result->reps = reps;
+    result->minNs = perOp[0];
+    result->medianNs = reps % 2 ? perOp[reps / 2] : (perOp[reps / 2 - 1] + perOp[reps / 2]) / 2.0;
+    result->meanNs = sum / reps;
+    double variance = 0.0;
+    for (int r = 0; r < reps; r++) variance += (perOp[r] - result->meanNs) * (perOp[r] - result->meanNs);
+    result->stddevNs = sqrt(variance / reps);
+
+    printf("%-24s %-20s %9.2f ns/op median  %9.2f min  %9.2f mean  +-%7.2f  %9.2f Mops/s  (%d x %zu ops)\n",
+           name, input, result->medianNs, result->minNs, result->meanNs, result->stddevNs, 1000.0 / result->medianNs,
+           reps, ops);
+}
+
+// MICRO_OBJECTS copies of the mesh spread out in front of the camera, its vertices and its triangles in world space
+static int microPlaceMesh(const char* filename) {
+    const Mesh* mesh = getMesh(filename);
+    if (!mesh) return -1;
+    free(microPoints);
+    free(microTriangles);
+    numMicroPoints = MICRO_OBJECTS * mesh->vertexCount;
+    numMicroTriangles = MICRO_OBJECTS * mesh->triangle_count;
+    microPoints = malloc(numMicroPoints * sizeof(*microPoints));
+    microTriangles = malloc(numMicroTriangles * sizeof(*microTriangles));
+    if (!microPoints || !microTriangles) {
+        printf("Failed to allocate memory for the benchmark inputs\n");
+        return -1;
+    }
+
+    Rng rng;
+    rngSeed(&rng, MICRO_SEED);
+    Object object;
+    memset(&object, 0, sizeof(Object));
+    object.mesh = mesh;
+    object.scale = 2.0f;
+    object.forward[0] = object.up[1] = object.right[2] = 1.0f;
+    size_t point = 0, triangle = 0;
+    for (int k = 0; k < MICRO_OBJECTS; k++) {
+        float distance = rngRange(&rng, 100.0f, 2000.0f);
+        float across = rngRange(&rng, -0.5f, 0.5f) * distance, along = rngRange(&rng, -0.3f, 0.3f) * distance;
+        object.position[0] = cameraPos.x + camForward.x * distance + camRight.x * across + camUp.x * along;
+        object.position[1] = cameraPos.y + camForward.y * distance + camRight.y * across + camUp.y * along;
+        object.position[2] = cameraPos.z + camForward.z * distance + camRight.z * across + camUp.z * along;
+        for (size_t v = 0; v < mesh->vertexCount; v++) objectToWorld(&object, mesh->vertices[v], microPoints[point++]);
+        for (size_t t = 0; t < mesh->triangle_count; t++) {
+            for (int c = 0; c < 3; c++) objectToWorld(&object, mesh->vertices[mesh->indices[t][c]], microTriangles[triangle][c]);
+            triangle++;
+        }
+    }
+    return 0;
+}
+
+// Endpoints anywhere on screen, or short ones going every which way
+static void microMakeLines(float maxLength) {
+    Rng rng;
+    rngSeed(&rng, MICRO_SEED);
+    for (int i = 0; i < MICRO_LINES; i++) {
+        float* line = microLines[i];
+        line[0] = rngRange(&rng, 0.0f, renderWidth - 1.0f);
+        line[1] = rngRange(&rng, 0.0f, renderHeight - 1.0f);
+        if (maxLength > 0.0f) {
+            line[2] = CLAMP(line[0] + rngRange(&rng, -maxLength, maxLength), 0.0f, renderWidth - 1.0f);
+            line[3] = CLAMP(line[1] + rngRange(&rng, -maxLength, maxLength), 0.0f, renderHeight - 1.0f);
+        } else {
+            line[2] = rngRange(&rng, 0.0f, renderWidth - 1.0f);
+            line[3] = rngRange(&rng, 0.0f, renderHeight - 1.0f);
+        }
+    }
+}
+
+static void microWriteString(FILE* file, const char* text) {
+    fputc('"', file);
+    for (; *text; text++) {
+        if (*text == '"' || *text == '\\') fputc('\\', file);
+        if ((unsigned char)*text >= 0x20) fputc(*text, file);
+    }
+    fputc('"', file);
+}
+
+static int microWriteJson(const char* filename, const char* label) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        printf("Failed to open %s for writing\n", filename);
+        return -1;
+    }
+    fprintf(file, "{\n  \"label\": ");
+    microWriteString(file, label);
+    fprintf(file, ",\n  \"simd\": \"%s\",\n  \"results\": [\n", simdPath->name);
+    for (int i = 0; i < numMicroResults; i++) {
+        const MicroResult* result = &microResults[i];
+        fprintf(file, "    {\"name\": \"%s\", \"input\": ", result->name);
+        microWriteString(file, result->input);
+        fprintf(file, ", \"reps\": %d, \"ops_per_rep\": %zu, \"ns_per_op\": {\"min\": %.3f, \"median\": %.3f, "
+                      "\"mean\": %.3f, \"stddev\": %.3f}, \"ops_per_second\": %.0f}%s\n",
+                result->reps, result->ops, result->minNs, result->medianNs, result->meanNs, result->stddevNs,
+                1e9 / result->medianNs, i + 1 < numMicroResults ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    printf("Wrote %d results to %s\n", numMicroResults, filename);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int reps = MICRO_REPS;
+    const char* filter = NULL;
+    const char* jsonFile = NULL;
+    const char* label = "";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+            if (reps < 1 || reps > MICRO_MAX_REPS) reps = MICRO_REPS;
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonFile = argv[++i];
+        } else if (strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            label = argv[++i];
+        }
+    }
+    printf("SIMD kernels: %s\n", simdInit(NULL));
+
+    // The camera the game starts with, looking down -z from the origin, at full resolution
+    cameraPos = (Vec3){0.0f, 0.0f, 0.0f};
+    cameraOrientation = (Quaternion){1.0f, 0.0f, 0.0f, 0.0f};
+    camForward = rotateVecByQuat((Vec3){0, 0, -1}, cameraOrientation);
+    camRight = rotateVecByQuat((Vec3){1, 0, 0}, cameraOrientation);
+    camUp = rotateVecByQuat((Vec3){0, 1, 0}, cameraOrientation);
+
+    microPixels = malloc((size_t)SCREEN_WIDTH * SCREEN_HEIGHT * BYTES_PER_PIXEL);
+    microLines = malloc(MICRO_LINES * sizeof(*microLines));
+    if (!microPixels || !microLines) {
+        printf("Failed to allocate memory for the benchmark inputs\n");
+        return 1;
+    }
+    memset(microPixels, 0, (size_t)SCREEN_WIDTH * SCREEN_HEIGHT * BYTES_PER_PIXEL); // Faulted in now, not while timing
+
+    const char* meshFiles[] = {"viper.bin", "sphere.bin"};
+    for (size_t m = 0; m < sizeof(meshFiles) / sizeof(meshFiles[0]); m++) {
+        if (microPlaceMesh(meshFiles[m]) != 0) continue;
+        microRun("projectVertex", meshFiles[m], microProjectVertex, reps, filter);
+        microRun("fgetDistance3D", meshFiles[m], microDistance, reps, filter);
+        microRun("shadeColor", meshFiles[m], microShadeColor, reps, filter);
+    }
+
+    microMakeLines(MICRO_SHORT_LINE);
+    microRun("drawEdge", "short random lines", microDrawEdge, reps, filter);
+    microMakeLines(0.0f);
+    microRun("drawEdge", "long random lines", microDrawEdge, reps, filter);
+
+    Rng rng;
+    rngSeed(&rng, MICRO_SEED);
+    for (int i = 0; i < MICRO_AXES; i++) {
+        float axis[3] = {rngRange(&rng, -1, 1), rngRange(&rng, -1, 1), rngRange(&rng, -1, 1)};
+        fnormalize(axis);
+        memcpy(microAxes[i], axis, sizeof(axis));
+    }
+    memset(&microObject, 0, sizeof(Object));
+    microObject.mesh = getMesh("viper.bin");
+    microObject.scale = 2.0f;
+    microObject.forward[0] = microObject.up[1] = microObject.right[2] = 1.0f;
+    if (microObject.mesh) {
+        microRun("rotateObjectAroundAxis", "viper.bin", microRotateObject, reps, filter);
+        microRun("calculateObjectCenter", "viper.bin", microObjectCenter, reps, filter);
+    }
+
+    if (hudInit(&hud, HUD_SCALE) == 0) {
+        for (int i = 0; i < HUD_HISTORY; i++) hudRecord(&hud, 4.0f + (i * 7 % 40));
+        microRun("hudDraw", "full resolution", microHudDraw, reps, filter);
+        hudFree(&hud);
+    }
+
+    microRun("draw_pause_menu", "full redraw", microPauseMenuFull, reps, filter);
+    microRun("draw_pause_menu", "slider moved", microPauseMenuSlider, reps, filter);
+    free_pause_menu();
+
+    int result = jsonFile ? microWriteJson(jsonFile, label) : 0;
+    free(microPoints);
+    free(microTriangles);
+    free(microLines);
+    free(microPixels);
+    freeMeshes();
+    return result == 0 ? 0 : 1;
+}
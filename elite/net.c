@@ -0,0 +1,821 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include "net.h"
+
+#define NET_MAGIC 0x54494C45 // "ELIT"
+#define NET_MAX_RECORD 36 // Biggest a changed entity can encode to
+#define NET_MAX_REMOVED 5 // Same for a removed one
+
+// Client to server, hellos and acks are the same thing, a hello is just an ack of nothing
+enum {
+    NET_HELLO,
+    NET_ACK,
+    NET_BYE
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t type;
+    uint32_t ackTick;
+    float view[3];
+} NetMessage;
+
+// Server to client, then the mesh names, the removed ids and the changed entities
+typedef struct {
+    uint32_t magic;
+    uint32_t tick;
+    uint32_t baseTick; // What it's a delta against, 0 for everything from scratch
+    uint16_t tickRate;
+    uint16_t numMeshNames;
+} NetHeader;
+
+// Which fields a changed entity has, the rest are the same as in the base
+enum {
+    NET_CHANGED_POSITION = 0x01,
+    NET_CHANGED_ORIENTATION = 0x02,
+    NET_CHANGED_COLOR = 0x04,
+    NET_CHANGED_MESH = 0x08, // Scale and kind as well
+    NET_CHANGED_ALL = 0x0F
+};
+
+static uint64_t nowMs(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000 + t.tv_nsec / 1000000;
+}
+
+static double preciseMs(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+void netOrientationFromBasis(const float forward[3], const float up[3], const float right[3], float orientation[4]) {
+    // Columns of the rotation matrix are where model x, y and z end up
+    float m00 = -forward[0], m10 = -forward[1], m20 = -forward[2];
+    float m01 = up[0], m11 = up[1], m21 = up[2];
+    float m02 = right[0], m12 = right[1], m22 = right[2];
+    float trace = m00 + m11 + m22;
+    float x, y, z, w;
+    if (trace > 0.0f) {
+        float s = sqrtf(trace + 1.0f) * 2.0f;
+        w = 0.25f * s;
+        x = (m21 - m12) / s;
+        y = (m02 - m20) / s;
+        z = (m10 - m01) / s;
+    } else if (m00 > m11 && m00 > m22) {
+        float s = sqrtf(1.0f + m00 - m11 - m22) * 2.0f;
+        w = (m21 - m12) / s;
+        x = 0.25f * s;
+        y = (m01 + m10) / s;
+        z = (m02 + m20) / s;
+    } else if (m11 > m22) {
+        float s = sqrtf(1.0f + m11 - m00 - m22) * 2.0f;
+        w = (m02 - m20) / s;
+        x = (m01 + m10) / s;
+        y = 0.25f * s;
+        z = (m12 + m21) / s;
+    } else {
+        float s = sqrtf(1.0f + m22 - m00 - m11) * 2.0f;
+        w = (m10 - m01) / s;
+        x = (m02 + m20) / s;
+        y = (m12 + m21) / s;
+        z = 0.25f * s;
+    }
+    float length = sqrtf(x * x + y * y + z * z + w * w);
+    orientation[0] = x / length;
+    orientation[1] = y / length;
+    orientation[2] = z / length;
+    orientation[3] = w / length;
+}
+
+void netBasisFromOrientation(const float orientation[4], float forward[3], float up[3], float right[3]) {
+    float x = orientation[0], y = orientation[1], z = orientation[2], w = orientation[3];
+    forward[0] = -(1.0f - 2.0f * (y * y + z * z));
+    forward[1] = -(2.0f * (x * y + z * w));
+    forward[2] = -(2.0f * (x * z - y * w));
+    up[0] = 2.0f * (x * y - z * w);
+    up[1] = 1.0f - 2.0f * (x * x + z * z);
+    up[2] = 2.0f * (y * z + x * w);
+    right[0] = 2.0f * (x * z + y * w);
+    right[1] = 2.0f * (y * z - x * w);
+    right[2] = 1.0f - 2.0f * (x * x + y * y);
+}
+
+// Smallest three, the biggest component is left out and worked out again from the other three, which can't be
+// bigger than 1/sqrt(2), q and -q are the same rotation so the left out one is always made positive
+static uint32_t packOrientation(const float q[4]) {
+    int largest = 0;
+    for (int i = 1; i < 4; i++) {
+        if (fabsf(q[i]) > fabsf(q[largest])) largest = i;
+    }
+    float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+    uint32_t packed = (uint32_t)largest << 30;
+    int shift = 20;
+    for (int i = 0; i < 4; i++) {
+        if (i == largest) continue;
+        float v = q[i] * sign * (float)M_SQRT2 * 0.5f + 0.5f; // 0 to 1
+        int bits = (int)lrintf(v * 1023.0f);
+        if (bits < 0) bits = 0;
+        if (bits > 1023) bits = 1023;
+        packed |= (uint32_t)bits << shift;
+        shift -= 10;
+    }
+    return packed;
+}
+
+static void unpackOrientation(uint32_t packed, float q[4]) {
+    int largest = packed >> 30;
+    int shift = 20;
+    float sum = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        if (i == largest) continue;
+        float v = ((packed >> shift) & 1023) / 1023.0f;
+        q[i] = (v - 0.5f) * 2.0f / (float)M_SQRT2;
+        sum += q[i] * q[i];
+        shift -= 10;
+    }
+    q[largest] = sqrtf(fmaxf(0.0f, 1.0f - sum));
+}
+
+static void quantize(const NetEntity* entity, NetState* state) {
+    state->id = entity->id;
+    for (int k = 0; k < 3; k++) state->position[k] = (int32_t)lrintf(entity->position[k] * NET_POSITION_SCALE);
+    state->orientation = packOrientation(entity->orientation);
+    state->scale = entity->scale;
+    state->color = entity->color;
+    state->mesh = entity->mesh;
+    state->kind = entity->kind;
+}
+
+// Variable length integers, 7 bits a byte, small deltas end up a byte or two
+static inline uint8_t* writeVarint(uint8_t* out, uint32_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+static inline uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+// Reading stops dead at the end of the packet, ok gets cleared and everything after reads as 0
+typedef struct {
+    const uint8_t* cursor;
+    const uint8_t* end;
+    int ok;
+} NetReader;
+
+static uint32_t readVarint(NetReader* reader) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (reader->cursor >= reader->end) {
+            reader->ok = 0;
+            return 0;
+        }
+        uint8_t byte = *reader->cursor++;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    reader->ok = 0;
+    return 0;
+}
+
+static void readBytes(NetReader* reader, void* out, size_t size) {
+    if ((size_t)(reader->end - reader->cursor) < size) {
+        reader->ok = 0;
+        memset(out, 0, size);
+        return;
+    }
+    memcpy(out, reader->cursor, size);
+    reader->cursor += size;
+}
+
+static int reserveFrame(NetFrame* frame, uint32_t count) {
+    if (count <= frame->capacity) return 0;
+    uint32_t capacity = frame->capacity ? frame->capacity : 64;
+    while (capacity < count) capacity *= 2;
+    NetState* states = (NetState*)realloc(frame->states, capacity * sizeof(NetState));
+    if (!states) {
+        printf("Failed to allocate memory for network snapshot\n");
+        return -1;
+    }
+    frame->states = states;
+    frame->capacity = capacity;
+    return 0;
+}
+
+static int openSocket(void) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+    // A tick can go out to every client back to back, the default buffers fill up fast
+    int size = 4 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+int netServerStart(NetServer* server, uint16_t port, float interestRadius, uint16_t tickRate) {
+    memset(server, 0, sizeof(NetServer));
+    server->socket = -1;
+    server->interestRadius = interestRadius;
+    server->tickRate = tickRate;
+    server->packet = (uint8_t*)malloc(NET_MAX_PACKET);
+    if (!server->packet) {
+        printf("Failed to allocate memory for network packets\n");
+        return -1;
+    }
+
+    server->socket = openSocket();
+    int reuse = 1;
+    struct sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_ANY)};
+    if (server->socket < 0 || setsockopt(server->socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+        bind(server->socket, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        printf("Failed to listen on port %u: %s\n", port, strerror(errno));
+        netServerStop(server);
+        return -1;
+    }
+    return 0;
+}
+
+uint16_t netServerMesh(NetServer* server, const char* filename) {
+    for (uint32_t i = 0; i < server->numMeshes; i++) {
+        if (strcmp(server->meshNames[i], filename) == 0) return (uint16_t)i;
+    }
+    if (server->numMeshes == NET_MAX_MESHES || strlen(filename) >= NET_MESH_NAME) return NET_NO_MESH;
+    strcpy(server->meshNames[server->numMeshes], filename);
+    return (uint16_t)server->numMeshes++;
+}
+
+static NetPeer* findPeer(NetServer* server, const struct sockaddr_in* address) {
+    for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+        NetPeer* peer = &server->peers[i];
+        if (peer->connected && peer->address.sin_addr.s_addr == address->sin_addr.s_addr &&
+            peer->address.sin_port == address->sin_port) return peer;
+    }
+    return NULL;
+}
+
+// Keeps the history allocations, they get reused by whoever connects next
+static void resetPeer(NetPeer* peer) {
+    for (int t = 0; t < NET_HISTORY; t++) {
+        peer->history[t].tick = 0;
+        peer->history[t].count = 0;
+    }
+    memset(peer->meshPending, 0, sizeof(peer->meshPending));
+    memset(peer->meshKnown, 0, sizeof(peer->meshKnown));
+    peer->ackTick = 0;
+    peer->connected = 0;
+}
+
+int netServerPoll(NetServer* server) {
+    uint64_t now = nowMs();
+    NetMessage message;
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    ssize_t size;
+    while ((size = recvfrom(server->socket, &message, sizeof(message), 0, (struct sockaddr*)&address, &length)) >= 0) {
+        length = sizeof(address);
+        if (size != sizeof(message) || message.magic != NET_MAGIC) continue;
+        NetPeer* peer = findPeer(server, &address);
+        if (message.type == NET_BYE) {
+            if (peer) resetPeer(peer);
+            continue;
+        }
+        if (!peer) {
+            for (int i = 0; i < NET_MAX_CLIENTS && !peer; i++) {
+                if (!server->peers[i].connected) peer = &server->peers[i];
+            }
+            if (!peer) continue; // Full
+            resetPeer(peer);
+            peer->connected = 1;
+            peer->address = address;
+        }
+        peer->lastHeard = now;
+        memcpy(peer->view, message.view, sizeof(peer->view));
+        // Acks can arrive out of order, an older one doesn't tell it anything new
+        if (message.type == NET_ACK && message.ackTick > peer->ackTick) {
+            peer->ackTick = message.ackTick;
+            for (uint32_t m = 0; m < server->numMeshes; m++) {
+                if (peer->meshPending[m] && peer->meshPending[m] <= peer->ackTick) peer->meshKnown[m] = 1;
+            }
+        }
+    }
+
+    int connected = 0;
+    for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+        NetPeer* peer = &server->peers[i];
+        if (!peer->connected) continue;
+        if (now - peer->lastHeard > NET_TIMEOUT_MS) resetPeer(peer);
+        else connected++;
+    }
+    return connected;
+}
+
+// Quickselect, afterwards the k nearest are the first k, in no particular order
+static void selectNearest(NetCandidate* candidates, uint32_t count, uint32_t k) {
+    int lo = 0, hi = (int)count - 1, target = (int)k - 1;
+    while (lo < hi) {
+        float pivot = candidates[lo + (hi - lo) / 2].distance;
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (candidates[i].distance < pivot) i++;
+            while (candidates[j].distance > pivot) j--;
+            if (i <= j) {
+                NetCandidate swap = candidates[i];
+                candidates[i++] = candidates[j];
+                candidates[j--] = swap;
+            }
+        }
+        // Everything up to j is no further than the pivot, everything from i on no nearer
+        if (target <= j) hi = j;
+        else if (target >= i) lo = i;
+        else break;
+    }
+}
+
+static inline uint32_t hashCell(int x, int y, int z, uint32_t mask) {
+    return ((uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u) & mask;
+}
+
+static inline int cellCoordinate(float v, float cellSize) {
+    return (int)floorf(v / cellSize);
+}
+
+// Counting sort of the entities by bucket, returns -1 if it ran out of memory
+static int buildInterestGrid(NetServer* server, const NetEntity* entities, uint32_t count) {
+    uint32_t numBuckets = 64;
+    while (numBuckets < count * 2) numBuckets <<= 1;
+    if (numBuckets + 1 > server->bucketCapacity) {
+        uint32_t* bucketStart = (uint32_t*)realloc(server->bucketStart, (numBuckets + 1) * sizeof(uint32_t));
+        if (bucketStart) server->bucketStart = bucketStart;
+        uint32_t* bucketVisit = (uint32_t*)realloc(server->bucketVisit, numBuckets * sizeof(uint32_t));
+        if (bucketVisit) server->bucketVisit = bucketVisit;
+        if (!bucketStart || !bucketVisit) {
+            printf("Failed to allocate memory for network interest grid\n");
+            return -1;
+        }
+        server->bucketCapacity = numBuckets + 1;
+        memset(server->bucketVisit, 0, numBuckets * sizeof(uint32_t));
+        server->visitStamp = 0;
+    }
+    server->numBuckets = numBuckets;
+    server->cellSize = server->interestRadius / NET_GRID_DIVISIONS;
+    uint32_t mask = numBuckets - 1;
+
+    uint32_t* start = server->bucketStart;
+    memset(start, 0, (numBuckets + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++) {
+        const float* position = entities[i].position;
+        uint32_t bucket = hashCell(cellCoordinate(position[0], server->cellSize), cellCoordinate(position[1], server->cellSize),
+                                   cellCoordinate(position[2], server->cellSize), mask);
+        server->bucketOf[i] = bucket;
+        start[bucket]++;
+    }
+    uint32_t sum = 0;
+    for (uint32_t b = 0; b < numBuckets; b++) {
+        sum += start[b];
+        start[b] = sum;
+    }
+    start[numBuckets] = sum;
+    for (uint32_t i = count; i-- > 0;) {
+        uint32_t slot = --start[server->bucketOf[i]];
+        server->sorted[slot] = i;
+        memcpy(server->sortedPositions[slot], entities[i].position, sizeof(float[3]));
+    }
+    return 0;
+}
+
+// Everything within the interest radius of view, from the cells the radius touches, returns how many
+static uint32_t gatherInterest(NetServer* server, const float view[3]) {
+    // A new stamp for every client, only wraps after years of ticks but starts the buckets over when it does
+    if (++server->visitStamp == 0) {
+        memset(server->bucketVisit, 0, server->numBuckets * sizeof(uint32_t));
+        server->visitStamp = 1;
+    }
+    float radius = server->interestRadius * server->interestRadius;
+    float cellSize = server->cellSize;
+    uint32_t mask = server->numBuckets - 1;
+    int lo[3], hi[3];
+    for (int k = 0; k < 3; k++) {
+        lo[k] = cellCoordinate(view[k] - server->interestRadius, cellSize);
+        hi[k] = cellCoordinate(view[k] + server->interestRadius, cellSize);
+    }
+
+    uint32_t numVisible = 0;
+    for (int x = lo[0]; x <= hi[0]; x++) {
+        for (int y = lo[1]; y <= hi[1]; y++) {
+            for (int z = lo[2]; z <= hi[2]; z++) {
+                // Nearest the cell gets to the view, cells in the corners of the range can be out of reach entirely
+                int cell[3] = {x, y, z};
+                float nearest = 0.0f;
+                for (int k = 0; k < 3; k++) {
+                    float low = cell[k] * cellSize, d = 0.0f;
+                    if (view[k] < low) d = low - view[k];
+                    else if (view[k] > low + cellSize) d = view[k] - low - cellSize;
+                    nearest += d * d;
+                }
+                if (nearest > radius) continue;
+                uint32_t bucket = hashCell(x, y, z, mask);
+                if (server->bucketVisit[bucket] == server->visitStamp) continue;
+                server->bucketVisit[bucket] = server->visitStamp;
+                for (uint32_t s = server->bucketStart[bucket]; s < server->bucketStart[bucket + 1]; s++) {
+                    const float* position = server->sortedPositions[s];
+                    float dx = position[0] - view[0];
+                    float dy = position[1] - view[1];
+                    float dz = position[2] - view[2];
+                    float distance = dx * dx + dy * dy + dz * dz;
+                    if (distance > radius) continue;
+                    server->candidates[numVisible++] = (NetCandidate){distance, server->sorted[s]};
+                }
+            }
+        }
+    }
+    return numVisible;
+}
+
+static int compareIndex(const void* a, const void* b) {
+    uint32_t ia = ((const NetCandidate*)a)->index, ib = ((const NetCandidate*)b)->index;
+    return (ia > ib) - (ia < ib);
+}
+
+// Writes the delta from base to frame, base NULL for everything, returns the packet size
+static size_t encodeSnapshot(NetServer* server, NetPeer* peer, const NetFrame* base, const NetFrame* frame) {
+    uint8_t* out = server->packet + sizeof(NetHeader);
+
+    // Mesh names it hasn't acked yet, in every packet until it does, so it has them by the time it has the base
+    uint16_t numMeshNames = 0;
+    for (uint32_t i = 0; i < frame->count; i++) {
+        uint16_t mesh = frame->states[i].mesh;
+        if (mesh != NET_NO_MESH && !peer->meshKnown[mesh] && !peer->meshPending[mesh]) peer->meshPending[mesh] = frame->tick;
+    }
+    for (uint32_t m = 0; m < server->numMeshes; m++) {
+        if (!peer->meshPending[m] || peer->meshKnown[m]) continue;
+        size_t length = strlen(server->meshNames[m]);
+        memcpy(out, &(uint16_t){(uint16_t)m}, sizeof(uint16_t));
+        out[2] = (uint8_t)length;
+        memcpy(out + 3, server->meshNames[m], length);
+        out += 3 + length;
+        numMeshNames++;
+    }
+
+    // Removed, in the base and not here any more, ids as gaps from the last one
+    uint32_t baseCount = base ? base->count : 0;
+    uint32_t numRemoved = 0;
+    for (uint32_t b = 0, i = 0; b < baseCount; b++) {
+        while (i < frame->count && frame->states[i].id < base->states[b].id) i++;
+        if (i == frame->count || frame->states[i].id != base->states[b].id) numRemoved++;
+    }
+    out = writeVarint(out, numRemoved);
+    uint32_t previous = 0;
+    for (uint32_t b = 0, i = 0; b < baseCount; b++) {
+        while (i < frame->count && frame->states[i].id < base->states[b].id) i++;
+        if (i < frame->count && frame->states[i].id == base->states[b].id) continue;
+        out = writeVarint(out, base->states[b].id - previous);
+        previous = base->states[b].id;
+    }
+
+    // Changed, the count goes in front once it's known
+    uint8_t* countAt = out;
+    out += 5;
+    uint32_t numChanged = 0;
+    previous = 0;
+    for (uint32_t i = 0, b = 0; i < frame->count; i++) {
+        const NetState* state = &frame->states[i];
+        while (b < baseCount && base->states[b].id < state->id) b++;
+        const NetState* before = b < baseCount && base->states[b].id == state->id ? &base->states[b] : NULL;
+        uint8_t mask = NET_CHANGED_ALL;
+        if (before) {
+            mask = 0;
+            if (memcmp(state->position, before->position, sizeof(state->position)) != 0) mask |= NET_CHANGED_POSITION;
+            if (state->orientation != before->orientation) mask |= NET_CHANGED_ORIENTATION;
+            if (state->color != before->color) mask |= NET_CHANGED_COLOR;
+            if (state->mesh != before->mesh || state->kind != before->kind || state->scale != before->scale) mask |= NET_CHANGED_MESH;
+            if (!mask) continue; // Nothing at all, it's not even mentioned
+        }
+        out = writeVarint(out, state->id - previous);
+        previous = state->id;
+        *out++ = mask;
+        if (mask & NET_CHANGED_POSITION) {
+            for (int k = 0; k < 3; k++) out = writeVarint(out, zigzag(state->position[k] - (before ? before->position[k] : 0)));
+        }
+        if (mask & NET_CHANGED_ORIENTATION) {
+            memcpy(out, &state->orientation, sizeof(uint32_t));
+            out += sizeof(uint32_t);
+        }
+        if (mask & NET_CHANGED_COLOR) {
+            memcpy(out, &state->color, sizeof(uint32_t));
+            out += sizeof(uint32_t);
+        }
+        if (mask & NET_CHANGED_MESH) {
+            memcpy(out, &state->mesh, sizeof(uint16_t));
+            out[2] = state->kind;
+            memcpy(out + 3, &state->scale, sizeof(float));
+            out += 3 + sizeof(float);
+        }
+        numChanged++;
+    }
+    // Always 5 bytes, so it could be written in after the records
+    for (int k = 0; k < 4; k++) countAt[k] = (uint8_t)((numChanged >> (7 * k)) | 0x80);
+    countAt[4] = (uint8_t)(numChanged >> 28);
+    server->recordsSent += numChanged;
+
+    NetHeader header = {NET_MAGIC, frame->tick, base ? base->tick : 0, server->tickRate, numMeshNames};
+    memcpy(server->packet, &header, sizeof(header));
+    return out - server->packet;
+}
+
+int netServerBroadcast(NetServer* server, uint32_t tick, const NetEntity* entities, uint32_t count) {
+    double start = preciseMs();
+    server->clients = 0;
+    server->bytesSent = 0;
+    server->recordsSent = 0;
+    server->fullSnapshots = 0;
+    if (count > server->capacity) {
+        NetState* states = (NetState*)realloc(server->states, count * sizeof(NetState));
+        if (states) server->states = states;
+        NetCandidate* candidates = (NetCandidate*)realloc(server->candidates, count * sizeof(NetCandidate));
+        if (candidates) server->candidates = candidates;
+        uint32_t* bucketOf = (uint32_t*)realloc(server->bucketOf, count * sizeof(uint32_t));
+        if (bucketOf) server->bucketOf = bucketOf;
+        uint32_t* sorted = (uint32_t*)realloc(server->sorted, count * sizeof(uint32_t));
+        if (sorted) server->sorted = sorted;
+        float (*sortedPositions)[3] = (float(*)[3])realloc(server->sortedPositions, count * sizeof(float[3]));
+        if (sortedPositions) server->sortedPositions = sortedPositions;
+        if (!states || !candidates || !bucketOf || !sorted || !sortedPositions) {
+            printf("Failed to allocate memory for network snapshot\n");
+            return -1;
+        }
+        server->capacity = count;
+    }
+
+    // Everyone gets the same quantized values, only which ones and the deltas differ
+    int anyone = 0;
+    for (int p = 0; p < NET_MAX_CLIENTS; p++) anyone |= server->peers[p].connected;
+    if (!anyone) return 0;
+    for (uint32_t i = 0; i < count; i++) quantize(&entities[i], &server->states[i]);
+    int culling = server->interestRadius > 0.0f;
+    if (culling && buildInterestGrid(server, entities, count) != 0) return -1;
+
+    // Worst case every entity and every base entity goes in, that's as many as can fit, the nearest ones win
+    size_t meshNameBytes = 0;
+    for (uint32_t m = 0; m < server->numMeshes; m++) meshNameBytes += 3 + strlen(server->meshNames[m]);
+    uint32_t limit = (uint32_t)((NET_MAX_PACKET - sizeof(NetHeader) - meshNameBytes - 10) / (NET_MAX_RECORD + NET_MAX_REMOVED));
+
+    double sending = 0.0;
+    for (int p = 0; p < NET_MAX_CLIENTS; p++) {
+        NetPeer* peer = &server->peers[p];
+        if (!peer->connected) continue;
+
+        uint32_t numVisible = 0;
+        if (culling) {
+            numVisible = gatherInterest(server, peer->view);
+        } else {
+            for (uint32_t i = 0; i < count; i++) {
+                float dx = entities[i].position[0] - peer->view[0];
+                float dy = entities[i].position[1] - peer->view[1];
+                float dz = entities[i].position[2] - peer->view[2];
+                server->candidates[numVisible++] = (NetCandidate){dx * dx + dy * dy + dz * dz, i};
+            }
+        }
+        // Only the nearest that fit get sorted, back into id order, the grid hands them over in bucket order
+        if (numVisible > limit) {
+            selectNearest(server->candidates, numVisible, limit);
+            numVisible = limit;
+        }
+        if (culling || numVisible < count) qsort(server->candidates, numVisible, sizeof(NetCandidate), compareIndex);
+
+        NetFrame* frame = &peer->history[tick % NET_HISTORY];
+        if (reserveFrame(frame, numVisible) != 0) return -1;
+        for (uint32_t i = 0; i < numVisible; i++) frame->states[i] = server->states[server->candidates[i].index];
+        frame->count = numVisible;
+        frame->tick = tick;
+
+        const NetFrame* base = NULL;
+        if (peer->ackTick && tick - peer->ackTick < NET_HISTORY && peer->history[peer->ackTick % NET_HISTORY].tick == peer->ackTick) {
+            base = &peer->history[peer->ackTick % NET_HISTORY];
+        } else {
+            server->fullSnapshots++;
+        }
+        size_t size = encodeSnapshot(server, peer, base, frame);
+
+        double sendStart = preciseMs();
+        sendto(server->socket, server->packet, size, 0, (struct sockaddr*)&peer->address, sizeof(peer->address));
+        sending += preciseMs() - sendStart;
+        server->bytesSent += size;
+        server->clients++;
+    }
+    server->totalBytes += server->bytesSent;
+    server->encodeTime = (float)(preciseMs() - start - sending);
+    return 0;
+}
+
+void netServerStop(NetServer* server) {
+    if (server->socket >= 0) close(server->socket);
+    for (int p = 0; p < NET_MAX_CLIENTS; p++) {
+        for (int t = 0; t < NET_HISTORY; t++) free(server->peers[p].history[t].states);
+    }
+    free(server->states);
+    free(server->candidates);
+    free(server->bucketStart);
+    free(server->bucketOf);
+    free(server->sorted);
+    free(server->sortedPositions);
+    free(server->bucketVisit);
+    free(server->packet);
+    memset(server, 0, sizeof(NetServer));
+    server->socket = -1;
+}
+
+static void sendMessage(NetClient* client, uint32_t type, uint32_t ackTick) {
+    NetMessage message = {NET_MAGIC, type, ackTick, {client->view[0], client->view[1], client->view[2]}};
+    send(client->socket, &message, sizeof(message), 0);
+    client->lastSent = nowMs();
+}
+
+int netClientConnect(NetClient* client, const char* host, uint16_t port) {
+    memset(client, 0, sizeof(NetClient));
+    struct sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(port)};
+    if (inet_pton(AF_INET, host, &address.sin_addr) != 1) {
+        printf("Not an IPv4 address: %s\n", host);
+        return -1;
+    }
+    client->socket = openSocket();
+    if (client->socket < 0 || connect(client->socket, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        printf("Failed to connect to %s:%u: %s\n", host, port, strerror(errno));
+        if (client->socket >= 0) close(client->socket);
+        client->socket = -1;
+        return -1;
+    }
+    sendMessage(client, NET_HELLO, 0);
+    return 0;
+}
+
+// Copying the base into a new snapshot, less whatever the packet says was removed
+typedef struct {
+    const NetFrame* base;
+    uint32_t next; // Into base
+    NetReader removed; // Ids as gaps
+    uint32_t nextRemoved, removedLeft;
+    NetFrame* frame;
+} NetMerge;
+
+// Base entities before id go straight over, unless they're removed
+static void copyBaseUntil(NetMerge* merge, uint32_t id) {
+    const NetFrame* base = merge->base;
+    while (base && merge->next < base->count && base->states[merge->next].id < id) {
+        const NetState* state = &base->states[merge->next++];
+        if (state->id == merge->nextRemoved) {
+            merge->nextRemoved = --merge->removedLeft ? merge->nextRemoved + readVarint(&merge->removed) : UINT32_MAX;
+        } else {
+            merge->frame->states[merge->frame->count++] = *state;
+        }
+    }
+}
+
+// Builds the snapshot in a packet on top of the one it was a delta against, returns 0 if it decoded, 1 if it
+// couldn't be (no base, cut short), -1 if it ran out of memory
+static int decodeSnapshot(NetClient* client, const uint8_t* packet, size_t size) {
+    NetHeader header;
+    NetReader reader = {packet, packet + size, 1};
+    readBytes(&reader, &header, sizeof(header));
+    if (!reader.ok || header.magic != NET_MAGIC || header.tick == 0) return 1;
+    if (header.tick <= client->latestTick) return 1; // Late, something newer's already here
+    const NetFrame* base = NULL;
+    if (header.baseTick) {
+        base = &client->frames[header.baseTick % NET_HISTORY];
+        if (base->tick != header.baseTick || header.tick - header.baseTick >= NET_HISTORY) return 1;
+    }
+
+    for (uint16_t n = 0; n < header.numMeshNames && reader.ok; n++) {
+        uint16_t mesh;
+        uint8_t length;
+        readBytes(&reader, &mesh, sizeof(mesh));
+        readBytes(&reader, &length, sizeof(length));
+        char name[256];
+        readBytes(&reader, name, length);
+        if (!reader.ok || mesh >= NET_MAX_MESHES || length >= NET_MESH_NAME) return 1;
+        name[length] = '\0';
+        strcpy(client->meshNames[mesh], name);
+    }
+
+    // Removed ids first, they get skipped while the base is copied over
+    uint32_t numRemoved = readVarint(&reader);
+    const uint8_t* removedAt = reader.cursor;
+    for (uint32_t r = 0; r < numRemoved && reader.ok; r++) readVarint(&reader);
+    uint32_t numChanged = readVarint(&reader);
+    uint32_t baseCount = base ? base->count : 0;
+    if (!reader.ok || numChanged > size) return 1;
+
+    NetFrame* frame = &client->frames[header.tick % NET_HISTORY];
+    if (reserveFrame(frame, baseCount + numChanged) != 0) return -1;
+    frame->tick = 0; // Not valid until it's all there
+    frame->count = 0;
+    NetMerge merge = {base, 0, {removedAt, reader.end, 1}, UINT32_MAX, numRemoved, frame};
+    if (numRemoved) merge.nextRemoved = readVarint(&merge.removed);
+
+    uint32_t id = 0;
+    for (uint32_t c = 0; c < numChanged; c++) {
+        uint32_t gap = readVarint(&reader);
+        id += gap;
+        uint8_t mask = 0;
+        readBytes(&reader, &mask, sizeof(mask));
+        if (!reader.ok || (c > 0 && gap == 0)) return 1;
+        copyBaseUntil(&merge, id);
+        NetState state = {0};
+        if (merge.next < baseCount && base->states[merge.next].id == id) {
+            state = base->states[merge.next++];
+        } else if (mask != NET_CHANGED_ALL) {
+            return 1; // A partial change to something it never had
+        }
+        state.id = id;
+        if (mask & NET_CHANGED_POSITION) {
+            for (int k = 0; k < 3; k++) state.position[k] += unzigzag(readVarint(&reader));
+        }
+        if (mask & NET_CHANGED_ORIENTATION) readBytes(&reader, &state.orientation, sizeof(uint32_t));
+        if (mask & NET_CHANGED_COLOR) readBytes(&reader, &state.color, sizeof(uint32_t));
+        if (mask & NET_CHANGED_MESH) {
+            readBytes(&reader, &state.mesh, sizeof(uint16_t));
+            readBytes(&reader, &state.kind, sizeof(uint8_t));
+            readBytes(&reader, &state.scale, sizeof(float));
+            // Goes straight into the client's mesh tables, so nothing past the end of them
+            if (state.mesh >= NET_MAX_MESHES && state.mesh != NET_NO_MESH) return 1;
+        }
+        if (!reader.ok) return 1;
+        frame->states[frame->count++] = state;
+    }
+    copyBaseUntil(&merge, UINT32_MAX);
+    if (!merge.removed.ok) return 1;
+
+    frame->tick = header.tick;
+    client->latestTick = header.tick;
+    client->tickRate = header.tickRate;
+    return 0;
+}
+
+int netClientPoll(NetClient* client) {
+    if (client->socket < 0) return 0;
+    static uint8_t packet[NET_MAX_PACKET];
+    int fresh = 0;
+    ssize_t size;
+    while ((size = recv(client->socket, packet, sizeof(packet), 0)) >= 0) {
+        client->bytesReceived += size;
+        double start = preciseMs();
+        int result = decodeSnapshot(client, packet, size);
+        if (result < 0) return -1;
+        if (result > 0) {
+            client->undecodable++;
+            continue;
+        }
+        client->decodeTime = (float)(preciseMs() - start);
+        client->snapshots++;
+        fresh++;
+    }
+    // One ack for everything that came in, for the newest, or another hello if nothing has yet
+    if (fresh) sendMessage(client, NET_ACK, client->latestTick);
+    else if (nowMs() - client->lastSent > 500) sendMessage(client, client->latestTick ? NET_ACK : NET_HELLO, client->latestTick);
+    return fresh;
+}
+
+uint32_t netClientEntities(const NetClient* client, NetEntity* entities, uint32_t capacity) {
+    if (!client->latestTick) return 0;
+    const NetFrame* frame = &client->frames[client->latestTick % NET_HISTORY];
+    for (uint32_t i = 0; i < frame->count && i < capacity; i++) {
+        const NetState* state = &frame->states[i];
+        NetEntity* entity = &entities[i];
+        entity->id = state->id;
+        for (int k = 0; k < 3; k++) entity->position[k] = state->position[k] / NET_POSITION_SCALE;
+        unpackOrientation(state->orientation, entity->orientation);
+        entity->scale = state->scale;
+        entity->color = state->color;
+        entity->mesh = state->mesh;
+        entity->kind = state->kind;
+    }
+    return frame->count;
+}
+
+void netClientClose(NetClient* client) {
+    if (client->socket >= 0) {
+        sendMessage(client, NET_BYE, client->latestTick);
+        close(client->socket);
+    }
+    for (int t = 0; t < NET_HISTORY; t++) free(client->frames[t].states);
+    memset(client, 0, sizeof(NetClient));
+    client->socket = -1;
+}
@@ -0,0 +1,145 @@
+#ifndef NET_H
+#define NET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <netinet/in.h>
+
+// Server/client snapshots over UDP, one datagram per client per tick
+// Positions are quantized to fixed point and orientations to 32 bit quaternions, then every client only gets what
+// changed since the last snapshot it acknowledged and only what's within its interest radius
+// Doesn't know about Objects, the server hands it entities and the client gets entities back
+// Both ends have to be the same build, no byte swapping, it's meant for localhost and LANs
+
+#define NET_PORT 27500
+#define NET_MAX_CLIENTS 32
+#define NET_HISTORY 64 // Ticks of snapshots each side keeps to delta against, an older ack gets a full snapshot
+#define NET_MAX_MESHES 256
+#define NET_MESH_NAME 64
+#define NET_MAX_PACKET 65000 // Fragments on a LAN, one datagram either way
+#define NET_POSITION_SCALE 16.0f // Positions go over the wire in 1/16ths
+#define NET_TIMEOUT_MS 5000 // Clients not heard from in this long get dropped
+#define NET_NO_MESH 0xFFFF
+#define NET_GRID_DIVISIONS 4 // Interest grid cells are the interest radius over this, a client looks at 9x9x9 of them
+
+typedef struct {
+    uint32_t id; // Has to stay the same for as long as the entity exists
+    float position[3];
+    float orientation[4]; // x y z w, see netOrientationFromBasis
+    float scale;
+    uint32_t color;
+    uint16_t mesh; // From netServerMesh, NET_NO_MESH for none
+    uint8_t kind; // The caller's, elite sends the object id
+} NetEntity;
+
+// An entity the way it goes over the wire, also what gets compared to find what changed
+typedef struct {
+    uint32_t id;
+    int32_t position[3];
+    uint32_t orientation; // Smallest three, 2 bits for which was left out and 10 for each of the others
+    float scale; // Hardly ever changes, so it isn't worth squeezing
+    uint32_t color;
+    uint16_t mesh;
+    uint8_t kind;
+} NetState;
+
+// One tick's worth of states, sorted by id
+typedef struct {
+    uint32_t tick; // 0 if it's empty
+    NetState* states;
+    uint32_t count, capacity;
+} NetFrame;
+
+typedef struct {
+    struct sockaddr_in address;
+    int connected;
+    uint32_t ackTick; // Newest snapshot it's said it has, 0 for none
+    float view[3]; // Where it's looking from, the center of its interest radius
+    uint64_t lastHeard; // ms
+    NetFrame history[NET_HISTORY]; // What it was sent, by tick % NET_HISTORY
+    uint32_t meshPending[NET_MAX_MESHES]; // Tick a mesh name started going out, it goes in every packet until acked
+    uint8_t meshKnown[NET_MAX_MESHES];
+} NetPeer;
+
+typedef struct {
+    float distance; // Squared, from the client's view
+    uint32_t index; // Into the entities
+} NetCandidate;
+
+typedef struct {
+    int socket;
+    float interestRadius; // 0 sends everything
+    uint16_t tickRate; // Sent along so clients interpolate at the right speed
+    NetPeer peers[NET_MAX_CLIENTS];
+    char meshNames[NET_MAX_MESHES][NET_MESH_NAME];
+    uint32_t numMeshes;
+    NetState* states; // This tick's, quantized once for every client
+    NetCandidate* candidates; // Per client scratch, what's in its interest radius
+    uint32_t capacity;
+    // Interest grid, the entities get hashed by cell once a tick and each client only goes through the cells its
+    // radius touches, the same kind of grid as the collision broad phase
+    uint32_t* bucketStart;
+    uint32_t* bucketOf;
+    uint32_t* sorted; // Entity indexes sorted by bucket
+    float (*sortedPositions)[3]; // Their positions in the same order
+    uint32_t* bucketVisit; // Stamp of the last client that went through a bucket, so hash collisions aren't done twice
+    uint32_t numBuckets, bucketCapacity, visitStamp;
+    float cellSize;
+    uint8_t* packet;
+    // Last broadcast, for the stats
+    int clients;
+    uint64_t bytesSent;
+    uint32_t recordsSent; // Changed entities written, over every client
+    uint32_t fullSnapshots; // Clients that got everything because they had no usable ack
+    float encodeTime; // ms, culling, quantizing and encoding, not the sends
+    uint64_t totalBytes;
+} NetServer;
+
+typedef struct {
+    int socket;
+    NetFrame frames[NET_HISTORY]; // Decoded snapshots by tick % NET_HISTORY
+    uint32_t latestTick; // 0 until the first one arrives
+    uint16_t tickRate;
+    char meshNames[NET_MAX_MESHES][NET_MESH_NAME]; // Empty until the server's sent that one
+    float view[3]; // Sent back with every ack, set it to the camera position
+    uint64_t lastSent; // ms, hellos get repeated until something comes back
+    // Totals
+    uint64_t bytesReceived;
+    uint32_t snapshots;
+    uint32_t undecodable; // Built on a snapshot this side never got, the next ack sorts it out
+    float decodeTime; // ms, last snapshot
+} NetClient;
+
+// Orientation of something placed the way Objects are, world = -x * forward + y * up + z * right
+void netOrientationFromBasis(const float forward[3], const float up[3], const float right[3], float orientation[4]);
+void netBasisFromOrientation(const float orientation[4], float forward[3], float up[3], float right[3]);
+
+// Binds port on every interface, returns 0 on success, -1 otherwise
+int netServerStart(NetServer* server, uint16_t port, float interestRadius, uint16_t tickRate);
+
+// Index of a mesh file for NetEntity.mesh, registered the first time, NET_NO_MESH if there are too many
+uint16_t netServerMesh(NetServer* server, const char* filename);
+
+// Takes in hellos and acks from clients and drops the ones that have gone quiet, returns how many are connected
+int netServerPoll(NetServer* server);
+
+// Sends this tick to every client, entities sorted by id, returns -1 if it ran out of memory
+// With 100k entities it's about 2 ms for the quantizing and the grid plus 0.7 ms a client on one core, so a 30 Hz
+// tick has room for about 32 clients before the encoding alone takes most of it
+int netServerBroadcast(NetServer* server, uint32_t tick, const NetEntity* entities, uint32_t count);
+
+void netServerStop(NetServer* server);
+
+// Starts saying hello to a server, host is an IPv4 address, returns 0 on success, -1 otherwise
+int netClientConnect(NetClient* client, const char* host, uint16_t port);
+
+// Decodes whatever's arrived and acks it, returns how many new snapshots there were, -1 if it ran out of memory
+int netClientPoll(NetClient* client);
+
+// The newest snapshot, up to capacity entities sorted by id, returns how many there are in total
+uint32_t netClientEntities(const NetClient* client, NetEntity* entities, uint32_t capacity);
+
+// Says goodbye so the server stops sending straight away
+void netClientClose(NetClient* client);
+
+#endif // NET_H
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <emmintrin.h>
+#include "particles.h"
+
+int particlesInit(ParticlePool* pool, size_t capacity) {
+    memset(pool, 0, sizeof(ParticlePool));
+    capacity = (capacity + 3) & ~(size_t)3;
+    // 8 float arrays and the colors, each one 16-byte aligned since capacity is a multiple of 4
+    size_t arraySize = capacity * sizeof(float);
+    pool->block = aligned_alloc(16, arraySize * 9);
+    if (!pool->block) {
+        printf("Failed to allocate memory for particles\n");
+        return -1;
+    }
+    // Zeroed so the padding lanes past count are always valid floats
+    memset(pool->block, 0, arraySize * 9);
+    float* arrays = (float*)pool->block;
+    pool->posX = arrays;
+    pool->posY = arrays + capacity;
+    pool->posZ = arrays + capacity * 2;
+    pool->velX = arrays + capacity * 3;
+    pool->velY = arrays + capacity * 4;
+    pool->velZ = arrays + capacity * 5;
+    pool->age = arrays + capacity * 6;
+    pool->life = arrays + capacity * 7;
+    pool->color = (uint32_t*)(arrays + capacity * 8);
+    pool->capacity = capacity;
+    return 0;
+}
+
+void particlesFree(ParticlePool* pool) {
+    free(pool->block);
+    memset(pool, 0, sizeof(ParticlePool));
+}
+
+size_t particlesEmit(ParticlePool* pool, const float position[3], const float velocity[3], float spread, float life,
+                     uint32_t color, size_t count, Rng* rng) {
+    size_t room = pool->capacity - pool->count;
+    if (count > room) {
+        pool->dropped += count - room;
+        count = room;
+    }
+    for (size_t n = 0; n < count; n++) {
+        size_t i = pool->count++;
+        pool->posX[i] = position[0];
+        pool->posY[i] = position[1];
+        pool->posZ[i] = position[2];
+        // Random direction in a cube is close enough for sparks
+        pool->velX[i] = velocity[0] + rngRange(rng, -spread, spread);
+        pool->velY[i] = velocity[1] + rngRange(rng, -spread, spread);
+        pool->velZ[i] = velocity[2] + rngRange(rng, -spread, spread);
+        pool->age[i] = 0.0f;
+        pool->life[i] = life * rngRange(rng, 0.75f, 1.25f);
+        pool->color[i] = color;
+    }
+    pool->emitted += count;
+    return count;
+}
+
+// Moves the last particle into slot i
+static inline void removeParticle(ParticlePool* pool, size_t i) {
+    size_t last = --pool->count;
+    pool->posX[i] = pool->posX[last];
+    pool->posY[i] = pool->posY[last];
+    pool->posZ[i] = pool->posZ[last];
+    pool->velX[i] = pool->velX[last];
+    pool->velY[i] = pool->velY[last];
+    pool->velZ[i] = pool->velZ[last];
+    pool->age[i] = pool->age[last];
+    pool->life[i] = pool->life[last];
+    pool->color[i] = pool->color[last];
+}
+
+void particlesUpdate(ParticlePool* pool, float seconds, float drag) {
+    __m128 dt = _mm_set1_ps(seconds);
+    __m128 damping = _mm_set1_ps(powf(drag, seconds));
+    // Goes over the padding past count too, it's cheaper than a scalar tail and those lanes are never read
+    size_t end = (pool->count + 3) & ~(size_t)3;
+    // Padding lanes always look dead, so they're left out of the last group or the compaction would run every time
+    uint32_t tailMask = (pool->count & 3) ? (1u << (pool->count & 3)) - 1 : 0xF;
+    uint32_t anyDead = 0;
+    for (size_t i = 0; i < end; i += 4) {
+        __m128 vx = _mm_mul_ps(_mm_load_ps(pool->velX + i), damping);
+        __m128 vy = _mm_mul_ps(_mm_load_ps(pool->velY + i), damping);
+        __m128 vz = _mm_mul_ps(_mm_load_ps(pool->velZ + i), damping);
+        _mm_store_ps(pool->velX + i, vx);
+        _mm_store_ps(pool->velY + i, vy);
+        _mm_store_ps(pool->velZ + i, vz);
+        _mm_store_ps(pool->posX + i, _mm_add_ps(_mm_load_ps(pool->posX + i), _mm_mul_ps(vx, dt)));
+        _mm_store_ps(pool->posY + i, _mm_add_ps(_mm_load_ps(pool->posY + i), _mm_mul_ps(vy, dt)));
+        _mm_store_ps(pool->posZ + i, _mm_add_ps(_mm_load_ps(pool->posZ + i), _mm_mul_ps(vz, dt)));
+        __m128 age = _mm_add_ps(_mm_load_ps(pool->age + i), dt);
+        _mm_store_ps(pool->age + i, age);
+        uint32_t dead = _mm_movemask_ps(_mm_cmpge_ps(age, _mm_load_ps(pool->life + i)));
+        if (i + 4 > pool->count) dead &= tailMask;
+        anyDead |= dead;
+    }
+    if (!anyDead) return;
+    
+    // Compact, a group of four with nothing dead in it gets skipped with one compare
+    size_t i = 0;
+    while (i < pool->count) {
+        if ((i & 3) == 0 && i + 4 <= pool->count &&
+            !_mm_movemask_ps(_mm_cmpge_ps(_mm_load_ps(pool->age + i), _mm_load_ps(pool->life + i)))) {
+            i += 4;
+            continue;
+        }
+        // What gets moved in might be dead as well, so look at the same slot again
+        if (pool->age[i] >= pool->life[i]) removeParticle(pool, i);
+        else i++;
+    }
+}
+
+static inline uint32_t fadeColor(uint32_t color, float brightness) {
+    uint32_t scale = (uint32_t)(brightness * 256.0f);
+    uint32_t r = (((color >> 16) & 0xFF) * scale) >> 8;
+    uint32_t g = (((color >> 8) & 0xFF) * scale) >> 8;
+    uint32_t b = ((color & 0xFF) * scale) >> 8;
+    return (r << 16) | (g << 8) | b;
+}
+
+size_t particlesSplat(const ParticlePool* pool, const ParticleCamera* camera, uint32_t* frame) {
+    __m128 cameraX = _mm_set1_ps(camera->position[0]);
+    __m128 cameraY = _mm_set1_ps(camera->position[1]);
+    __m128 cameraZ = _mm_set1_ps(camera->position[2]);
+    __m128 rightX = _mm_set1_ps(camera->right[0]), rightY = _mm_set1_ps(camera->right[1]), rightZ = _mm_set1_ps(camera->right[2]);
+    __m128 upX = _mm_set1_ps(camera->up[0]), upY = _mm_set1_ps(camera->up[1]), upZ = _mm_set1_ps(camera->up[2]);
+    __m128 forwardX = _mm_set1_ps(camera->forward[0]), forwardY = _mm_set1_ps(camera->forward[1]), forwardZ = _mm_set1_ps(camera->forward[2]);
+    __m128 focal = _mm_set1_ps(camera->focal);
+    __m128 halfWidth = _mm_set1_ps(camera->width / 2.0f), halfHeight = _mm_set1_ps(camera->height / 2.0f);
+    __m128 nearZ = _mm_set1_ps(1.0f);
+    
+    size_t drawn = 0;
+    for (size_t i = 0; i < pool->count; i += 4) {
+        // Camera space, same dot products projectVertex does but for four at once
+        __m128 dx = _mm_sub_ps(_mm_load_ps(pool->posX + i), cameraX);
+        __m128 dy = _mm_sub_ps(_mm_load_ps(pool->posY + i), cameraY);
+        __m128 dz = _mm_sub_ps(_mm_load_ps(pool->posZ + i), cameraZ);
+        __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, rightX), _mm_mul_ps(dy, rightY)), _mm_mul_ps(dz, rightZ));
+        __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, upX), _mm_mul_ps(dy, upY)), _mm_mul_ps(dz, upZ));
+        __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, forwardX), _mm_mul_ps(dy, forwardY)), _mm_mul_ps(dz, forwardZ));
+        int inFront = _mm_movemask_ps(_mm_cmpgt_ps(z, nearZ));
+        if (!inFront) continue;
+        
+        __m128 scale = _mm_div_ps(focal, z);
+        __m128i screenX = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, scale), halfWidth));
+        __m128i screenY = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(y, scale), halfHeight));
+        int xs[4], ys[4];
+        _mm_storeu_si128((__m128i*)xs, screenX);
+        _mm_storeu_si128((__m128i*)ys, screenY);
+        
+        for (int lane = 0; lane < 4; lane++) {
+            size_t p = i + lane;
+            if (p >= pool->count || !(inFront & (1 << lane))) continue;
+            if (xs[lane] < 0 || xs[lane] >= camera->width || ys[lane] < 0 || ys[lane] >= camera->height) continue;
+            uint32_t* pixel = &frame[(size_t)ys[lane] * camera->width + xs[lane]];
+            uint32_t color = fadeColor(pool->color[p], 1.0f - pool->age[p] / pool->life[p]);
+            // Additive, each channel saturates at 255 instead of wrapping
+            __m128i sum = _mm_adds_epu8(_mm_cvtsi32_si128((int)*pixel), _mm_cvtsi32_si128((int)color));
+            *pixel = (uint32_t)_mm_cvtsi128_si32(sum);
+            drawn++;
+        }
+    }
+    return drawn;
+}
@@ -0,0 +1,47 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "rng.h"
+
+// Fixed size particle pool for engine trails and explosions, allocated once up front so emitting never mallocs
+// Kept as separate arrays so integrating and projecting go four particles at a time in SSE, dead particles
+// get the last live one moved into their slot so the live ones always stay packed at the front
+// Doesn't know about Objects, the caller says where to emit
+
+typedef struct {
+    size_t count, capacity; // capacity is a multiple of 4
+    float *posX, *posY, *posZ;
+    float *velX, *velY, *velZ; // Per second
+    float *age, *life; // Seconds, it's dead once age reaches life
+    uint32_t* color; // 0x00RRGGBB at full brightness, fades out with age
+    void* block; // All of the above in one allocation
+    uint64_t emitted, dropped; // Totals, dropped didn't fit
+} ParticlePool;
+
+// Where particles get drawn from, same camera model as the renderer
+typedef struct {
+    float position[3];
+    float right[3], up[3], forward[3];
+    float focal; // Pixels
+    int width, height; // Of the framebuffer
+} ParticleCamera;
+
+// Returns 0 on success, -1 if the memory couldn't be allocated
+int particlesInit(ParticlePool* pool, size_t capacity);
+void particlesFree(ParticlePool* pool);
+
+// Adds count particles at position, moving at velocity plus up to spread in a random direction, living for
+// life seconds give or take a quarter, returns how many fit
+size_t particlesEmit(ParticlePool* pool, const float position[3], const float velocity[3], float spread, float life,
+                     uint32_t color, size_t count, Rng* rng);
+
+// Moves everything on, drag is how much velocity is left after a second, then drops the dead ones
+void particlesUpdate(ParticlePool* pool, float seconds, float drag);
+
+// Adds every particle in front of the camera onto a 0x00RRGGBB frame, one pixel each, saturating per channel
+// Returns how many landed on screen
+size_t particlesSplat(const ParticlePool* pool, const ParticleCamera* camera, uint32_t* frame);
+
+#endif // PARTICLES_H
@@ -1,6 +1,7 @@
 #include <SDL2/SDL.h>
 #include <pthread.h>
 #include "pause_menu.h"
+#include "font.h"
 
 // Initialize the global settings
 Settings settings = {
@@ -10,193 +11,169 @@ Settings settings = {
     .bumpscosity.min_value = 0
 };
 
-// 5x7 pixel font for each letter in byte notation
-unsigned char font[36][7] = {
-    {0b01110, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001},  // 'A'
-    {0b11110, 0b10001, 0b10001, 0b11110, 0b10001, 0b10001, 0b11110},  // 'B'
-    {0b01110, 0b10001, 0b10000, 0b10000, 0b10000, 0b10001, 0b01110},  // 'C'
-    {0b11110, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b11110},  // 'D'
-    {0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b11111},  // 'E'
-    {0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b10000},  // 'F'
-    {0b01110, 0b10001, 0b10000, 0b10111, 0b10001, 0b10001, 0b01110},  // 'G'
-    {0b10001, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001},  // 'H'
-    {0b01110, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110},  // 'I'
-    {0b00111, 0b00010, 0b00010, 0b00010, 0b00010, 0b10010, 0b01100},  // 'J'
-    {0b10001, 0b10010, 0b10100, 0b11000, 0b10100, 0b10010, 0b10001},  // 'K'
-    {0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b11111},  // 'L'
-    {0b10001, 0b11011, 0b10101, 0b10101, 0b10001, 0b10001, 0b10001},  // 'M'
-    {0b10001, 0b10001, 0b11001, 0b10101, 0b10011, 0b10001, 0b10001},  // 'N'
-    {0b01110, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110},  // 'O'
-    {0b11110, 0b10001, 0b10001, 0b11110, 0b10000, 0b10000, 0b10000},  // 'P'
-    {0b01110, 0b10001, 0b10001, 0b10001, 0b10101, 0b10010, 0b01101},  // 'Q'
-    {0b11110, 0b10001, 0b10001, 0b11110, 0b10100, 0b10010, 0b10001},  // 'R'
-    {0b01111, 0b10000, 0b10000, 0b01110, 0b00001, 0b00001, 0b11110},  // 'S'
-    {0b11111, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100},  // 'T'
-    {0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110},  // 'U'
-    {0b10001, 0b10001, 0b10001, 0b10001, 0b01010, 0b01010, 0b00100},  // 'V'
-    {0b10001, 0b10001, 0b10001, 0b10101, 0b10101, 0b11011, 0b10001},  // 'W'
-    {0b10001, 0b10001, 0b01010, 0b00100, 0b01010, 0b10001, 0b10001},  // 'X'
-    {0b10001, 0b10001, 0b01010, 0b00100, 0b00100, 0b00100, 0b00100},  // 'Y'
-    {0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b10000, 0b11111},  // 'Z'
-    {0b01110, 0b10001, 0b10011, 0b10101, 0b11001, 0b10001, 0b01110},  // '0'
-    {0b00100, 0b01100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110},  // '1'
-    {0b01110, 0b10001, 0b00001, 0b00010, 0b00100, 0b01000, 0b11111},  // '2'
-    {0b11111, 0b00010, 0b00100, 0b00010, 0b00001, 0b10001, 0b01110},  // '3'
-    {0b00010, 0b00110, 0b01010, 0b10010, 0b11111, 0b00010, 0b00010},  // '4'
-    {0b11111, 0b10000, 0b11110, 0b00001, 0b00001, 0b10001, 0b01110},  // '5'
-    {0b00110, 0b01000, 0b10000, 0b11110, 0b10001, 0b10001, 0b01110},  // '6'
-    {0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b01000, 0b01000},  // '7'
-    {0b01110, 0b10001, 0b10001, 0b01110, 0b10001, 0b10001, 0b01110},  // '8'
-    {0b01110, 0b10001, 0b10001, 0b01111, 0b00001, 0b00010, 0b01100}   // '9'
-};
+// Layout, y is from the bottom like the pixel buffer
+#define BOX_WIDTH 800
+#define BOX_HEIGHT 1000
+#define BOX_X ((SCREEN_WIDTH - BOX_WIDTH) / 2)
+#define BOX_Y ((SCREEN_HEIGHT - BOX_HEIGHT) / 2)
+#define SLIDER_X (BOX_X + BOX_WIDTH / 2)
+#define SLIDER_Y (BOX_Y + BOX_HEIGHT - 100 - FONT_HEIGHT * TEXT_SCALE)
+#define SLIDER_WIDTH (BOX_WIDTH - BOX_WIDTH / 2 - 20)
+#define SLIDER_HEIGHT 20
+#define HANDLE_WIDTH 10
+#define VALUE_CHARS 5 // Room left of the slider for the value, it's cleared with the slider
+
+#define BLACK 0x000000
+#define BOX_COLOR 0x323232
+#define TEXT_COLOR 0xFFFFFF
+#define TRACK_COLOR 0x969696
+#define HANDLE_COLOR 0xC8C8C8
+#define HANDLE_HOT_COLOR 0xFFFFFF // Under the mouse or being dragged
+
+// Both sizes of text sit on the box, so they're coloured in once and copied in by the row
+static FontAtlas title_font, label_font;
+static int fonts_ready = 0;
+
+static int hovered = 0; // Mouse over the slider, from the events
+
+// What the buffer shows right now
+static struct {
+    int drawn; // 0 when the whole menu needs drawing
+    int value;
+    int hot;
+} shown;
+
+// Function to draw a filled rectangle (for backgrounds, etc.), clipped to the screen once instead of every pixel
+static void fill_rect(uint32_t* pixels, int x, int y, int width, int height, uint32_t color) {
+    int x0 = x < 0 ? 0 : x, x1 = x + width > SCREEN_WIDTH ? SCREEN_WIDTH : x + width;
+    int y0 = y < 0 ? 0 : y, y1 = y + height > SCREEN_HEIGHT ? SCREEN_HEIGHT : y + height;
+    for (int row = y0; row < y1; row++) {
+        uint32_t* line = pixels + (size_t)row * SCREEN_WIDTH;
+        for (int i = x0; i < x1; i++) line[i] = color;
+    }
+}
 
-// Function to set a pixel color in the buffer
-static void set_pixel(unsigned char* pixels, int x, int y, unsigned char r, unsigned char g, unsigned char b) {
-    if (x < 0 || x >= SCREEN_WIDTH || y < 0 || y >= SCREEN_HEIGHT) return;
-    int index = (y * SCREEN_WIDTH + x) * 3;
-    pixels[index] = r;
-    pixels[index + 1] = g;
-    pixels[index + 2] = b;
+static int slider_value_at(int mx, const Setting* setting) {
+    int value = setting->min_value + ((mx - SLIDER_X) * (setting->max_value - setting->min_value)) / (SLIDER_WIDTH - HANDLE_WIDTH);
+    if (value < setting->min_value) value = setting->min_value;
+    if (value > setting->max_value) value = setting->max_value;
+    return value;
 }
 
-// Function to draw a filled rectangle (for backgrounds, etc.)
-static void draw_rect(unsigned char* pixels, int x, int y, int width, int height, unsigned char r, unsigned char g, unsigned char b) {
-    for (int j = 0; j < height; j++) {
-        for (int i = 0; i < width; i++) {
-            set_pixel(pixels, x + i, y + j, r, g, b);
-        }
+void pause_menu_event(const SDL_Event* event) {
+    Setting* setting = &settings.bumpscosity;
+    int mx, my;
+    if (event->type == SDL_MOUSEBUTTONDOWN || event->type == SDL_MOUSEBUTTONUP) {
+        mx = event->button.x;
+        my = event->button.y;
+    } else if (event->type == SDL_MOUSEMOTION) {
+        mx = event->motion.x;
+        my = event->motion.y;
+    } else {
+        return;
+    }
+    int flipped_y = SCREEN_HEIGHT - my; // Only needed if OpenGL has Y flipped
+    // Check if mouse is anywhere on the slider bar
+    hovered = mx >= SLIDER_X && mx <= SLIDER_X + SLIDER_WIDTH && flipped_y >= SLIDER_Y && flipped_y <= SLIDER_Y + SLIDER_HEIGHT;
+
+    if (event->type == SDL_MOUSEBUTTONDOWN && hovered) {
+        setting->is_dragging = 1;
+        // Instantly move slider to mouse position when clicked
+        setting->value = slider_value_at(mx, setting);
+    }
+    else if (event->type == SDL_MOUSEBUTTONUP) {
+        setting->is_dragging = 0; // Stop dragging
+    }
+    else if (event->type == SDL_MOUSEMOTION && setting->is_dragging) {
+        // Update slider position based on mouse movement
+        setting->value = slider_value_at(mx, setting);
     }
 }
 
-void draw_slider(unsigned char* pixels, int x, int y, int width, int height, SDL_Event* event, Setting* setting) {
-    const int handle_width = 10;  // Width of slider handle
-
-    // Draw slider track (a horizontal bar)
-    draw_rect(pixels, x, y + height / 2 - 2, width, 4, 150, 150, 150); // Light gray track
-
-    // Calculate handle position based on setting->value
-    int handle_x = x + ((setting->value - setting->min_value) * (width - handle_width)) / (setting->max_value - setting->min_value);
-    draw_rect(pixels, handle_x, y, handle_width, height, 200, 200, 200); // White handle
-
-    // Handle mouse input
-    if (event) {
-        int mx, my;
-        SDL_GetMouseState(&mx, &my);
-
-        if (event->type == SDL_MOUSEBUTTONDOWN) {
-            int flipped_y = SCREEN_HEIGHT - my; // Only needed if OpenGL has Y flipped
-            // Check if mouse is anywhere on the slider bar
-            if (mx >= x && mx <= x + width && flipped_y >= y && flipped_y <= y + height) {
-                setting->is_dragging = 1;
-                
-                // Instantly move slider to mouse position when clicked
-                setting->value = setting->min_value + ((mx - x) * (setting->max_value - setting->min_value)) / (width - handle_width);
-            }
-        }
-        else if (event->type == SDL_MOUSEBUTTONUP) {
-            setting->is_dragging = 0; // Stop dragging
-        }
-        else if (event->type == SDL_MOUSEMOTION && setting->is_dragging) {
-            // Update slider position based on mouse movement
-            setting->value = setting->min_value + ((mx - x) * (setting->max_value - setting->min_value)) / (width - handle_width);
-
-            // Clamp value
-            if (setting->value < setting->min_value) setting->value = setting->min_value;
-            if (setting->value > setting->max_value) setting->value = setting->max_value;
-        }
+static int init_fonts(void) {
+    if (fontAtlasInit(&title_font, TEXT_SCALE) != 0 || fontAtlasColor(&title_font, TEXT_COLOR, BOX_COLOR) != 0 ||
+        fontAtlasInit(&label_font, TEXT_SCALE / 2) != 0 || fontAtlasColor(&label_font, TEXT_COLOR, BOX_COLOR) != 0) {
+        fontAtlasFree(&title_font);
+        fontAtlasFree(&label_font);
+        return -1;
     }
+    fonts_ready = 1;
+    return 0;
 }
 
-// Function to draw a scaled character with variable scaling
-static void draw_char(unsigned char* pixels, int x, int y, unsigned char c, int scale, unsigned char r, unsigned char g, unsigned char b) {
-    if (((c < 'A' || c > 'Z') && (c < '0' || c > '9')) || scale < 1) return; // Only support uppercase letters and numbers
+// Everything on the slider's line that changes, the value, the track and the handle
+static void slider_rect(DirtyRect* rect) {
+    rect->x = SLIDER_X - 10 - VALUE_CHARS * label_font.advance;
+    rect->y = SLIDER_Y;
+    rect->width = SLIDER_X + SLIDER_WIDTH - rect->x;
+    rect->height = label_font.glyphHeight > SLIDER_HEIGHT ? label_font.glyphHeight : SLIDER_HEIGHT;
+}
 
-    unsigned char* char_map;
-    
-    if (c >= 'A' && c <= 'Z') {
-        char_map = font[c - 'A']; // Get letter map
-    } else {
-        char_map = font[c - '0' + 26]; // Get number map (assuming numbers start at index 26)
-    }
+static void draw_slider(uint32_t* pixels, const Setting* setting, int hot) {
+    DirtyRect rect;
+    slider_rect(&rect);
+    fill_rect(pixels, rect.x, rect.y, rect.width, rect.height, BOX_COLOR);
 
-    // Scale the character dynamically
-    for (int j = 0; j < 7; j++) {
-        for (int i = 0; i < 5; i++) {
-            if (char_map[6 - j] & (1 << (4 - i))) {  // Reverse row order to fix upside-down issue
-                // Scale each pixel by the factor (scaling to a `scale x scale` block)
-                for (int dy = 0; dy < scale; dy++) {
-                    for (int dx = 0; dx < scale; dx++) {
-                        set_pixel(pixels, x + i * scale + dx, y + j * scale + dy, r, g, b);
-                    }
-                }
-            }
-        }
-    }
+    // Slider value text, right aligned against the slider
+    char value_text[16];
+    int num_value_chars = snprintf(value_text, sizeof(value_text), "%i", setting->value);
+    fontBlitText(&label_font, pixels, SCREEN_WIDTH, SCREEN_HEIGHT, SLIDER_X - num_value_chars * label_font.advance - 10,
+                 SLIDER_Y, value_text);
+
+    // Draw slider track (a horizontal bar)
+    fill_rect(pixels, SLIDER_X, SLIDER_Y + SLIDER_HEIGHT / 2 - 2, SLIDER_WIDTH, 4, TRACK_COLOR);
+
+    // Calculate handle position based on setting->value
+    int handle_x = SLIDER_X + ((setting->value - setting->min_value) * (SLIDER_WIDTH - HANDLE_WIDTH)) / (setting->max_value - setting->min_value);
+    fill_rect(pixels, handle_x, SLIDER_Y, HANDLE_WIDTH, SLIDER_HEIGHT, hot ? HANDLE_HOT_COLOR : HANDLE_COLOR);
 }
 
 // Function to draw the pause menu
-void draw_pause_menu(unsigned char* pixels, SDL_Event* event) {
-    // Clear screen with a dark overlay
-    draw_rect(pixels, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, 0, 0, 0); // Black background
-
-    // Draw a semi-transparent rectangle in the center (Pause Menu Box)
-    int box_width = 800, box_height = 1000;
-    int box_x = (SCREEN_WIDTH - box_width) / 2;
-    int box_y = (SCREEN_HEIGHT - box_height) / 2;
-    draw_rect(pixels, box_x, box_y, box_width, box_height, 50, 50, 50); // Dark gray box
-
-    // Define text and calculate width dynamically
-    char* text = (char*)malloc(sizeof("PAUSED") * sizeof(char));
-    strcpy(text, "PAUSED");
-    int num_chars = strlen(text); // Exclude null terminator
-
-    int char_width = 5 * TEXT_SCALE;  // Each character is 5 pixels wide, scaled
-    int char_height = 7 * TEXT_SCALE; // Each character is 7 pixels tall, scaled
-    int spacing = TEXT_SCALE;         // Space between characters (scaled)
-
-    int text_width = num_chars * (char_width + spacing) - spacing; // Total width of the text
-    int text_height = char_height; // Text height is just one row of characters
-
-    // Calculate centered position
-    int text_x = box_x + (box_width - text_width) / 2;
-    int text_y = box_y + box_height - text_height - 20;
-
-    // Draw the text
-    for (int i = 0; i < num_chars; i++) {
-        draw_char(pixels, text_x + i * (char_width + spacing), text_y, text[i], TEXT_SCALE, 255, 255, 255); // White text
-    }
-    
-	// Draw the volume slider
-    int slider_x = box_x + box_width/2;
-    int slider_y = box_y + box_height - 100 - char_height;
-    int slider_width = box_width - box_width/2 - 20;
-    int slider_height = 20;
-    
-    char value_text[10]; // Buffer to hold the slider value text
-    snprintf(value_text, sizeof(value_text), "%i", settings.bumpscosity.value); // Convert float to string (1 decimal place)
-
-    int num_value_chars = strlen(value_text);
-
-    // Draw the slider value text
-    for (int i = 0; i < num_value_chars; i++) {
-        draw_char(pixels, slider_x - (num_value_chars - i) * (char_width / 2 + spacing / 2) - 10, slider_y, 
-                  value_text[i], TEXT_SCALE / 2, 255, 255, 255); // White text
-    }
-
-    // Define text and calculate width dynamically
-    text = (char*)realloc(text, sizeof("BUMPSCOSITY") * sizeof(char));
-    strcpy(text, "BUMPSCOSITY");
-    num_chars = strlen(text); // Exclude null terminator
-    // Draw the text
-    for (int i = 0; i < num_chars; i++) {
-        draw_char(pixels, box_x + 20 + i * (char_width/2 + spacing/2) - spacing, slider_y , text[i], TEXT_SCALE/2, 255, 255, 255); // White text
+int draw_pause_menu(unsigned char* pixels, DirtyRect* dirty) {
+    uint32_t* frame = (uint32_t*)pixels;
+    if (!fonts_ready && init_fonts() != 0) return 0;
+
+    const Setting* setting = &settings.bumpscosity;
+    int hot = hovered || setting->is_dragging;
+    if (shown.drawn && shown.value == setting->value && shown.hot == hot) return 0; // Nothing to do, it's all still there
+
+    if (!shown.drawn) {
+        // Clear screen with a dark overlay, then the box in the middle
+        fill_rect(frame, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BLACK);
+        fill_rect(frame, BOX_X, BOX_Y, BOX_WIDTH, BOX_HEIGHT, BOX_COLOR);
+
+        // Centered at the top of the box
+        int text_width = (int)strlen("PAUSED") * title_font.advance - title_font.scale;
+        fontBlitText(&title_font, frame, SCREEN_WIDTH, SCREEN_HEIGHT, BOX_X + (BOX_WIDTH - text_width) / 2,
+                     BOX_Y + BOX_HEIGHT - title_font.glyphHeight - 20, "PAUSED");
+        fontBlitText(&label_font, frame, SCREEN_WIDTH, SCREEN_HEIGHT, BOX_X + 20 - TEXT_SCALE, SLIDER_Y, "BUMPSCOSITY");
+
+        dirty->x = dirty->y = 0;
+        dirty->width = SCREEN_WIDTH;
+        dirty->height = SCREEN_HEIGHT;
+    } else {
+        slider_rect(dirty);
     }
-    
-	draw_slider(pixels, slider_x, slider_y, slider_width, slider_height, event, &settings.bumpscosity);
+	draw_slider(frame, setting, hot);
 
 	//int crashing = 1;
     //crash(crashing);
-    free(text);
+
+    shown.drawn = 1;
+    shown.value = setting->value;
+    shown.hot = hot;
+    return 1;
+}
+
+void pause_menu_invalidate(void) {
+    shown.drawn = 0;
+}
+
+void free_pause_menu(void) {
+    fontAtlasFree(&title_font);
+    fontAtlasFree(&label_font);
+    fonts_ready = 0;
+    shown.drawn = 0;
 }
 
 /*void crash(int crashing) {
@@ -9,6 +9,7 @@
 #define SCREEN_HEIGHT 1400
 #define WINDOW_WIDTH 2200
 #define WINDOW_HEIGHT 1400
+#define BYTES_PER_PIXEL 4 // Framebuffers are BGRA, a pixel is 0x00RRGGBB as a uint32_t
 
 #define TEXT_SCALE 6
 
@@ -25,8 +26,21 @@ typedef struct {
 
 extern Settings settings;  // Declare the global settings
 
-// Function to draw the pause menu onto the pixel buffer
-void draw_pause_menu(unsigned char* pixelsm, SDL_Event* event);
+typedef struct {
+    int x, y, width, height;
+} DirtyRect;
+
+// Mouse input for the menu, call it with every event while paused
+void pause_menu_event(const SDL_Event* event);
+
+// Draws the pause menu onto the pixel buffer, only what changed since the last call, the buffer has to be left alone
+// in between. Returns 1 and the rectangle it drew over, or 0 if the buffer already shows the menu as it is
+int draw_pause_menu(unsigned char* pixels, DirtyRect* dirty);
+
+// Something else drew into the buffer, the next draw_pause_menu draws all of it
+void pause_menu_invalidate(void);
+
+void free_pause_menu(void);
 
 // The funny function
 void crash();
@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "present.h"
+
+const char* presentModeName(PresentMode mode) {
+    return mode == PRESENT_TEXTURE ? "texture" : "drawpixels";
+}
+
+int presentInit(Presenter* presenter, PresentMode mode, int maxWidth, int maxHeight) {
+    memset(presenter, 0, sizeof(Presenter));
+    presenter->maxWidth = maxWidth;
+    presenter->maxHeight = maxHeight;
+    presenter->mode = PRESENT_DRAW_PIXELS;
+    
+    if (mode == PRESENT_TEXTURE && !GLEW_VERSION_2_1 && !GLEW_ARB_pixel_buffer_object) {
+        printf("No pixel buffer objects, presenting with glDrawPixels\n");
+        return 0;
+    }
+    if (mode != PRESENT_TEXTURE) return 0;
+    
+    glGenTextures(1, &presenter->texture);
+    glBindTexture(GL_TEXTURE_2D, presenter->texture);
+    // Nearest, so upscaling looks the same as glPixelZoom did
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, maxWidth, maxHeight, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    glGenBuffers(2, presenter->buffers);
+    for (int i = 0; i < 2; i++) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, presenter->buffers[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)maxWidth * maxHeight * 4, NULL, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        printf("Failed to set up texture presenting (GL error 0x%x), presenting with glDrawPixels\n", error);
+        presentFree(presenter);
+        presenter->mode = PRESENT_DRAW_PIXELS;
+        presenter->maxWidth = maxWidth;
+        presenter->maxHeight = maxHeight;
+        return 0;
+    }
+    presenter->mode = PRESENT_TEXTURE;
+    return 0;
+}
+
+static void drawPixelsFrame(const unsigned char* pixels, int width, int height, int windowWidth, int windowHeight) {
+    // Enable pixel zoom to scale the image to fit the window, whatever size it was rendered at
+    glPixelZoom((float)windowWidth / (float)width, (float)windowHeight / (float)height);
+    
+    // Set the raster position to the lower-left corner
+    glRasterPos2i(0, 0);
+    glDrawPixels(width, height, GL_BGRA, GL_UNSIGNED_BYTE, pixels);
+}
+
+static void drawTexture(const Presenter* presenter, int windowWidth, int windowHeight) {
+    // Only the width x height corner of the texture has this frame in it
+    float u = (float)presenter->width / presenter->maxWidth;
+    float v = (float)presenter->height / presenter->maxHeight;
+    glBindTexture(GL_TEXTURE_2D, presenter->texture);
+    glEnable(GL_TEXTURE_2D);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0f, 0.0f); glVertex2i(0, 0);
+    glTexCoord2f(u, 0.0f); glVertex2i(windowWidth, 0);
+    glTexCoord2f(u, v); glVertex2i(windowWidth, windowHeight);
+    glTexCoord2f(0.0f, v); glVertex2i(0, windowHeight);
+    glEnd();
+    glDisable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+static void textureFrame(Presenter* presenter, const unsigned char* pixels, int width, int height, int windowWidth, int windowHeight) {
+    size_t size = (size_t)width * height * 4;
+    
+    // Orphan the buffer first, the driver hands back fresh memory instead of waiting on whatever upload still
+    // reads from it, and with two of them going round the last frame's upload is never in the way either
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, presenter->buffers[presenter->next]);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)presenter->maxWidth * presenter->maxHeight * 4, NULL, GL_STREAM_DRAW);
+    void* mapped = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    if (!mapped) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        presenter->width = presenter->height = 0; // Whatever's in the texture is stale now
+        drawPixelsFrame(pixels, width, height, windowWidth, windowHeight);
+        return;
+    }
+    memcpy(mapped, pixels, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    
+    // Reads from the bound buffer, not client memory
+    glBindTexture(GL_TEXTURE_2D, presenter->texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    presenter->next ^= 1;
+    presenter->width = width;
+    presenter->height = height;
+    drawTexture(presenter, windowWidth, windowHeight);
+}
+
+// Puts the window sized ortho projection in place, both paths draw in window pixels
+static void setupWindow(int windowWidth, int windowHeight) {
+    glViewport(0, 0, windowWidth, windowHeight);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, windowWidth, 0, windowHeight, -10, 10);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+void presentFrame(Presenter* presenter, const unsigned char* pixels, int width, int height, int windowWidth, int windowHeight) {
+    // Set up an orthographic projection that matches the window size
+    setupWindow(windowWidth, windowHeight);
+    
+    if (presenter->mode == PRESENT_TEXTURE) {
+        textureFrame(presenter, pixels, width, height, windowWidth, windowHeight);
+    } else {
+        drawPixelsFrame(pixels, width, height, windowWidth, windowHeight);
+    }
+}
+
+void presentFrameRegion(Presenter* presenter, const unsigned char* pixels, int width, int height, int x, int y, int w, int h,
+                        int windowWidth, int windowHeight) {
+    if (presenter->mode != PRESENT_TEXTURE || presenter->width != width || presenter->height != height) {
+        presentFrame(presenter, pixels, width, height, windowWidth, windowHeight);
+        return;
+    }
+    setupWindow(windowWidth, windowHeight);
+    
+    // Clipped to the frame, then straight from client memory, a few rows aren't worth mapping a buffer for
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > width) w = width - x;
+    if (y + h > height) h = height - y;
+    if (w > 0 && h > 0) {
+        glBindTexture(GL_TEXTURE_2D, presenter->texture);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
+                        pixels + ((size_t)y * width + x) * 4);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+    drawTexture(presenter, windowWidth, windowHeight);
+}
+
+int presentCheck(Presenter* presenter, int windowWidth, int windowHeight) {
+    int width = windowWidth < presenter->maxWidth ? windowWidth : presenter->maxWidth;
+    int height = windowHeight < presenter->maxHeight ? windowHeight : presenter->maxHeight;
+    uint32_t* pattern = (uint32_t*)malloc((size_t)width * height * 4);
+    uint32_t* readBack = (uint32_t*)malloc((size_t)width * height * 4);
+    if (!pattern || !readBack) {
+        printf("Failed to allocate memory for present check\n");
+        free(pattern);
+        free(readBack);
+        return -1;
+    }
+    
+    // Every pixel different enough that a swapped channel, flipped row or off by one shows up
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            pattern[y * width + x] = ((uint32_t)(x * 7) & 0xFF) << 16 | ((uint32_t)(y * 13) & 0xFF) << 8 | ((uint32_t)(x + y) & 0xFF);
+        }
+    }
+    // Twice so both buffers get used
+    for (int i = 0; i < 2; i++) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        presentFrame(presenter, (const unsigned char*)pattern, width, height, width, height);
+    }
+    glFinish();
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, readBack);
+    
+    int wrong = 0;
+    for (int i = 0; i < width * height; i++) {
+        if ((readBack[i] & 0xFFFFFF) != pattern[i]) wrong++;
+    }
+    printf("Present check (%s, %dx%d): %d pixels wrong\n", presentModeName(presenter->mode), width, height, wrong);
+    free(pattern);
+    free(readBack);
+    return wrong;
+}
+
+void presentFree(Presenter* presenter) {
+    if (presenter->texture) glDeleteTextures(1, &presenter->texture);
+    if (presenter->buffers[0]) glDeleteBuffers(2, presenter->buffers);
+    memset(presenter, 0, sizeof(Presenter));
+}
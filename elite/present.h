@@ -0,0 +1,48 @@
+#ifndef PRESENT_H
+#define PRESENT_H
+
+#include <GL/glew.h>
+
+// Gets the CPU framebuffer onto the screen
+// PRESENT_TEXTURE streams it through two pixel buffer objects into a texture and draws one quad, the copy into the
+// buffer is a plain memcpy and the driver does the upload on its own time, nothing gets converted since BGRA is
+// what the hardware wants anyway
+// PRESENT_DRAW_PIXELS is the old glRasterPos + glPixelZoom + glDrawPixels path, used when there are no pixel buffers
+// Framebuffers are BGRA, 4 bytes a pixel (0x00RRGGBB as a uint32_t), rows packed, row 0 at the bottom
+
+typedef enum {
+    PRESENT_TEXTURE,
+    PRESENT_DRAW_PIXELS
+} PresentMode;
+
+typedef struct {
+    PresentMode mode;
+    GLuint texture;
+    GLuint buffers[2];
+    int next; // Buffer this frame goes into
+    int maxWidth, maxHeight; // Size of the texture and buffers, frames can be anything up to this
+    int width, height; // The frame that's in the texture, 0 when there isn't one
+} Presenter;
+
+// Needs a current GL context, falls back to PRESENT_DRAW_PIXELS if the one asked for isn't supported
+// Returns 0 on success, -1 if even that didn't work
+int presentInit(Presenter* presenter, PresentMode mode, int maxWidth, int maxHeight);
+
+// Draws a width x height frame stretched over the whole window, doesn't swap
+void presentFrame(Presenter* presenter, const unsigned char* pixels, int width, int height, int windowWidth, int windowHeight);
+
+// Same, for when only the x y w h rectangle changed since the last frame presented, only that part gets uploaded and
+// the rest of the texture is reused, an empty rectangle just draws the last frame again
+// Presents all of it when the last frame was a different size or there's no texture to keep it in
+void presentFrameRegion(Presenter* presenter, const unsigned char* pixels, int width, int height, int x, int y, int w, int h,
+                        int windowWidth, int windowHeight);
+
+// Presents a test pattern at 1:1 and reads it back, returns how many pixels came back wrong (-1 if it couldn't run)
+// Works under Mesa's software GL (LIBGL_ALWAYS_SOFTWARE=1), so the path can be checked without a GPU
+int presentCheck(Presenter* presenter, int windowWidth, int windowHeight);
+
+void presentFree(Presenter* presenter);
+
+const char* presentModeName(PresentMode mode);
+
+#endif // PRESENT_H
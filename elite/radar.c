@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "radar.h"
+
+#define RADAR_FILL 0x001400
+#define RADAR_LINE 0x00A000
+#define RADAR_GRID 0x004000
+
+int radarInit(Radar* radar, int maxWidth, int maxHeight, float range) {
+    memset(radar, 0, sizeof(Radar));
+    radar->pixels = (uint32_t*)malloc((size_t)maxWidth * maxHeight * sizeof(uint32_t));
+    radar->background = (uint32_t*)malloc((size_t)maxWidth * maxHeight * sizeof(uint32_t));
+    if (!radar->pixels || !radar->background) {
+        printf("Failed to allocate memory for radar\n");
+        radarFree(radar);
+        return -1;
+    }
+    radar->maxWidth = maxWidth;
+    radar->maxHeight = maxHeight;
+    radar->range = range;
+    return 0;
+}
+
+void radarFree(Radar* radar) {
+    free(radar->pixels);
+    free(radar->background);
+    memset(radar, 0, sizeof(Radar));
+}
+
+// Filled ellipse with an outline and a cross through the middle, only changes when the resolution does
+static void drawBackground(Radar* radar) {
+    int width = radar->width, height = radar->height;
+    float halfWidth = width / 2.0f, halfHeight = height / 2.0f;
+    for (int y = 0; y < height; y++) {
+        float dy = (y + 0.5f - halfHeight) / halfHeight;
+        for (int x = 0; x < width; x++) {
+            float dx = (x + 0.5f - halfWidth) / halfWidth;
+            float r = dx * dx + dy * dy;
+            uint32_t color = 0;
+            if (r <= 1.0f) {
+                // Outline about a pixel and a half wide whatever the size
+                color = r > 1.0f - 3.0f / halfHeight ? RADAR_LINE : RADAR_FILL;
+                if (color == RADAR_FILL && (x == width / 2 || y == height / 2)) color = RADAR_GRID;
+            }
+            radar->background[y * width + x] = color;
+        }
+    }
+}
+
+void radarDraw(Radar* radar, int width, int height, const RadarBlip* blips, int count) {
+    if (width > radar->maxWidth) width = radar->maxWidth;
+    if (height > radar->maxHeight) height = radar->maxHeight;
+    if (width < 8 || height < 8) return;
+    if (width != radar->width || height != radar->height) {
+        radar->width = width;
+        radar->height = height;
+        drawBackground(radar);
+    }
+    memcpy(radar->pixels, radar->background, (size_t)width * height * sizeof(uint32_t));
+    
+    float halfWidth = width / 2.0f, halfHeight = height / 2.0f;
+    float inverseRange = 1.0f / radar->range;
+    radar->blipsDrawn = 0;
+    for (int i = 0; i < count; i++) {
+        const float* p = blips[i].position;
+        float u = p[0] * inverseRange, v = p[2] * inverseRange;
+        if (u * u + v * v > 1.0f) continue;
+        float h = p[1] * inverseRange;
+        if (h < -1.0f) h = -1.0f;
+        if (h > 1.0f) h = 1.0f;
+        
+        // Rows go up, same as the frame, so forward is up the scanner
+        int x = (int)(halfWidth + u * halfWidth);
+        int foot = (int)(halfHeight + v * halfHeight);
+        int top = (int)(halfHeight + (v + h) * halfHeight);
+        if (x < 1 || x >= width - 1) continue;
+        
+        // Stalk in a dimmer color so the dot stands out
+        uint32_t color = blips[i].color;
+        uint32_t stalk = (color >> 1) & 0x7F7F7F;
+        int from = foot < top ? foot : top, to = foot < top ? top : foot;
+        if (from < 0) from = 0;
+        if (to > height - 1) to = height - 1;
+        for (int y = from; y <= to; y++) radar->pixels[y * width + x] = stalk;
+        
+        // 3x2 dot on the end
+        for (int y = top; y < top + 2; y++) {
+            if (y < 0 || y >= height) continue;
+            for (int dx = -1; dx <= 1; dx++) radar->pixels[y * width + x + dx] = color;
+        }
+        radar->blipsDrawn++;
+    }
+}
+
+void radarComposite(const Radar* radar, uint32_t* frame, int frameWidth, int frameHeight, int x, int y) {
+    for (int row = 0; row < radar->height; row++) {
+        int frameY = y + row;
+        if (frameY < 0 || frameY >= frameHeight) continue;
+        const uint32_t* source = &radar->pixels[row * radar->width];
+        uint32_t* destination = &frame[(size_t)frameY * frameWidth];
+        for (int column = 0; column < radar->width; column++) {
+            int frameX = x + column;
+            if (source[column] && frameX >= 0 && frameX < frameWidth) destination[frameX] = source[column];
+        }
+    }
+}
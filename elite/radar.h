@@ -0,0 +1,35 @@
+#ifndef RADAR_H
+#define RADAR_H
+
+#include <stdint.h>
+
+// Scanner inset, the old Elite kind, an ellipse seen from above and behind with everything in range drawn as a
+// dot on a stalk, the stalk's foot is where it is on the plane and its length how far above or below it is
+// Draws into its own buffer so it can run on another thread while the main view draws, then gets copied
+// over the frame, doesn't know about Objects, it's given camera space positions the renderer already worked out
+
+typedef struct {
+    float position[3]; // Camera space, x right, y up, z forward
+    uint32_t color;
+} RadarBlip;
+
+typedef struct {
+    uint32_t* pixels; // width * height, 0 is see through
+    uint32_t* background; // The empty scanner, redrawn when the size changes
+    int width, height;
+    int maxWidth, maxHeight;
+    float range; // Further than this on the plane isn't shown
+    int blipsDrawn; // Last draw
+} Radar;
+
+// Returns 0 on success, -1 if the buffers couldn't be allocated
+int radarInit(Radar* radar, int maxWidth, int maxHeight, float range);
+void radarFree(Radar* radar);
+
+// Draws the scanner at this size (clamped to the max) with the blips on it
+void radarDraw(Radar* radar, int width, int height, const RadarBlip* blips, int count);
+
+// Copies everything that isn't see through onto a 0x00RRGGBB frame, x y is the bottom left corner
+void radarComposite(const Radar* radar, uint32_t* frame, int frameWidth, int frameHeight, int x, int y);
+
+#endif // RADAR_H
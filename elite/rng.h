@@ -0,0 +1,104 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <emmintrin.h>
+
+// Small random number generators to use instead of rand(), which glibc puts behind a lock
+// Both are xoshiro128+, every thread/entity gets its own state so nothing is shared
+// Rng is a single stream, Rng4 runs four independent streams in the lanes of an SSE register
+
+typedef struct {
+    uint32_t s[4];
+} Rng;
+
+typedef struct {
+    __m128i s[4];
+} Rng4;
+
+// Spreads a seed out into well mixed state words, also good for hashing ids into seeds
+static inline uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline void rngSeed(Rng* rng, uint64_t seed) {
+    uint64_t a = splitmix64(&seed);
+    uint64_t b = splitmix64(&seed);
+    rng->s[0] = (uint32_t)a;
+    rng->s[1] = (uint32_t)(a >> 32);
+    rng->s[2] = (uint32_t)b;
+    rng->s[3] = (uint32_t)(b >> 32) | 1; // State can't be all zero
+}
+
+static inline uint32_t rngNext(Rng* rng) {
+    uint32_t* s = rng->s;
+    uint32_t result = s[0] + s[3];
+    uint32_t t = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 11) | (s[3] >> 21);
+
+    return result;
+}
+
+// Uniform in [0, 1), the top 24 bits are the good ones for xoshiro128+
+static inline float rngFloat(Rng* rng) {
+    return (rngNext(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Uniform in [min, max)
+static inline float rngRange(Rng* rng, float min, float max) {
+    return min + rngFloat(rng) * (max - min);
+}
+
+static inline void rng4Seed(Rng4* rng, uint64_t seed) {
+    uint32_t lanes[4][4];
+    for (int lane = 0; lane < 4; lane++) {
+        Rng single;
+        rngSeed(&single, seed + lane * 0x632BE59BD9B4E019ull);
+        for (int word = 0; word < 4; word++) lanes[word][lane] = single.s[word];
+    }
+    for (int word = 0; word < 4; word++) {
+        rng->s[word] = _mm_loadu_si128((const __m128i*)lanes[word]);
+    }
+}
+
+// Four uniform floats in [0, 1), one from each lane
+static inline __m128 rng4Floats(Rng4* rng) {
+    __m128i* s = rng->s;
+    __m128i result = _mm_add_epi32(s[0], s[3]);
+    __m128i t = _mm_slli_epi32(s[1], 9);
+
+    s[2] = _mm_xor_si128(s[2], s[0]);
+    s[3] = _mm_xor_si128(s[3], s[1]);
+    s[1] = _mm_xor_si128(s[1], s[2]);
+    s[0] = _mm_xor_si128(s[0], s[3]);
+    s[2] = _mm_xor_si128(s[2], t);
+    s[3] = _mm_or_si128(_mm_slli_epi32(s[3], 11), _mm_srli_epi32(s[3], 21));
+
+    __m128 top = _mm_cvtepi32_ps(_mm_srli_epi32(result, 8));
+    return _mm_mul_ps(top, _mm_set1_ps(1.0f / 16777216.0f));
+}
+
+// Batch version, fills out with count uniform floats in [0, 1)
+static inline void rng4Fill(Rng4* rng, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, rng4Floats(rng));
+    }
+    if (i < count) {
+        float rest[4];
+        _mm_storeu_ps(rest, rng4Floats(rng));
+        for (size_t j = 0; i < count; i++, j++) out[i] = rest[j];
+    }
+}
+
+#endif // RNG_H
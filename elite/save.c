@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "save.h"
+
+// On disk: header, section table, then every section's records, padded out to SAVE_ALIGN
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numSections;
+    uint32_t reserved;
+    uint64_t size; // Whole file, a truncated one gets caught before anything reads past the end
+} SaveHeader;
+
+typedef struct {
+    uint32_t id;
+    uint32_t recordSize;
+    uint64_t count;
+    uint64_t offset; // From the start of the file
+} SaveEntry;
+
+static const uint8_t padding[SAVE_ALIGN] = {0};
+
+static inline uint64_t alignUp(uint64_t value) {
+    return (value + SAVE_ALIGN - 1) & ~(uint64_t)(SAVE_ALIGN - 1);
+}
+
+// writev can stop short, so it goes round until everything's out
+static int writeAll(int fd, struct iovec* iov, int count) {
+    while (count > 0) {
+        ssize_t written = writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        while (count > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    return 0;
+}
+
+int saveWrite(const char* filename, uint32_t version, const SaveSection* sections, int numSections) {
+    if (numSections > SAVE_MAX_SECTIONS) {
+        printf("Too many sections to save: %d\n", numSections);
+        return -1;
+    }
+    
+    // Header and table go out as one block, each section is its records then the padding to the next
+    struct {
+        SaveHeader header;
+        SaveEntry entries[SAVE_MAX_SECTIONS];
+    } head;
+    memset(&head, 0, sizeof(head));
+    struct iovec iov[2 + SAVE_MAX_SECTIONS * 2];
+    int numIov = 0;
+    
+    // Only the entries in use come out of head, the padding up to the first section is separate since with every
+    // section in use it'd run off the end of head
+    uint64_t headBytes = sizeof(SaveHeader) + numSections * sizeof(SaveEntry);
+    uint64_t offset = alignUp(headBytes);
+    iov[numIov++] = (struct iovec){&head, headBytes};
+    if (offset > headBytes) iov[numIov++] = (struct iovec){(void*)padding, offset - headBytes};
+    for (int i = 0; i < numSections; i++) {
+        uint64_t bytes = (uint64_t)sections[i].recordSize * sections[i].count;
+        head.entries[i] = (SaveEntry){sections[i].id, sections[i].recordSize, sections[i].count, offset};
+        if (bytes > 0) iov[numIov++] = (struct iovec){(void*)sections[i].data, bytes};
+        if (alignUp(bytes) > bytes) iov[numIov++] = (struct iovec){(void*)padding, alignUp(bytes) - bytes};
+        offset += alignUp(bytes);
+    }
+    head.header = (SaveHeader){SAVE_MAGIC, version, numSections, 0, offset};
+    
+    char temporary[PATH_MAX];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", filename);
+    int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Failed to create save file: %s\n", temporary);
+        return -1;
+    }
+    int result = writeAll(fd, iov, numIov);
+    if (close(fd) != 0) result = -1;
+    if (result == 0 && rename(temporary, filename) != 0) result = -1;
+    if (result != 0) {
+        printf("Failed to write save file: %s\n", filename);
+        unlink(temporary);
+    }
+    return result;
+}
+
+int saveOpen(const char* filename, SaveFile* file) {
+    memset(file, 0, sizeof(SaveFile));
+    
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Failed to open save file: %s\n", filename);
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0 || (size_t)info.st_size < sizeof(SaveHeader)) {
+        printf("Save file is too small: %s\n", filename);
+        close(fd);
+        return -1;
+    }
+    void* mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid after the descriptor is gone
+    if (mapping == MAP_FAILED) {
+        printf("Failed to map save file: %s\n", filename);
+        return -1;
+    }
+    file->mapping = mapping;
+    file->size = info.st_size;
+    
+    const SaveHeader* header = (const SaveHeader*)mapping;
+    if (header->magic != SAVE_MAGIC || header->size != (uint64_t)info.st_size || header->numSections > SAVE_MAX_SECTIONS ||
+        sizeof(SaveHeader) + header->numSections * sizeof(SaveEntry) > file->size) {
+        printf("Not a save file, or it's been cut short: %s\n", filename);
+        saveClose(file);
+        return -1;
+    }
+    
+    const SaveEntry* entries = (const SaveEntry*)(header + 1);
+    for (uint32_t i = 0; i < header->numSections; i++) {
+        const SaveEntry* entry = &entries[i];
+        uint64_t bytes = (uint64_t)entry->recordSize * entry->count;
+        if (entry->offset % SAVE_ALIGN != 0 || entry->offset > file->size || bytes > file->size - entry->offset) {
+            printf("Save file has a broken section %u: %s\n", entry->id, filename);
+            saveClose(file);
+            return -1;
+        }
+        file->sections[i] = (SaveSection){entry->id, entry->recordSize, entry->count, (const char*)mapping + entry->offset};
+    }
+    file->numSections = header->numSections;
+    file->version = header->version;
+    
+    // Everything's about to be read, start the kernel reading it in now rather than a page fault at a time
+    madvise(mapping, file->size, MADV_WILLNEED);
+    return 0;
+}
+
+const void* saveSection(const SaveFile* file, uint32_t id, uint32_t recordSize, uint64_t* count) {
+    for (int i = 0; i < file->numSections; i++) {
+        if (file->sections[i].id != id) continue;
+        if (file->sections[i].recordSize != recordSize) return NULL;
+        *count = file->sections[i].count;
+        return file->sections[i].data;
+    }
+    return NULL;
+}
+
+void saveClose(SaveFile* file) {
+    if (file->mapping) munmap(file->mapping, file->size);
+    memset(file, 0, sizeof(SaveFile));
+}
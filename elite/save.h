@@ -0,0 +1,45 @@
+#ifndef SAVE_H
+#define SAVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// World snapshots on disk, one file made of sections that are each just an array of fixed size records
+// Writing is a couple of big writev calls straight out of the caller's arrays, reading maps the file and hands
+// back pointers into the mapping, so loading is a memcpy per section at most
+// Doesn't know about Objects, the caller decides what goes in each section and fixes up pointers itself
+// Files are only meant to be read back by the same build on the same machine, no byte swapping
+
+#define SAVE_MAGIC 0x56415345 // "ESAV"
+#define SAVE_MAX_SECTIONS 32
+#define SAVE_ALIGN 16 // Every section starts on this, so SSE types can be read in place
+
+typedef struct {
+    uint32_t id; // The caller's, a file can't have two with the same id
+    uint32_t recordSize; // sizeof one element, a load is refused if it doesn't match what's asked for
+    uint64_t count;
+    const void* data; // Into the mapping when loaded
+} SaveSection;
+
+typedef struct {
+    uint32_t version; // The caller's format version
+    SaveSection sections[SAVE_MAX_SECTIONS];
+    int numSections;
+    void* mapping;
+    size_t size;
+} SaveFile;
+
+// Writes every section to filename, through a temporary file so a failed save never leaves half a file behind
+// Returns 0 on success, -1 otherwise
+int saveWrite(const char* filename, uint32_t version, const SaveSection* sections, int numSections);
+
+// Maps a file written by saveWrite and checks it's all there, returns 0 on success, -1 otherwise
+int saveOpen(const char* filename, SaveFile* file);
+
+// The records of a section, NULL if there isn't one with that id or its records aren't recordSize big
+const void* saveSection(const SaveFile* file, uint32_t id, uint32_t recordSize, uint64_t* count);
+
+// Unmaps the file, anything from saveSection is invalid afterwards
+void saveClose(SaveFile* file);
+
+#endif // SAVE_H
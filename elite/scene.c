@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "scene.h"
+
+#define SCENE_LINE_LENGTH 512
+
+static int findMesh(const Scene* scene, const char* name) {
+	for (uint32_t i = 0; i < scene->numMeshes; i++) {
+		if (strcmp(scene->meshes[i].name, name) == 0) return i;
+	}
+	return -1;
+}
+
+static int findArchetype(const Scene* scene, const char* name) {
+	for (uint32_t i = 0; i < scene->numArchetypes; i++) {
+		if (strcmp(scene->archetypes[i].name, name) == 0) return i;
+	}
+	return -1;
+}
+
+// Fill out the instances for a grid directive, same layout main() used to have
+static void expandGrid(Scene* scene, uint32_t archetype, uint32_t count, float x, float y, float z, float spacing) {
+	int size = (int)ceil(cbrt(count)); // Find the cube root to arrange in 3D
+	uint32_t placed = 0;
+
+	for (int i = 0; i < size && placed < count; i++) {
+		for (int j = 0; j < size && placed < count; j++) {
+			for (int k = 0; k < size && placed < count; k++) {
+				SceneInstance* instance = &scene->instances[scene->numInstances++];
+				instance->archetype = archetype;
+				instance->position[0] = x + (i - size / 2) * spacing;
+				instance->position[1] = y + (j - size / 2) * spacing;
+				instance->position[2] = z + (k - size / 2) * spacing;
+				placed++;
+			}
+		}
+	}
+}
+
+// Runs over every line of the file, the first pass (fill = 0) only counts so everything
+// can be allocated in one go, the second pass (fill = 1) actually stores the directives
+static int parseScene(const char* data, size_t size, Scene* scene, int fill, const char* filename) {
+	const char* cursor = data;
+	const char* end = data + size;
+	int lineNumber = 0;
+
+	while (cursor < end) {
+		const char* newline = memchr(cursor, '\n', end - cursor);
+		size_t length = newline ? (size_t)(newline - cursor) : (size_t)(end - cursor);
+		lineNumber++;
+
+		// Copy the line out, the mapping isn't null terminated
+		char line[SCENE_LINE_LENGTH];
+		if (length >= sizeof(line)) {
+			printf("%s:%d: line too long\n", filename, lineNumber);
+			return -1;
+		}
+		memcpy(line, cursor, length);
+		line[length] = '\0';
+		cursor += length + 1;
+
+		char* comment = strchr(line, '#');
+		if (comment) *comment = '\0';
+
+		char directive[16];
+		if (sscanf(line, "%15s", directive) != 1) continue; // Empty line
+
+		char name[SCENE_NAME_LENGTH], other[SCENE_PATH_LENGTH];
+		float x, y, z, scale, spacing;
+		unsigned int id, color, count;
+
+		if (strcmp(directive, "mesh") == 0) {
+			if (sscanf(line, "%*s %31s %255s", name, other) != 2) goto bad;
+			if (fill) {
+				SceneMesh* mesh = &scene->meshes[scene->numMeshes++];
+				strcpy(mesh->name, name);
+				strcpy(mesh->file, other);
+			} else {
+				scene->numMeshes++;
+			}
+		} else if (strcmp(directive, "type") == 0) {
+			if (sscanf(line, "%*s %31s %31s %u %f %x", name, other, &id, &scale, &color) != 5) goto bad;
+			if (fill) {
+				int mesh = findMesh(scene, other);
+				if (mesh < 0) {
+					printf("%s:%d: unknown mesh '%s'\n", filename, lineNumber, other);
+					return -1;
+				}
+				SceneArchetype* archetype = &scene->archetypes[scene->numArchetypes++];
+				strcpy(archetype->name, name);
+				archetype->mesh = mesh;
+				archetype->id = (uint8_t)id;
+				archetype->scale = scale;
+				archetype->color = color;
+			} else {
+				scene->numArchetypes++;
+			}
+		} else if (strcmp(directive, "spawn") == 0) {
+			if (sscanf(line, "%*s %31s %f %f %f", name, &x, &y, &z) != 4) goto bad;
+			if (fill) {
+				int archetype = findArchetype(scene, name);
+				if (archetype < 0) {
+					printf("%s:%d: unknown type '%s'\n", filename, lineNumber, name);
+					return -1;
+				}
+				SceneInstance* instance = &scene->instances[scene->numInstances++];
+				instance->archetype = archetype;
+				instance->position[0] = x;
+				instance->position[1] = y;
+				instance->position[2] = z;
+			} else {
+				scene->numInstances++;
+			}
+		} else if (strcmp(directive, "grid") == 0) {
+			if (sscanf(line, "%*s %31s %u %f %f %f %f", name, &count, &x, &y, &z, &spacing) != 6) goto bad;
+			if (fill) {
+				int archetype = findArchetype(scene, name);
+				if (archetype < 0) {
+					printf("%s:%d: unknown type '%s'\n", filename, lineNumber, name);
+					return -1;
+				}
+				expandGrid(scene, archetype, count, x, y, z, spacing);
+			} else {
+				scene->numInstances += count;
+			}
+		} else if (strcmp(directive, "camera") == 0) {
+			if (sscanf(line, "%*s %f %f %f", &x, &y, &z) != 3) goto bad;
+			scene->hasCamera = 1;
+			scene->camera[0] = x;
+			scene->camera[1] = y;
+			scene->camera[2] = z;
+		} else if (strcmp(directive, "seed") == 0) {
+			unsigned long long seed;
+			if (sscanf(line, "%*s %llu", &seed) != 1) goto bad;
+			scene->hasSeed = 1;
+			scene->seed = seed;
+		} else if (strcmp(directive, "prefetch") == 0) {
+			if (sscanf(line, "%*s %255s", other) != 1) goto bad;
+			if (fill) strcpy(scene->prefetch[scene->numPrefetch], other);
+			scene->numPrefetch++;
+		} else if (strcmp(directive, "sectors") == 0) {
+			int radius;
+			if (sscanf(line, "%*s %d %u", &radius, &count) != 2 || radius < 0 || radius > 4) goto bad;
+			scene->hasSectors = 1;
+			scene->sectorRadius = radius;
+			scene->sectorBudget = (size_t)count * 1024;
+		} else {
+			printf("%s:%d: unknown directive '%s'\n", filename, lineNumber, directive);
+			return -1;
+		}
+		continue;
+
+	bad:
+		printf("%s:%d: malformed '%s' line\n", filename, lineNumber, directive);
+		return -1;
+	}
+	return 0;
+}
+
+int loadScene(const char* filename, Scene* scene) {
+	memset(scene, 0, sizeof(Scene));
+
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		printf("Failed to open scene file: %s\n", filename);
+		return -1;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) < 0 || info.st_size == 0) {
+		printf("Scene file is empty: %s\n", filename);
+		close(fd);
+		return -1;
+	}
+
+	const char* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // The mapping stays valid after the descriptor is gone
+	if (data == MAP_FAILED) {
+		printf("Failed to map scene file: %s\n", filename);
+		return -1;
+	}
+
+	// First pass just counts, so every list is a single allocation
+	int result = parseScene(data, info.st_size, scene, 0, filename);
+	if (result == 0) {
+		scene->meshes = (SceneMesh*)malloc((scene->numMeshes + 1) * sizeof(SceneMesh));
+		scene->archetypes = (SceneArchetype*)malloc((scene->numArchetypes + 1) * sizeof(SceneArchetype));
+		scene->instances = (SceneInstance*)malloc(((size_t)scene->numInstances + 1) * sizeof(SceneInstance));
+		scene->prefetch = malloc((scene->numPrefetch + 1) * sizeof(*scene->prefetch));
+		if (!scene->meshes || !scene->archetypes || !scene->instances || !scene->prefetch) {
+			printf("Failed to allocate memory for scene\n");
+			result = -1;
+		} else {
+			scene->numMeshes = 0;
+			scene->numArchetypes = 0;
+			scene->numInstances = 0;
+			scene->numPrefetch = 0;
+			result = parseScene(data, info.st_size, scene, 1, filename);
+		}
+	}
+
+	munmap((void*)data, info.st_size);
+	if (result != 0) freeScene(scene);
+	return result;
+}
+
+void freeScene(Scene* scene) {
+	free(scene->meshes);
+	free(scene->archetypes);
+	free(scene->instances);
+	free(scene->prefetch);
+	memset(scene, 0, sizeof(Scene));
+}
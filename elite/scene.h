@@ -0,0 +1,61 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Scene description files, a small text format listing what to spawn at startup
+// Lines are directives, anything after a '#' is a comment:
+//   mesh   <name> <file>                              mesh reference
+//   type   <name> <mesh> <id> <scale> <color>         archetype, color is hex RRGGBB
+//   spawn  <type> <x> <y> <z>                         single instance
+//   grid   <type> <count> <x> <y> <z> <spacing>       cube of instances centred on x y z
+//   camera <x> <y> <z>                                starting camera position
+//   seed   <number>                                   world seed, everything random comes from it
+//   sectors <radius> <budgetKB>                       generate the universe around the player by sector, see sector.h
+//   prefetch <file>                                   mesh to load in the background, for things spawned later
+
+#define SCENE_NAME_LENGTH 32
+#define SCENE_PATH_LENGTH 256
+
+typedef struct {
+	char name[SCENE_NAME_LENGTH];
+	char file[SCENE_PATH_LENGTH];
+} SceneMesh;
+
+typedef struct {
+	char name[SCENE_NAME_LENGTH];
+	uint32_t mesh; // Index into Scene.meshes
+	uint8_t id; // Same ids addObject takes
+	float scale;
+	unsigned int color;
+} SceneArchetype;
+
+typedef struct {
+	uint32_t archetype; // Index into Scene.archetypes
+	float position[3];
+} SceneInstance;
+
+typedef struct {
+	SceneMesh* meshes;
+	uint32_t numMeshes;
+	SceneArchetype* archetypes;
+	uint32_t numArchetypes;
+	SceneInstance* instances;
+	uint32_t numInstances;
+	int hasCamera;
+	float camera[3];
+	int hasSeed;
+	uint64_t seed;
+	int hasSectors;
+	int sectorRadius; // Sectors this far from the player's get generated
+	size_t sectorBudget; // Bytes
+	char (*prefetch)[SCENE_PATH_LENGTH];
+	uint32_t numPrefetch;
+} Scene;
+
+// Parses a scene file, returns 0 on success, -1 on failure (and prints why)
+int loadScene(const char* filename, Scene* scene);
+void freeScene(Scene* scene);
+
+#endif // SCENE_H
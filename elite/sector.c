@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sector.h"
+#include "rng.h"
+
+#define STAR_SYSTEM_CHANCE 0.45f // Most sectors are just empty space, maybe with a few ships
+#define MAX_PLANETS 6
+#define STAR_MASS 1E18 // Same as setupObject gives stars
+
+static const unsigned int starColors[] = {0xFFD27F, 0xFFFFFF, 0xFF6040, 0x9FB4FF};
+static const unsigned int planetColors[] = {0x0000FF, 0x2E8B57, 0xC2B280, 0xB7410E, 0x7FFFD4, 0x808080};
+
+uint64_t sectorSeed(uint64_t worldSeed, SectorCoord coord) {
+    // Big odd multipliers so neighbouring coordinates end up nowhere near each other before mixing
+    uint64_t x = worldSeed;
+    x ^= (uint64_t)(uint32_t)coord.x * 0x9E3779B97F4A7C15ull;
+    x ^= (uint64_t)(uint32_t)coord.y * 0xC2B2AE3D27D4EB4Full;
+    x ^= (uint64_t)(uint32_t)coord.z * 0x165667B19E3779F9ull;
+    return splitmix64(&x);
+}
+
+// Somewhere on a circle of this radius around center, tilted a little off the XZ plane, with the velocity
+// for a circular orbit going the same way round as everything else in the system
+static void placeInOrbit(Rng* rng, SectorSpawn* spawn, const float center[3], float radius, double gravity) {
+    float angle = rngRange(rng, 0.0f, 2.0f * (float)M_PI);
+    float tilt = rngRange(rng, -0.05f, 0.05f);
+    float c = cosf(angle), s = sinf(angle);
+    spawn->position[0] = center[0] + c * radius;
+    spawn->position[1] = center[1] + tilt * radius;
+    spawn->position[2] = center[2] + s * radius;
+    float speed = (float)sqrt(gravity * STAR_MASS / radius);
+    spawn->velocity[0] = -s * speed;
+    spawn->velocity[1] = 0.0f;
+    spawn->velocity[2] = c * speed;
+}
+
+static void addShips(Rng* rng, SectorSpawn* spawns, int* count, const float around[3], int ships, float spread) {
+    for (int i = 0; i < ships && *count < SECTOR_MAX_SPAWNS; i++) {
+        SectorSpawn* spawn = &spawns[(*count)++];
+        memset(spawn, 0, sizeof(SectorSpawn));
+        spawn->kind = SECTOR_SHIP;
+        for (int j = 0; j < 3; j++) spawn->position[j] = around[j] + rngRange(rng, -spread, spread);
+        spawn->scale = 1.0f;
+        spawn->color = 0xFF0000;
+    }
+}
+
+int generateSector(uint64_t worldSeed, SectorCoord coord, double gravity, SectorSpawn spawns[SECTOR_MAX_SPAWNS]) {
+    Rng rng;
+    rngSeed(&rng, sectorSeed(worldSeed, coord));
+    int count = 0;
+    
+    float origin[3] = {coord.x * SECTOR_SIZE, coord.y * SECTOR_SIZE, coord.z * SECTOR_SIZE};
+    if (rngFloat(&rng) >= STAR_SYSTEM_CHANCE) {
+        // A few ships passing through
+        int ships = (int)(rngNext(&rng) % 4);
+        float center[3];
+        for (int j = 0; j < 3; j++) center[j] = origin[j] + rngRange(&rng, 0.2f, 0.8f) * SECTOR_SIZE;
+        addShips(&rng, spawns, &count, center, ships, 2000.0f);
+        return count;
+    }
+    
+    // Star somewhere in the middle, far enough from the edges that its planets stay inside the sector
+    SectorSpawn* star = &spawns[count++];
+    memset(star, 0, sizeof(SectorSpawn));
+    star->kind = SECTOR_STAR;
+    for (int j = 0; j < 3; j++) star->position[j] = origin[j] + rngRange(&rng, 0.4f, 0.6f) * SECTOR_SIZE;
+    star->scale = rngRange(&rng, 2000.0f, 5000.0f);
+    star->color = starColors[rngNext(&rng) % (sizeof(starColors) / sizeof(starColors[0]))];
+    
+    int planets = 1 + (int)(rngNext(&rng) % MAX_PLANETS);
+    float orbit = star->scale * 4.0f;
+    for (int i = 0; i < planets; i++) {
+        orbit += rngRange(&rng, 6000.0f, 12000.0f);
+        SectorSpawn* planet = &spawns[count++];
+        memset(planet, 0, sizeof(SectorSpawn));
+        planet->kind = SECTOR_PLANET;
+        placeInOrbit(&rng, planet, star->position, orbit, gravity);
+        planet->scale = rngRange(&rng, 200.0f, 1200.0f);
+        planet->color = planetColors[rngNext(&rng) % (sizeof(planetColors) / sizeof(planetColors[0]))];
+        
+        // Some planets have a station a bit further out on the same orbit, with a few ships around it
+        if (rngFloat(&rng) < 0.3f && count < SECTOR_MAX_SPAWNS) {
+            SectorSpawn* station = &spawns[count++];
+            memset(station, 0, sizeof(SectorSpawn));
+            station->kind = SECTOR_STATION;
+            placeInOrbit(&rng, station, star->position, orbit + planet->scale * 4.0f, gravity);
+            station->scale = 30.0f;
+            station->color = 0xC0C0C0;
+            float stationPosition[3] = {station->position[0], station->position[1], station->position[2]};
+            addShips(&rng, spawns, &count, stationPosition, 2 + (int)(rngNext(&rng) % 8), 1000.0f);
+        }
+    }
+    return count;
+}
+
+LoadedSector* findSector(SectorMap* map, SectorCoord coord) {
+    for (uint32_t i = 0; i < map->numSectors; i++) {
+        LoadedSector* sector = &map->sectors[i];
+        if (sector->coord.x == coord.x && sector->coord.y == coord.y && sector->coord.z == coord.z) return sector;
+    }
+    return NULL;
+}
+
+LoadedSector* addSector(SectorMap* map, SectorCoord coord) {
+    if (map->numSectors == map->capacity) {
+        uint32_t capacity = map->capacity ? map->capacity * 2 : 32;
+        LoadedSector* sectors = (LoadedSector*)realloc(map->sectors, capacity * sizeof(LoadedSector));
+        if (!sectors) {
+            printf("Failed to allocate memory for sector list\n");
+            return NULL;
+        }
+        map->sectors = sectors;
+        map->capacity = capacity;
+    }
+    LoadedSector* sector = &map->sectors[map->numSectors++];
+    memset(sector, 0, sizeof(LoadedSector));
+    sector->coord = coord;
+    map->generated++;
+    return sector;
+}
+
+LoadedSector* oldestSector(SectorMap* map, uint32_t tick) {
+    LoadedSector* oldest = NULL;
+    for (uint32_t i = 0; i < map->numSectors; i++) {
+        LoadedSector* sector = &map->sectors[i];
+        if (sector->lastWanted == tick) continue;
+        if (!oldest || sector->lastWanted < oldest->lastWanted) oldest = sector;
+    }
+    return oldest;
+}
+
+void removeSector(SectorMap* map, LoadedSector* sector) {
+    map->bytes -= sector->bytes;
+    free(sector->objects);
+    // Order doesn't matter, the last one fills the hole
+    *sector = map->sectors[--map->numSectors];
+    map->evicted++;
+}
+
+void freeSectorMap(SectorMap* map) {
+    for (uint32_t i = 0; i < map->numSectors; i++) free(map->sectors[i].objects);
+    free(map->sectors);
+    map->sectors = NULL;
+    map->numSectors = map->capacity = 0;
+    map->bytes = 0;
+}
@@ -0,0 +1,79 @@
+#ifndef SECTOR_H
+#define SECTOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// The universe is cut into cubic sectors, what's in each one comes from a hash of the world seed and the
+// sector coordinate, so a sector can be thrown away and comes back exactly the same next time it's generated
+// Doesn't know about Objects, generateSector says what to spawn and the caller keeps track of what it spawned
+
+#define SECTOR_SIZE 200000.0f
+#define SECTOR_MAX_SPAWNS 64
+
+typedef struct {
+    int32_t x, y, z;
+} SectorCoord;
+
+typedef enum {
+    SECTOR_STAR,
+    SECTOR_PLANET,
+    SECTOR_STATION,
+    SECTOR_SHIP
+} SectorSpawnKind;
+
+typedef struct {
+    uint8_t kind; // SectorSpawnKind
+    float position[3];
+    float velocity[3]; // Planets and stations start on a circular orbit around the star
+    float scale;
+    unsigned int color;
+} SectorSpawn;
+
+// Bookkeeping for a sector that's been generated, the object indexes are whatever the caller spawned
+typedef struct {
+    SectorCoord coord;
+    uint32_t* objects;
+    uint32_t numObjects;
+    uint32_t lastWanted; // Tick it was last in range of the player
+    size_t bytes; // What it's charged against the budget
+} LoadedSector;
+
+typedef struct {
+    LoadedSector* sectors;
+    uint32_t numSectors, capacity;
+    int radius; // Sectors this far from the player's (each axis) get generated
+    size_t bytes, budget; // Out of range sectors stay around until the total goes over the budget
+    uint32_t generated, evicted; // Totals, for the stats
+} SectorMap;
+
+static inline SectorCoord sectorOf(const float position[3]) {
+    return (SectorCoord){
+        (int32_t)floorf(position[0] / SECTOR_SIZE),
+        (int32_t)floorf(position[1] / SECTOR_SIZE),
+        (int32_t)floorf(position[2] / SECTOR_SIZE)
+    };
+}
+
+// Seed for everything in a sector
+uint64_t sectorSeed(uint64_t worldSeed, SectorCoord coord);
+
+// Fills spawns with the sector's contents and returns how many, gravity is what the star's orbits are worked out for
+int generateSector(uint64_t worldSeed, SectorCoord coord, double gravity, SectorSpawn spawns[SECTOR_MAX_SPAWNS]);
+
+// NULL if it isn't loaded
+LoadedSector* findSector(SectorMap* map, SectorCoord coord);
+
+// Adds an empty entry, NULL if it couldn't allocate, the pointer is only good until the next add or remove
+LoadedSector* addSector(SectorMap* map, SectorCoord coord);
+
+// The loaded sector that's been out of range longest, not counting any wanted on this tick, NULL if there's none
+LoadedSector* oldestSector(SectorMap* map, uint32_t tick);
+
+// Forgets a sector, the caller has to have removed its objects already
+void removeSector(SectorMap* map, LoadedSector* sector);
+
+void freeSectorMap(SectorMap* map);
+
+#endif // SECTOR_H
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <string.h>
+#include <immintrin.h>
+#include "simd.h"
+
+// Each variant is the same maths, the wider ones just go through more vertices at a time
+// The target attributes let one file hold code for instruction sets the rest of the build doesn't assume,
+// nothing here runs until simdInit has checked the CPU has it
+
+static inline void projectOne(const SimdProjection* projection, const float vertex[4], float* screenX, float* screenY,
+                              float* depth) {
+    const float (*rows)[4] = projection->rows;
+    float x = rows[0][0] * vertex[0] + rows[0][1] * vertex[1] + rows[0][2] * vertex[2] + rows[0][3];
+    float y = rows[1][0] * vertex[0] + rows[1][1] * vertex[1] + rows[1][2] * vertex[2] + rows[1][3];
+    float z = rows[2][0] * vertex[0] + rows[2][1] * vertex[1] + rows[2][2] * vertex[2] + rows[2][3];
+    float scale = projection->focal / z;
+    *screenX = x * scale + projection->halfWidth;
+    *screenY = y * scale + projection->halfHeight;
+    *depth = z;
+}
+
+static void projectSse2(const SimdProjection* projection, const float (*vertices)[4], size_t count, float* screenX,
+                        float* screenY, float* depth) {
+    const float (*rows)[4] = projection->rows;
+    __m128 r00 = _mm_set1_ps(rows[0][0]), r01 = _mm_set1_ps(rows[0][1]), r02 = _mm_set1_ps(rows[0][2]), r03 = _mm_set1_ps(rows[0][3]);
+    __m128 r10 = _mm_set1_ps(rows[1][0]), r11 = _mm_set1_ps(rows[1][1]), r12 = _mm_set1_ps(rows[1][2]), r13 = _mm_set1_ps(rows[1][3]);
+    __m128 r20 = _mm_set1_ps(rows[2][0]), r21 = _mm_set1_ps(rows[2][1]), r22 = _mm_set1_ps(rows[2][2]), r23 = _mm_set1_ps(rows[2][3]);
+    __m128 focal = _mm_set1_ps(projection->focal);
+    __m128 halfWidth = _mm_set1_ps(projection->halfWidth), halfHeight = _mm_set1_ps(projection->halfHeight);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // Four vertices in, x y z and the unused w out
+        __m128 x = _mm_loadu_ps(vertices[i]), y = _mm_loadu_ps(vertices[i + 1]);
+        __m128 z = _mm_loadu_ps(vertices[i + 2]), w = _mm_loadu_ps(vertices[i + 3]);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        __m128 cameraX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r00, x), _mm_mul_ps(r01, y)), _mm_add_ps(_mm_mul_ps(r02, z), r03));
+        __m128 cameraY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r10, x), _mm_mul_ps(r11, y)), _mm_add_ps(_mm_mul_ps(r12, z), r13));
+        __m128 cameraZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r20, x), _mm_mul_ps(r21, y)), _mm_add_ps(_mm_mul_ps(r22, z), r23));
+        __m128 scale = _mm_div_ps(focal, cameraZ);
+        _mm_storeu_ps(screenX + i, _mm_add_ps(_mm_mul_ps(cameraX, scale), halfWidth));
+        _mm_storeu_ps(screenY + i, _mm_add_ps(_mm_mul_ps(cameraY, scale), halfHeight));
+        _mm_storeu_ps(depth + i, cameraZ);
+    }
+    for (; i < count; i++) projectOne(projection, vertices[i], &screenX[i], &screenY[i], &depth[i]);
+}
+
+__attribute__((target("avx2,fma")))
+static void projectAvx2(const SimdProjection* projection, const float (*vertices)[4], size_t count, float* screenX,
+                        float* screenY, float* depth) {
+    const float (*rows)[4] = projection->rows;
+    __m256 r00 = _mm256_set1_ps(rows[0][0]), r01 = _mm256_set1_ps(rows[0][1]), r02 = _mm256_set1_ps(rows[0][2]), r03 = _mm256_set1_ps(rows[0][3]);
+    __m256 r10 = _mm256_set1_ps(rows[1][0]), r11 = _mm256_set1_ps(rows[1][1]), r12 = _mm256_set1_ps(rows[1][2]), r13 = _mm256_set1_ps(rows[1][3]);
+    __m256 r20 = _mm256_set1_ps(rows[2][0]), r21 = _mm256_set1_ps(rows[2][1]), r22 = _mm256_set1_ps(rows[2][2]), r23 = _mm256_set1_ps(rows[2][3]);
+    __m256 focal = _mm256_set1_ps(projection->focal);
+    __m256 halfWidth = _mm256_set1_ps(projection->halfWidth), halfHeight = _mm256_set1_ps(projection->halfHeight);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // Vertices 0-1, 2-3, 4-5 and 6-7, then regrouped so each register has n in the low half and n + 4 in the
+        // high half, after that it's the SSE transpose in both halves at once
+        __m256 m0 = _mm256_loadu_ps(vertices[i]), m1 = _mm256_loadu_ps(vertices[i + 2]);
+        __m256 m2 = _mm256_loadu_ps(vertices[i + 4]), m3 = _mm256_loadu_ps(vertices[i + 6]);
+        __m256 a = _mm256_permute2f128_ps(m0, m2, 0x20), b = _mm256_permute2f128_ps(m0, m2, 0x31);
+        __m256 c = _mm256_permute2f128_ps(m1, m3, 0x20), d = _mm256_permute2f128_ps(m1, m3, 0x31);
+        __m256 ab = _mm256_unpacklo_ps(a, b), cd = _mm256_unpacklo_ps(c, d);
+        __m256 x = _mm256_shuffle_ps(ab, cd, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 y = _mm256_shuffle_ps(ab, cd, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 z = _mm256_shuffle_ps(_mm256_unpackhi_ps(a, b), _mm256_unpackhi_ps(c, d), _MM_SHUFFLE(1, 0, 1, 0));
+
+        __m256 cameraX = _mm256_fmadd_ps(r00, x, _mm256_fmadd_ps(r01, y, _mm256_fmadd_ps(r02, z, r03)));
+        __m256 cameraY = _mm256_fmadd_ps(r10, x, _mm256_fmadd_ps(r11, y, _mm256_fmadd_ps(r12, z, r13)));
+        __m256 cameraZ = _mm256_fmadd_ps(r20, x, _mm256_fmadd_ps(r21, y, _mm256_fmadd_ps(r22, z, r23)));
+        __m256 scale = _mm256_div_ps(focal, cameraZ);
+        _mm256_storeu_ps(screenX + i, _mm256_fmadd_ps(cameraX, scale, halfWidth));
+        _mm256_storeu_ps(screenY + i, _mm256_fmadd_ps(cameraY, scale, halfHeight));
+        _mm256_storeu_ps(depth + i, cameraZ);
+    }
+    for (; i < count; i++) projectOne(projection, vertices[i], &screenX[i], &screenY[i], &depth[i]);
+}
+
+__attribute__((target("avx512f")))
+static void projectAvx512(const SimdProjection* projection, const float (*vertices)[4], size_t count, float* screenX,
+                          float* screenY, float* depth) {
+    const float (*rows)[4] = projection->rows;
+    __m512 r00 = _mm512_set1_ps(rows[0][0]), r01 = _mm512_set1_ps(rows[0][1]), r02 = _mm512_set1_ps(rows[0][2]), r03 = _mm512_set1_ps(rows[0][3]);
+    __m512 r10 = _mm512_set1_ps(rows[1][0]), r11 = _mm512_set1_ps(rows[1][1]), r12 = _mm512_set1_ps(rows[1][2]), r13 = _mm512_set1_ps(rows[1][3]);
+    __m512 r20 = _mm512_set1_ps(rows[2][0]), r21 = _mm512_set1_ps(rows[2][1]), r22 = _mm512_set1_ps(rows[2][2]), r23 = _mm512_set1_ps(rows[2][3]);
+    __m512 focal = _mm512_set1_ps(projection->focal);
+    __m512 halfWidth = _mm512_set1_ps(projection->halfWidth), halfHeight = _mm512_set1_ps(projection->halfHeight);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        // Same idea as AVX2 with four quarters, n, n + 4, n + 8 and n + 12 end up in one register
+        __m512 m0 = _mm512_loadu_ps(vertices[i]), m1 = _mm512_loadu_ps(vertices[i + 4]);
+        __m512 m2 = _mm512_loadu_ps(vertices[i + 8]), m3 = _mm512_loadu_ps(vertices[i + 12]);
+        __m512 even01 = _mm512_shuffle_f32x4(m0, m1, _MM_SHUFFLE(2, 0, 2, 0)); // 0 2 4 6
+        __m512 odd01 = _mm512_shuffle_f32x4(m0, m1, _MM_SHUFFLE(3, 1, 3, 1)); // 1 3 5 7
+        __m512 even23 = _mm512_shuffle_f32x4(m2, m3, _MM_SHUFFLE(2, 0, 2, 0)); // 8 10 12 14
+        __m512 odd23 = _mm512_shuffle_f32x4(m2, m3, _MM_SHUFFLE(3, 1, 3, 1)); // 9 11 13 15
+        __m512 a = _mm512_shuffle_f32x4(even01, even23, _MM_SHUFFLE(2, 0, 2, 0)); // 0 4 8 12
+        __m512 c = _mm512_shuffle_f32x4(even01, even23, _MM_SHUFFLE(3, 1, 3, 1)); // 2 6 10 14
+        __m512 b = _mm512_shuffle_f32x4(odd01, odd23, _MM_SHUFFLE(2, 0, 2, 0)); // 1 5 9 13
+        __m512 d = _mm512_shuffle_f32x4(odd01, odd23, _MM_SHUFFLE(3, 1, 3, 1)); // 3 7 11 15
+        __m512 ab = _mm512_unpacklo_ps(a, b), cd = _mm512_unpacklo_ps(c, d);
+        __m512 x = _mm512_shuffle_ps(ab, cd, _MM_SHUFFLE(1, 0, 1, 0));
+        __m512 y = _mm512_shuffle_ps(ab, cd, _MM_SHUFFLE(3, 2, 3, 2));
+        __m512 z = _mm512_shuffle_ps(_mm512_unpackhi_ps(a, b), _mm512_unpackhi_ps(c, d), _MM_SHUFFLE(1, 0, 1, 0));
+
+        __m512 cameraX = _mm512_fmadd_ps(r00, x, _mm512_fmadd_ps(r01, y, _mm512_fmadd_ps(r02, z, r03)));
+        __m512 cameraY = _mm512_fmadd_ps(r10, x, _mm512_fmadd_ps(r11, y, _mm512_fmadd_ps(r12, z, r13)));
+        __m512 cameraZ = _mm512_fmadd_ps(r20, x, _mm512_fmadd_ps(r21, y, _mm512_fmadd_ps(r22, z, r23)));
+        __m512 scale = _mm512_div_ps(focal, cameraZ);
+        _mm512_storeu_ps(screenX + i, _mm512_fmadd_ps(cameraX, scale, halfWidth));
+        _mm512_storeu_ps(screenY + i, _mm512_fmadd_ps(cameraY, scale, halfHeight));
+        _mm512_storeu_ps(depth + i, cameraZ);
+    }
+    for (; i < count; i++) projectOne(projection, vertices[i], &screenX[i], &screenY[i], &depth[i]);
+}
+
+// __builtin_cpu_supports also checks the OS saves the wider registers, not just that the CPU has them
+static int hasAvx512(void) {
+    return __builtin_cpu_supports("avx512f");
+}
+
+static int hasAvx2(void) {
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+static int hasSse2(void) {
+    return 1; // Part of x86-64
+}
+
+const SimdPath simdPaths[] = {
+    {"avx512", hasAvx512, projectAvx512},
+    {"avx2", hasAvx2, projectAvx2},
+    {"sse2", hasSse2, projectSse2},
+};
+const int simdPathCount = sizeof(simdPaths) / sizeof(simdPaths[0]);
+
+const SimdPath* simdPath = &simdPaths[sizeof(simdPaths) / sizeof(simdPaths[0]) - 1];
+SimdProjectFunction simdProject = projectSse2;
+
+const char* simdInit(const char* force) {
+    __builtin_cpu_init();
+    const SimdPath* picked = NULL;
+    for (int i = 0; i < simdPathCount; i++) {
+        if (!simdPaths[i].supported()) continue;
+        if (force && strcmp(simdPaths[i].name, force) != 0) continue;
+        picked = &simdPaths[i];
+        break;
+    }
+    if (!picked) {
+        printf("SIMD path %s isn't known or this CPU doesn't have it, picking the fastest one instead\n", force);
+        return simdInit(NULL);
+    }
+    simdPath = picked;
+    simdProject = picked->project;
+    return picked->name;
+}
@@ -0,0 +1,39 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stddef.h>
+
+// Hot kernels built for more than one instruction set in the same binary, simdInit picks the best one the CPU has
+// Everything else is built for plain x86-64 (SSE2), so one binary runs on any 64 bit CPU and still uses AVX2 or
+// AVX-512 where they're there
+// Only things that work on whole arrays are worth it, a call through a pointer costs more than one distance
+// glibc already picks its memset/memcpy by CPU the same way, so clearing and copying the framebuffer doesn't need one
+
+// Model space to screen space for one object from one camera
+typedef struct {
+    float rows[3][4]; // Model space to camera space, xyz then translation, camera space z is the distance in front
+    float focal;
+    float halfWidth, halfHeight;
+} SimdProjection;
+
+// Model space vertices (w ignored) to screen x and y plus camera space z, x and y only mean anything if z > 0
+typedef void (*SimdProjectFunction)(const SimdProjection* projection, const float (*vertices)[4], size_t count,
+                                    float* screenX, float* screenY, float* depth);
+
+typedef struct {
+    const char* name;
+    int (*supported)(void);
+    SimdProjectFunction project;
+} SimdPath;
+
+extern const SimdPath simdPaths[]; // Fastest first, the last one runs on anything
+extern const int simdPathCount;
+
+// The picked path's kernels, the SSE2 ones until simdInit runs
+extern const SimdPath* simdPath;
+extern SimdProjectFunction simdProject;
+
+// Picks the fastest path the CPU has, or the one called force if it has that, returns the picked one's name
+const char* simdInit(const char* force);
+
+#endif // SIMD_H
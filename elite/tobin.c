@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <math.h>
 #include <string.h>
+#include "mesh.h"
 
 #define DEG_TO_RAD(angle) ((angle) * M_PI / 180.0)
 #define EPSILON 1e-6  // Precision threshold for duplicate removal
@@ -13,7 +14,7 @@ typedef struct {
 
 typedef struct {
     Vertex v1, v2, v3;
-} Triangle;
+} StlTriangle;
 
 Vertex transform_vertex(Vertex v, float scale, float rx, float ry, float rz) {
     float rad_x = DEG_TO_RAD(rx);
@@ -44,7 +45,7 @@ int vertices_equal(Vertex a, Vertex b) {
     return float_equals(a.x, b.x) && float_equals(a.y, b.y) && float_equals(a.z, b.z);
 }
 
-int triangles_equal(Triangle t1, Triangle t2) {
+int triangles_equal(StlTriangle t1, StlTriangle t2) {
     Vertex t1_v[] = {t1.v1, t1.v2, t1.v3};
     Vertex t2_v[] = {t2.v1, t2.v2, t2.v3};
 
@@ -63,7 +64,7 @@ int triangles_equal(Triangle t1, Triangle t2) {
 
 // Dynamic array to store unique triangles
 typedef struct {
-    Triangle* data;
+    StlTriangle* data;
     size_t size;
     size_t capacity;
 } TriangleSet;
@@ -72,7 +73,7 @@ typedef struct {
 void init_triangle_set(TriangleSet* set) {
     set->size = 0;
     set->capacity = 100;  // Initial capacity
-    set->data = (Triangle*)malloc(set->capacity * sizeof(Triangle));
+    set->data = (StlTriangle*)malloc(set->capacity * sizeof(StlTriangle));
 }
 
 // Free memory allocated for triangle set
@@ -81,7 +82,7 @@ void free_triangle_set(TriangleSet* set) {
 }
 
 // Check if a triangle exists in the set
-int triangle_exists(TriangleSet* set, Triangle t) {
+int triangle_exists(TriangleSet* set, StlTriangle t) {
     for (size_t i = 0; i < set->size; i++) {
         if (triangles_equal(set->data[i], t)) {
             return 1;
@@ -91,17 +92,17 @@ int triangle_exists(TriangleSet* set, Triangle t) {
 }
 
 // Add a triangle to the set if it does not already exist
-void add_triangle(TriangleSet* set, Triangle t) {
+void add_triangle(TriangleSet* set, StlTriangle t) {
     if (!triangle_exists(set, t)) {
         if (set->size == set->capacity) {
             set->capacity *= 2;
-            set->data = (Triangle*)realloc(set->data, set->capacity * sizeof(Triangle));
+            set->data = (StlTriangle*)realloc(set->data, set->capacity * sizeof(StlTriangle));
         }
         set->data[set->size++] = t;
     }
 }
 
-void convert_stl_to_bin(const char* stl_filename, const char* bin_filename, float scale, float rx, float ry, float rz) {
+void convert_stl_to_bin(const char* stl_filename, const char* bin_filename, float scale, float rx, float ry, float rz, int v2) {
     FILE* stl_file = fopen(stl_filename, "rb");
     if (!stl_file) {
         printf("Failed to open STL file: %s\n", stl_filename);
@@ -155,7 +156,7 @@ void convert_stl_to_bin(const char* stl_filename, const char* bin_filename, floa
 
     for (uint32_t i = 0; i < num_triangles; i++) {
         float normal[3];
-        Triangle tri;
+        StlTriangle tri;
 
         fread(normal, sizeof(float), 3, stl_file);
 
@@ -180,23 +181,66 @@ void convert_stl_to_bin(const char* stl_filename, const char* bin_filename, floa
 
     printf("Unique triangles count: %zu\n", unique_triangles.size);
 
-    for (size_t i = 0; i < unique_triangles.size; i++) {
-        fwrite(&unique_triangles.data[i], sizeof(Triangle), 1, bin_file);
+    if (v2) {
+        // Same memory layout as the engine's Triangle, 9 floats
+        fclose(bin_file);
+        bin_file = NULL;
+        if (writeMeshFile(bin_filename, (const Triangle*)unique_triangles.data, unique_triangles.size) != 0) {
+            free_triangle_set(&unique_triangles);
+            fclose(stl_file);
+            return;
+        }
+    } else {
+        for (size_t i = 0; i < unique_triangles.size; i++) {
+            fwrite(&unique_triangles.data[i], sizeof(StlTriangle), 1, bin_file);
+        }
     }
 
     free_triangle_set(&unique_triangles);
     fclose(stl_file);
-    fclose(bin_file);
+    if (bin_file) fclose(bin_file);
 
     printf("Successfully converted STL to binary with unique triangles: %s\n", bin_filename);
 }
 
+// Converts a legacy headerless .bin to the v2 format
+void upgrade_bin(const char* old_filename, const char* new_filename) {
+    FILE* old_file = fopen(old_filename, "rb");
+    if (!old_file) {
+        printf("Failed to open binary file: %s\n", old_filename);
+        return;
+    }
+    fseek(old_file, 0, SEEK_END);
+    size_t file_size = ftell(old_file);
+    rewind(old_file);
+
+    size_t triangle_count = file_size / sizeof(Triangle);
+    Triangle* triangles = (Triangle*)malloc(triangle_count * sizeof(Triangle) + 1);
+    if (!triangles || fread(triangles, sizeof(Triangle), triangle_count, old_file) != triangle_count) {
+        printf("Failed to read binary file: %s\n", old_filename);
+        free(triangles);
+        fclose(old_file);
+        return;
+    }
+    fclose(old_file);
+
+    if (writeMeshFile(new_filename, triangles, triangle_count) == 0) {
+        printf("Upgraded %zu triangles to v2: %s\n", triangle_count, new_filename);
+    }
+    free(triangles);
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 7) {
-        printf("Usage: %s input.stl output.bin scale rotation_x rotation_y rotation_z\n", argv[0]);
+    if (argc == 4 && strcmp(argv[1], "--upgrade") == 0) {
+        upgrade_bin(argv[2], argv[3]);
+        return 0;
+    }
+    if (argc != 7 && !(argc == 8 && strcmp(argv[7], "--v2") == 0)) {
+        printf("Usage: %s input.stl output.bin scale rotation_x rotation_y rotation_z [--v2]\n", argv[0]);
+        printf("       %s --upgrade old.bin new.bin\n", argv[0]);
         return 1;
     }
 
-    convert_stl_to_bin(argv[1], argv[2], atof(argv[3]), atof(argv[4]), atof(argv[5]), atof(argv[6]));
+    convert_stl_to_bin(argv[1], argv[2], atof(argv[3]), atof(argv[4]), atof(argv[5]), atof(argv[6]), argc == 8);
     return 0;
 }